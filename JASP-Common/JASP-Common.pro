@@ -25,16 +25,30 @@ SOURCES += \
 	column.cpp \
   columnencoder.cpp \
 	columns.cpp \
-	datablock.cpp \
+	columnbuffer.cpp \
+	columndescriptives.cpp \
+	columnencoding.cpp \
+	columnsketches.cpp \
+	columnsortindex.cpp \
+	columnstats.cpp \
+	columntypeconverter.cpp \
 	dataset.cpp \
+	datasetchanges.cpp \
+	datasetsizeplanner.cpp \
+	datasetversions.cpp \
+	filterbitmap.cpp \
 	dirs.cpp \
 	filereader.cpp \
 	ipcchannel.cpp \
+	ipcmessage.cpp \
+	ipcring.cpp \
 	label.cpp \
 	labels.cpp \
+	missingvalues.cpp \
 	processinfo.cpp \
 	r_functionwhitelist.cpp \
 	sharedmemory.cpp \
+	stringpool.cpp \
 	tempfiles.cpp \
     utilenums.cpp \
 	utils.cpp \
@@ -62,18 +76,32 @@ HEADERS += \
   columnencoder.h \
 	columns.h \
 	common.h \
-	datablock.h \
+	columnbuffer.h \
+	columndescriptives.h \
+	columnencoding.h \
+	columnsketches.h \
+	columnsortindex.h \
+	columnstats.h \
+	columntypeconverter.h \
 	dataset.h \
+	datasetchanges.h \
+	datasetsizeplanner.h \
+	datasetversions.h \
+	filterbitmap.h \
 	dirs.h \
 	filereader.h \
 	ipcchannel.h \
+	ipcmessage.h \
+	ipcring.h \
 	label.h \
 	labels.h \
+	missingvalues.h \
 	libzip/archive.h \
 	libzip/archive_entry.h \
 	processinfo.h \
 	r_functionwhitelist.h \
 	sharedmemory.h \
+	stringpool.h \
 	tempfiles.h \
     utilenums.h \
 	utils.h \
@@ -0,0 +1,145 @@
+//
+// Copyright (C) 2013-2018 University of Amsterdam
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+/*
+ * Compares what it costs to get a message from one side of an IPCChannel to the other, the channel itself left out:
+ * the way it used to go, with toStyledString and parsing that on the other side, against an IPCMessage.
+ * The message is an analysis reply with a results table of as many rows as you like, for instance:
+ *
+ *    ipcmessagebench 20000 50		(rows, repetitions)
+ *
+ * It is measured twice, once starting from a Json::Value (what the Desktop sends) and once from the string
+ * that comes out of R (what the Engine sends), which the Engine used to parse and write out styled before sending.
+ */
+
+#include "ipcmessage.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+static Json::Value analysisReply(int rows)
+{
+	Json::Value reply(Json::objectValue),
+				table(Json::objectValue),
+				fields(Json::arrayValue),
+				data(Json::arrayValue);
+
+	for(const char * name : { "case", "group", "mean", "sd", "se", "p" })
+	{
+		Json::Value field(Json::objectValue);
+		field["name"]	= name;
+		field["title"]	= name;
+		field["type"]	= std::string(name) == "group" ? "string" : "number";
+		fields.append(field);
+	}
+
+	for(int row = 0; row < rows; row++)
+	{
+		Json::Value cells(Json::objectValue);
+		cells["case"]	= row + 1;
+		cells["group"]	= "group " + std::to_string(row % 7);
+		cells["mean"]	= 3.14159265 * row;
+		cells["sd"]		= 1.0 / (row + 1);
+		cells["se"]		= 0.5 / (row + 1);
+		cells["p"]		= row % 3 == 0 ? Json::Value("< .001") : Json::Value(0.042);
+		data.append(cells);
+	}
+
+	table["title"]				= "Descriptive Statistics";
+	table["schema"]["fields"]	= fields;
+	table["data"]				= data;
+
+	reply["typeRequest"]		= "analysis";
+	reply["id"]					= 1;
+	reply["revision"]			= 1;
+	reply["status"]				= "complete";
+	reply["results"]["table"]	= table;
+
+	return reply;
+}
+
+///Runs once to warm up and then repetitions times, gives the median in milliseconds
+static double medianMs(int repetitions, std::function<void()> sendAndReceive)
+{
+	std::vector<double> times;
+
+	sendAndReceive();
+
+	for(int i = 0; i < repetitions; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		sendAndReceive();
+		times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	std::sort(times.begin(), times.end());
+
+	return times[times.size() / 2];
+}
+
+static void report(const std::string & what, size_t bytes, double ms)
+{
+	std::cout << std::left << std::setw(44) << what << std::right << std::setw(12) << bytes << " bytes" << std::setw(12) << std::fixed << std::setprecision(2) << ms << " ms" << std::endl;
+}
+
+int main(int argc, char * argv[])
+{
+	int rows		= argc > 1 ? std::stoi(argv[1]) : 20000,
+		repetitions	= argc > 2 ? std::stoi(argv[2]) : 25;
+
+	const Json::Value	reply		= analysisReply(rows);
+	const std::string	fromR		= Json::FastWriter().write(reply);
+	std::string			styled		= reply.toStyledString(),
+						framed		= IPCMessage::encode(reply);
+	Json::Value			received;
+
+	std::cout << "An analysis reply with " << rows << " rows, median of " << repetitions << " repetitions" << std::endl;
+
+	report("Json::Value, toStyledString and parse", styled.size(), medianMs(repetitions, [&]()
+	{
+		styled = reply.toStyledString();
+		Json::Reader().parse(styled, received, false);
+	}));
+
+	report("Json::Value, IPCMessage encode and decode", framed.size(), medianMs(repetitions, [&]()
+	{
+		framed = IPCMessage::encode(reply);
+		if(!IPCMessage::decode(framed, received).parsed)
+			throw std::runtime_error("The IPCMessage didn't decode");
+	}));
+
+	report("R string, parse, toStyledString and parse", styled.size(), medianMs(repetitions, [&]()
+	{
+		Json::Value parsed;
+		Json::Reader().parse(fromR, parsed, false);
+		styled = parsed.toStyledString();
+		Json::Reader().parse(styled, received, false);
+	}));
+
+	report("R string, IPCMessage encode and decode", framed.size(), medianMs(repetitions, [&]()
+	{
+		framed = IPCMessage::encode(fromR, int32_t(engineState::analysis));
+		if(!IPCMessage::decode(framed, received).parsed)
+			throw std::runtime_error("The IPCMessage didn't decode");
+	}));
+
+	return 0;
+}
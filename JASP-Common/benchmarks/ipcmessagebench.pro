@@ -0,0 +1,29 @@
+#Not part of the normal build, to get it: qmake CONFIG+=jasp_benchmarks JASP.pro
+
+QT -= gui
+QT -= core
+
+include(../../JASP.pri)
+
+CONFIG += c++11
+CONFIG += cmdline
+CONFIG -= app_bundle
+
+DESTDIR = ../..
+TARGET = ipcmessagebench
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/..
+
+#Only what IPCMessage needs, so the benchmark doesn't have to link against everything JASP-Common does
+SOURCES += \
+	ipcmessagebench.cpp \
+	../ipcmessage.cpp \
+	../enginedefinitions.cpp
+
+contains(DEFINES, JASP_LIBJSON_STATIC) {
+	SOURCES += \
+		../lib_json/json_reader.cpp \
+		../lib_json/json_value.cpp \
+		../lib_json/json_writer.cpp
+}
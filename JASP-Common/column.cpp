@@ -16,7 +16,9 @@
 //
 
 #include "column.h"
+#include <stdexcept>
 #include "utils.h"
+#include "columntypeconverter.h"
 
 
 #include <sstream>
@@ -25,6 +27,8 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <cmath>
+#include <algorithm>
+#include <cstring>
 #include "log.h"
 
 using namespace boost::interprocess;
@@ -40,15 +44,94 @@ Column &Column::operator=(const Column &column)
 	if (&column != this)
 	{
 		this->_name = column._name;
-		this->_rowCount = column._rowCount;
 		this->_columnType = column._columnType;
-		this->_blocks = column._blocks;
+		this->_data = column._data;
 		this->_labels = column._labels;
+		this->_stats = column._stats;
+		this->_missing = column._missing;
+		if (this->_derived) this->_derived->sketches.invalidate();
+		this->_contentVersion++; //Our sort index is of the old values
 	}
 
 	return *this;
 }
 
+Column &Column::operator=(Column &&column)
+{
+	if (&column != this)
+	{
+		this->_name = std::move(column._name);
+		this->_columnType = column._columnType;
+		this->_data = std::move(column._data);
+		this->_labels = std::move(column._labels);
+		this->_stats = column._stats;
+		this->_missing = std::move(column._missing);
+		_dropDerived();
+		this->_derived = column._derived;
+		column._derived = nullptr;
+		this->_contentVersion = column._contentVersion;
+		this->_id = column._id;
+
+		_dropAllVersions();
+		this->_epoch = column._epoch;
+		this->_olderVersion = column._olderVersion;
+		column._olderVersion = nullptr;
+	}
+
+	return *this;
+}
+
+const Column & Column::version(DataSetVersions::Epoch epoch) const
+{
+	for(const Column * version = this; version; version = version->_olderVersion.get())
+		if(version->_epoch <= epoch)
+			return *version;
+
+	return *this; //Nothing is old enough, which only happens for a reader that was not pinned when the versions were dropped
+}
+
+void Column::_keepVersion(DataSetVersions::Epoch newEpoch)
+{
+	//Copy first, this throws boost::interprocess::bad_alloc when the segment is full and then nothing changed yet
+	Column * snapshot			= _data.segment()->construct<Column>(boost::interprocess::anonymous_instance)(*this);
+
+	snapshot->_olderVersion		= _olderVersion;
+	_olderVersion				= snapshot;
+	_epoch						= newEpoch;
+}
+
+void Column::_dropUnseenVersions(const DataSetVersions & versions)
+{
+	//A snapshot is seen by readers pinned from its own epoch up to the epoch of the version written after it
+	Column * newer = this;
+
+	while(newer->_olderVersion)
+	{
+		Column * older = newer->_olderVersion.get();
+
+		if(versions.pinnedBetween(older->_epoch, newer->_epoch))
+			newer = older;
+		else
+		{
+			newer->_olderVersion	= older->_olderVersion;
+			older->_olderVersion	= nullptr;
+			_data.segment()->destroy_ptr(older);
+		}
+	}
+}
+
+void Column::_dropAllVersions()
+{
+	while(_olderVersion)
+	{
+		Column * older	= _olderVersion.get();
+		_olderVersion	= older->_olderVersion;
+
+		older->_olderVersion = nullptr;
+		_data.segment()->destroy_ptr(older);
+	}
+}
+
 Labels &Column::labels()
 {
 	return _labels;
@@ -73,117 +156,117 @@ void Column::_convertVectorIntToDouble(vector<int> &intValues, vector<double> &d
 
 }
 
-bool Column::_resetEmptyValuesForNominal(std::map<int, string> &emptyValuesMap)
+bool Column::_resetEmptyValuesForNominal(std::map<size_t, string> &emptyValuesMap)
 {
-	bool hasChanged = false;
-	std::map<int, string> emptyValuesMapOrg = emptyValuesMap;
-	int row = 0;
-	bool hasEmptyValues = !emptyValuesMap.empty();
-	bool changeToNominalText = false;
-	Ints::iterator ints = AsInts.begin();
-	Ints::iterator end = AsInts.end();
+	bool	hasChanged	= false;
+	int	*	ints		= _data.ints();
 
-	set<int> uniqueValues = _labels.getIntValues();
+	std::map<size_t, int>	comingBack;
 
-	for (; ints != end; ints++)
+	// A row that was empty can only get a value again through its original token, so those are all that need to be checked
+	for (const auto & rowToken : emptyValuesMap)
 	{
-		int intValue = *ints;
-		if (intValue == INT_MIN && hasEmptyValues)
-		{
-			auto search = emptyValuesMap.find(row);
-			if (search != emptyValuesMap.end())
-			{
-				string orgValue = search->second;
-				if (!Utils::isEmptyValue(orgValue))
-				{
-					// This value is not empty anymore
-					if (Utils::getIntValue(orgValue, intValue))
-					{
-						*ints = intValue;
-						uniqueValues.insert(intValue);
-						hasChanged = true;
-						emptyValuesMap.erase(search);
-					}
-					else
-					{
-						// The original value is not an integer, this column cannot be nominal anymore
-						// Let's make it a nominal text.
-						changeToNominalText = true;
-						break;
-					}
-				}
-			}
-		}
-		else if (intValue != INT_MIN && Utils::isEmptyValue(intValue))
+		size_t	row = rowToken.first;
+		int		intValue;
+
+		if (row >= rowCount() || ints[row] != INT_MIN || Utils::isEmptyValue(rowToken.second))
+			continue;
+
+		if (!Utils::getIntValue(rowToken.second, intValue))
 		{
-			// This value is now considered as empty
-			*ints = INT_MIN;
-			uniqueValues.erase(intValue);
-			hasChanged = true;
-			std::ostringstream strs;
-			strs << intValue;
-			emptyValuesMap.insert(make_pair(row, strs.str()));
+			// The original value is not an integer, this column cannot be nominal anymore
+			// Let's make it a nominal text.
+			setColumnType(columnType::nominalText);
+			return _resetEmptyValuesForNominalText(emptyValuesMap, false);
 		}
-		row++;
+
+		comingBack[row] = intValue;
 	}
 
-	if (changeToNominalText)
+	set<int> uniqueValues = _labels.getIntValues();
+
+	for (const auto & rowValue : comingBack)
 	{
-		setColumnType(columnType::nominalText);
-		emptyValuesMap.clear();
-		emptyValuesMap.insert(emptyValuesMapOrg.begin(), emptyValuesMapOrg.end());
-		hasChanged = _resetEmptyValuesForNominalText(emptyValuesMap, false);
+		ints[rowValue.first] = rowValue.second;
+		uniqueValues.insert(rowValue.second);
+		emptyValuesMap.erase(rowValue.first);
+		hasChanged = true;
 	}
-	else if (hasChanged)
+
+	// A value can only have become empty if its label did, and only then the rows need to be scanned
+	set<int> emptyNow;
+	for (int value : uniqueValues)
+		if (Utils::isEmptyValue(value))
+			emptyNow.insert(value);
+
+	if (!emptyNow.empty())
+	{
+		for (size_t row = 0; row < rowCount(); row++)
+			if (ints[row] != INT_MIN && emptyNow.count(ints[row]))
+			{
+				// This value is now considered as empty
+				emptyValuesMap.insert(make_pair(row, std::to_string(ints[row])));
+				ints[row] = INT_MIN;
+			}
+
+		for (int value : emptyNow)
+			uniqueValues.erase(value);
+
+		hasChanged = true;
+	}
+
+	if (hasChanged)
 		_labels.syncInts(uniqueValues);
 
 	return hasChanged;
 }
 
-bool Column::_resetEmptyValuesForScale(std::map<int, string> &emptyValuesMap)
+bool Column::_resetEmptyValuesForScale(std::map<size_t, string> &emptyValuesMap)
 {
-	bool hasChanged = false;
-	int row = 0;
-	bool hasEmptyValues = !emptyValuesMap.empty();
-	bool changeToNominalText = false;
-	Doubles::iterator doubles = AsDoubles.begin();
-	Doubles::iterator end = AsDoubles.end();
+	bool		hasChanged			= false,
+				changeToNominalText	= false;
+	double	*	doubles				= _data.doubles();
 
-	for (; doubles != end; doubles++)
+	std::map<size_t, double>	comingBack;
+
+	// A row that was empty can only get a value again through its original token, so those are all that need to be checked
+	for (const auto & rowToken : emptyValuesMap)
 	{
-		double doubleValue = *doubles;
-		if (std::isnan(doubleValue) && hasEmptyValues)
+		double doubleValue;
+
+		if (rowToken.first >= rowCount() || !std::isnan(doubles[rowToken.first]) || Utils::isEmptyValue(rowToken.second))
+			continue;
+
+		if (!Utils::getDoubleValue(rowToken.second, doubleValue))
 		{
-			auto search = emptyValuesMap.find(row);
-			if (search != emptyValuesMap.end())
-			{
-				string orgValue = search->second;
-				if (!Utils::isEmptyValue(orgValue))
-				{
-					// This value is not empty anymore
-					if (Utils::getDoubleValue(orgValue, doubleValue))
-					{
-						*doubles = doubleValue;
-						hasChanged = true;
-					}
-					else
-					{
-						changeToNominalText = true;
-						break;
-					}
-				}
-			}
+			changeToNominalText = true;
+			break;
 		}
-		else if (!std::isnan(doubleValue) && Utils::isEmptyValue(doubleValue))
+
+		comingBack[rowToken.first] = doubleValue;
+	}
+
+	if (!changeToNominalText)
+	{
+		for (const auto & rowValue : comingBack)
 		{
-			// This value is now considered as empty
-			*doubles = NAN;
+			doubles[rowValue.first] = rowValue.second;
+			emptyValuesMap.erase(rowValue.first);
 			hasChanged = true;
-			std::ostringstream strs;
-			strs << doubleValue;
-			emptyValuesMap.insert(make_pair(row, strs.str()));
 		}
-		row++;
+
+		// Only the empty values that are numbers can make a value empty, usually there are none of those and nothing needs to be scanned
+		if (!Utils::getDoubleEmptyValues().empty())
+			for (size_t r = 0; r < rowCount(); r++)
+				if (!std::isnan(doubles[r]) && Utils::isEmptyValue(doubles[r]))
+				{
+					// This value is now considered as empty
+					std::ostringstream strs;
+					strs << doubles[r];
+					emptyValuesMap.insert(make_pair(r, strs.str()));
+					doubles[r] = NAN;
+					hasChanged = true;
+				}
 	}
 
 	if (changeToNominalText)
@@ -191,32 +274,21 @@ bool Column::_resetEmptyValuesForScale(std::map<int, string> &emptyValuesMap)
 		// Cannot use _resetEmptyValuesForNominalText since the AsInts are not set.
 		// So use setColumnAsNominalText
 		vector<string> values;
-		row = 0;
-		for (doubles = AsDoubles.begin(); doubles != end; doubles++)
+		for (size_t row = 0; row < rowCount(); row++)
 		{
-			double doubleValue = *doubles;
-			if (std::isnan(doubleValue))
+			if (std::isnan(doubles[row]))
 			{
 				auto search = emptyValuesMap.find(row);
-				if (search != emptyValuesMap.end())
-				{
-					string orgValue = search->second;
-					values.push_back(orgValue);
-				}
-				else
-				{
-					values.push_back(Utils::emptyValue);
-				}
+				values.push_back(search != emptyValuesMap.end() ? search->second : Utils::emptyValue);
 			}
 			else
 			{
 				std::ostringstream strValue;
-				strValue << doubleValue;
+				strValue << doubles[row];
 				values.push_back(strValue.str());
 			}
-			row++;
 		}
-		map<int, string> newEmptyValues = setColumnAsNominalText(values);
+		map<size_t, string> newEmptyValues = setColumnAsNominalText(values);
 		emptyValuesMap.clear();
 		emptyValuesMap.insert(newEmptyValues.begin(), newEmptyValues.end());
 		hasChanged = true;
@@ -226,13 +298,14 @@ bool Column::_resetEmptyValuesForScale(std::map<int, string> &emptyValuesMap)
 }
 
 //This function is pretty hard to read...
-bool Column::_resetEmptyValuesForNominalText(std::map<int, string> &emptyValuesMap, bool tryToConvert)
+bool Column::_resetEmptyValuesForNominalText(std::map<size_t, string> &emptyValuesMap, bool tryToConvert)
 {
 	bool				hasChanged		= false;
-	int					row				= 0;
+	size_t				row				= 0;
 	bool				hasEmptyValues	= !emptyValuesMap.empty();
-	Ints::iterator		ints			= AsInts.begin();
-	Ints::iterator		end				= AsInts.end();
+	const Ints		&	asInts			= AsInts;	//Only reads them, so a packed column doesn't get unpacked for that
+	Ints::const_iterator	ints			= asInts.begin(),
+							end				= asInts.end();
 	vector<string>		values;
 	vector<int>			intValues;
 	vector<double>		doubleValues;
@@ -421,7 +494,7 @@ bool Column::_resetEmptyValuesForNominalText(std::map<int, string> &emptyValuesM
 	}
 	else if (hasChanged)
 	{
-		map<int, string> newEmptyValues = setColumnAsNominalText(values);
+		map<size_t, string> newEmptyValues = setColumnAsNominalText(values);
 		emptyValuesMap.clear();
 		emptyValuesMap.insert(newEmptyValues.begin(), newEmptyValues.end());
 	}
@@ -430,167 +503,75 @@ bool Column::_resetEmptyValuesForNominalText(std::map<int, string> &emptyValuesM
 
 }
 
-bool Column::resetEmptyValues(std::map<int, string> &emptyValuesMap)
+bool Column::resetEmptyValues()
 {
+	if (!_emptyValuesMightChange())
+		return false;
+
+	_valuesChanged();
+
+	std::map<size_t, string>	emptyValuesMap = _missing.tokensAsMap();
+	bool					changed;
+
 	switch(_columnType)
 	{
 	case columnType::ordinal:
-	case columnType::nominal:	return _resetEmptyValuesForNominal(emptyValuesMap);
-	case columnType::scale:		return _resetEmptyValuesForScale(emptyValuesMap);
-	default:					return _resetEmptyValuesForNominalText(emptyValuesMap);
+	case columnType::nominal:	changed = _resetEmptyValuesForNominal(emptyValuesMap);		break;
+	case columnType::scale:		changed = _resetEmptyValuesForScale(emptyValuesMap);		break;
+	default:					changed = _resetEmptyValuesForNominalText(emptyValuesMap);	break;
 	}
-}
 
-void Column::setSharedMemory(managed_shared_memory *mem)
-{
-	_mem = mem;
-	_labels.setSharedMemory(mem);
-}
+	_missing.setTokens(emptyValuesMap);
 
-columnType Column::getColumnType() const
-{
-	return _columnType;
+	return changed;
 }
 
-bool Column::_changeColumnToNominalOrOrdinal(enum columnType newColumnType)
+bool Column::_emptyValuesMightChange() const
 {
-	if (_columnType == columnType::nominal || _columnType == columnType::ordinal)
-	{
-		_columnType = newColumnType;
-		return true;
-	}
-
-	if (_columnType == columnType::nominalText)
-	{
-		std::vector<int>			values;
-		std::set<int>				uniqueIntValues;
-		std::map<int, std::string>	intLabels;
-
-		for (int key : AsInts)
-		{
-			int intValue = INT_MIN;
-
-			if (key != INT_MIN)
-			{
-				std::string value = _labels.getValueFromKey(key);
-				if (!Utils::isEmptyValue(value) && !Utils::getIntValue(value, intValue))
-					break;
-			}
-
-			values.push_back(intValue);
-
-			if (intValue != INT_MIN)
-			{
-				if (uniqueIntValues.find(intValue) != uniqueIntValues.end())
-				{
-					std::string label = _getLabelFromKey(key);
-					uniqueIntValues.insert(intValue);
-					intLabels.insert(make_pair(intValue, label));
-				}
-			}
-		}
-
-		if (values.size() == rowCount())
-		{
-			_labels.clear();
-			setColumnAsNominalOrOrdinal(values, intLabels, newColumnType == columnType::ordinal);
+	for (const MissingValues::Token & token : _missing.tokens())
+		if (!Utils::isEmptyValue(token.text.str()))
 			return true;
-		}
 
-		// nominalText to nominal: we could not make the values as integers, but
-		// the column can still stay a NominalText, so it is not a failure.
-		return newColumnType == columnType::nominal;
-	}
-	else if (_columnType == columnType::scale)
+	switch(_columnType)
 	{
-		std::vector<int>	values;
-
-		for (double doubleValue : AsDoubles)
-		{
-			int intValue = INT_MIN;
-
-			if (!Utils::isEmptyValue(doubleValue) && !Utils::getIntValue(doubleValue, intValue))
-				break;
-
-			values.push_back(intValue);
-		}
-
-		if (values.size() == rowCount())
-		{
-			setColumnAsNominalOrOrdinal(values, newColumnType == columnType::ordinal);
-			return true;
-		}
-		else if (newColumnType == columnType::nominal)
-		{
-			std::vector<string> values;
+	case columnType::scale:
+		return !Utils::getDoubleEmptyValues().empty();
 
-			for (double doubleValue : AsDoubles)
-				if (std::isnan(doubleValue))	values.push_back(Utils::emptyValue);
-				else							values.push_back(Utils::doubleToString(doubleValue));
+	case columnType::ordinal:
+	case columnType::nominal:
+		for (const Label & label : _labels)
+			if (Utils::isEmptyValue(label.value()))
+				return true;
+		return false;
 
-			setColumnAsNominalText(values);
-			return true;
-		}
+	default:
+		for (const Label & label : _labels)
+			if (Utils::isEmptyValue(_labels.getValueFromKey(label.value())))
+				return true;
+		return false;
 	}
-
-	return false;
 }
 
-bool Column::_changeColumnToScale()
+void Column::setSharedMemory(managed_shared_memory::segment_manager *mem)
 {
-	std::vector<double> values;
-
-	switch(_columnType)
-	{
-	case columnType::nominal:
-	case columnType::ordinal:
-		for (int intValue : AsInts)
-		{
-			double doubleValue = NAN;
-
-			if (intValue != INT_MIN && !Utils::isEmptyValue(intValue))
-				doubleValue = double(intValue);
-
-			values.push_back(doubleValue);
-		}
-		break;
-
-	case columnType::nominalText:
-
-		for (int key : AsInts)
-		{
-			double	doubleValue = NAN;
-			bool	converted	= false;
-
-			if (key != INT_MIN)
-			{
-				string value = _labels.getValueFromKey(key);
-				if (!Utils::isEmptyValue(value))
-					converted = Utils::getDoubleValue(value, doubleValue);
-			}
-			else
-				converted = true; //Because if key == INT_MIN then it is missing value
-
-			if (converted)	values.push_back(doubleValue);
-			else			return false;
-		}
-		break;
-	}
+	_mem = mem;
+	_labels.setSharedMemory(mem);
+}
 
-	setColumnAsScale(values);
-	return true;
+columnType Column::getColumnType() const
+{
+	return _columnType;
 }
 
 bool Column::changeColumnType(enum columnType newColumnType)
 {
-	if (newColumnType == _columnType)		return true;
-	if (newColumnType == columnType::scale)	return _changeColumnToScale();
-											return _changeColumnToNominalOrOrdinal(newColumnType);
+	return ColumnTypeConverter::apply(*this, ColumnTypeConverter::convert(*this, newColumnType));
 }
 
 bool Column::overwriteDataWithScale(std::vector<double> scalarData)
 {
 	labels().clear();
+	_missing.clearTokens(); //New values, so what was in the file is gone
 
 	size_t setVals = scalarData.size();
 
@@ -606,6 +587,7 @@ bool Column::overwriteDataWithScale(std::vector<double> scalarData)
 bool Column::overwriteDataWithOrdinal(std::vector<int> ordinalData, std::map<int, std::string> levels)
 {
 	labels().clear();
+	_missing.clearTokens(); //New values, so what was in the file is gone
 
 	size_t setVals = ordinalData.size();
 
@@ -621,6 +603,7 @@ bool Column::overwriteDataWithOrdinal(std::vector<int> ordinalData, std::map<int
 bool Column::overwriteDataWithOrdinal(std::vector<int> ordinalData)
 {
 	labels().clear();
+	_missing.clearTokens(); //New values, so what was in the file is gone
 
 	size_t setVals = ordinalData.size();
 
@@ -636,6 +619,7 @@ bool Column::overwriteDataWithOrdinal(std::vector<int> ordinalData)
 bool Column::overwriteDataWithNominal(std::vector<int> nominalData, std::map<int, std::string> levels)
 {
 	labels().clear();
+	_missing.clearTokens(); //New values, so what was in the file is gone
 
 	size_t setVals = nominalData.size();
 
@@ -651,6 +635,7 @@ bool Column::overwriteDataWithNominal(std::vector<int> nominalData, std::map<int
 bool Column::overwriteDataWithNominal(std::vector<int> nominalData)
 {
 	labels().clear();
+	_missing.clearTokens(); //New values, so what was in the file is gone
 
 	size_t setVals = nominalData.size();
 
@@ -666,6 +651,7 @@ bool Column::overwriteDataWithNominal(std::vector<int> nominalData)
 bool Column::overwriteDataWithNominal(std::vector<std::string> nominalData)
 {
 	labels().clear();
+	_missing.clearTokens(); //New values, so what was in the file is gone
 
 	if(nominalData.size() != rowCount())
 		nominalData.resize(rowCount());
@@ -724,87 +710,73 @@ bool Column::setColumnAsNominalOrOrdinal(const vector<int> &values, map<int, str
 
 bool Column::_setColumnAsNominalOrOrdinal(const vector<int> &values, bool is_ordinal)
 {
-	Ints::iterator	intInputItr			= AsInts.begin();
-	size_t			nb_values			= 0;
-	bool			changedSomething	= false;
-
-	for(int value : values)
-	{
-		if(intInputItr == AsInts.end())
-			throw std::runtime_error("Column::_setColumnAsNominalOrOrdinal ran out of Ints in assigning..");
+	setColumnType(is_ordinal ? columnType::ordinal : columnType::nominal);
 
-		if(*intInputItr != value)
-			changedSomething = true;
+	return _setInts(values, "Column::_setColumnAsNominalOrOrdinal");
+}
 
-		*intInputItr = value;
-		intInputItr++;
-		nb_values++;
-	}
+bool Column::_setInts(const std::vector<int> &values, const char * caller)
+{
+	if (values.size() > rowCount())
+		throw std::runtime_error(std::string(caller) + " ran out of Ints in assigning..");
 
-	while (nb_values < _rowCount)
-	{
-		if(*intInputItr != INT_MIN)
-			changedSomething = true;
+	std::vector<int>	decoded;
+	const int		*	old					= intValues(decoded);
+	bool				changedSomething	= !std::equal(values.begin(), values.end(), old) || std::any_of(old + values.size(), old + rowCount(), [](int value) { return value != INT_MIN; });
 
-		*intInputItr = INT_MIN;
-		intInputItr++;
-		nb_values++;
-	}
+	if (!changedSomething)
+		return false; //Not writing keeps them packed or shared
 
-	setColumnType(is_ordinal ? columnType::ordinal : columnType::nominal);
+	setValues(0, values.data(), values.size());
+	std::fill(_data.ints() + values.size(), _data.ints() + rowCount(), INT_MIN);
 
 	return changedSomething;
-
 }
 
 bool Column::setColumnAsScale(const std::vector<double> &values)
 {
 	bool changedSomething = false;
 	//_labels.clear(); //Don't clear the labels otherwise they will be lost if we do something like ordinal -> scale -> ordinal
-	Doubles::iterator doubleInputItr = AsDoubles.begin();
+	setColumnType(columnType::scale);
 
-	for(double value : values)
-	{
-		if(doubleInputItr == AsDoubles.end())
-			throw std::runtime_error("Column::setColumnAsScale ran out of Doubles in assigning..");
+	if (values.size() > rowCount())
+		throw std::runtime_error("Column::setColumnAsScale ran out of Doubles in assigning..");
 
-		//Apparently checking a double can lead to a problem if they are both nan because nan != nan -> true
-		bool valChanged = (isnan(*doubleInputItr) != isnan(value));
+	const double * old = doubleValues();
 
-		if(!valChanged && !isnan(value)) //So if they are equally nan and one is not nan they must both have a sensible value which can be compared and otherwise there was already a change
-			valChanged = *doubleInputItr != value;
+	for (size_t row = 0; row < values.size() && !changedSomething; row++)
+	{
+		//Apparently checking a double can lead to a problem if they are both nan because nan != nan -> true
+		bool valChanged = (isnan(old[row]) != isnan(values[row]));
 
-		/*std::cout << "Old value was: '" << *doubleInputItr << "'\t new: '" << value <<
-					 "'\tand are they nan? old: " << (isnan(*doubleInputItr) ? "nan": "not") << " new: " << (isnan(*doubleInputItr) ? "nan": "not") <<
-					 " considered changed: " << (valChanged ? "yes" : "no") << std::endl;*/
+		if(!valChanged && !isnan(values[row])) //So if they are equally nan and one is not nan they must both have a sensible value which can be compared and otherwise there was already a change
+			valChanged = old[row] != values[row];
 
 		if(valChanged)
 			changedSomething = true;
-
-		*doubleInputItr = value;
-		doubleInputItr++;
 	}
 
-	std::cout << "So the entire column had a change? " << (changedSomething ? "yes" : "no" ) << std::endl;
+	if (changedSomething) //Not writing keeps them shared
+		setValues(0, values.data(), values.size());
 
-	setColumnType(columnType::scale);
+	std::cout << "So the entire column had a change? " << (changedSomething ? "yes" : "no" ) << std::endl;
 
 	return changedSomething;
 }
 
-std::map<int, std::string> Column::setColumnAsNominalText(const std::vector<std::string> &values, bool * changedSomething)
+std::map<size_t, std::string> Column::setColumnAsNominalText(const std::vector<std::string> &values, bool * changedSomething)
 {
 	return setColumnAsNominalText(values, std::map<std::string, std::string>(), changedSomething);
 }
 
-std::map<int, std::string> Column::setColumnAsNominalText(const std::vector<std::string> &values, const std::map<std::string, std::string>&labels, bool * changedSomething)
+std::map<size_t, std::string> Column::setColumnAsNominalText(const std::vector<std::string> &values, const std::map<std::string, std::string>&labels, bool * changedSomething)
 {
 	if(changedSomething != nullptr)
 		*changedSomething = false;
 
-	std::map<int, std::string>	emptyValuesMap;
-	std::set<std::string>		cases(values.begin(), values.end());
-	std::vector<std::string>	sortedCases(cases.begin(), cases.end());
+	std::map<size_t, std::string>	emptyValuesMap;
+	std::set<std::string>			cases(values.begin(), values.end());
+	std::vector<std::string>		sortedCases(cases.begin(), cases.end());
 
 	std::sort(sortedCases.begin(), sortedCases.end());
 
@@ -812,49 +784,37 @@ std::map<int, std::string> Column::setColumnAsNominalText(const std::vector<std:
 
 	std::map<std::string, int> map = _labels.syncStrings(sortedCases, labels, changedSomething);
 
-	auto	intInputItr = AsInts.begin();
-	int		nb_values	= 0;
+	setColumnType(columnType::nominalText);
 
-	for(const std::string &value : values)
+	if (values.size() > rowCount())
+		throw std::runtime_error("Column::setColumnAsNominalText ran out of Ints in assigning..");
+
+	std::vector<int> keys(values.size(), INT_MIN);
+
+	for (size_t row = 0; row < values.size(); row++)
 	{
-		if(intInputItr == AsInts.end())
-			throw std::runtime_error("Column::setColumnAsNominalText ran out of Ints in assigning..");
+		const std::string & value = values[row];
 
 		if (Utils::isEmptyValue(value))
 		{
-			if(changedSomething != nullptr && *intInputItr != INT_MIN)
-				*changedSomething = true;
-
-			*intInputItr = INT_MIN;
 			if (!value.empty())
-				emptyValuesMap.insert(make_pair(nb_values, value));
+				emptyValuesMap.insert(make_pair(row, value));
 		}
 		else
 		{
-			if (map.find(value) == map.end())
+			auto key = map.find(value);
+
+			if (key == map.end())
 				throw std::runtime_error("Error when reading column " + name() + ": cannot convert it to Nominal Text");
-			
-			if(changedSomething != nullptr && *intInputItr != map[value])
-				*changedSomething = true;
 
-			*intInputItr = map[value];
+			keys[row] = key->second;
 		}
-
-		intInputItr++;
-		nb_values++;
 	}
 
-	while (nb_values < _rowCount)
-	{
-		if(changedSomething != nullptr && *intInputItr != INT_MIN)
-			*changedSomething = true;
+	bool dataChanged = _setInts(keys, "Column::setColumnAsNominalText");
 
-		*intInputItr = INT_MIN;
-		intInputItr++;
-		nb_values++;
-	}
-
-	setColumnType(columnType::nominalText);
+	if(changedSomething != nullptr && dataChanged)
+		*changedSomething = true;
 
 	return emptyValuesMap;
 }
@@ -893,51 +853,167 @@ int Column::id() const
 
 void Column::setName(string name)
 {
-	_name = String(name.begin(), name.end(), _mem->get_segment_manager());
+	_name = String(name.begin(), name.end(), _mem);
 }
 
-void Column::setValue(int row, int value)
+void Column::setValue(size_t row, int value)
 {
-	BlockMap::iterator itr = _blocks.upper_bound(row);
+	if (row >= rowCount())
+		return;
 
-	if (itr == _blocks.end())
+	if (_data.ints())
 	{
-		//Log::log()  << "Column::setValue(), bad rowIndex" << std::endl;
-		return;
+		int & old = _data.ints()[row];
+
+		if (_stats.valid())
+		{
+			_stats.remove(old	== INT_MIN ? NAN : double(old));
+			_stats.add(value	== INT_MIN ? NAN : double(value));
+			_missing.setValid(row, value != INT_MIN);
+		}
+
+		if (_derived)
+			_derived->sketches.replace(old == INT_MIN ? NAN : double(old), value == INT_MIN ? NAN : double(value));
+
+		old = value;
+		_contentVersion++; //The stats and sketches are kept up to date, the sort index isn't
 	}
+	else
+	{
+		double & old = _data.doubles()[row];
+
+		_valueOverwritten(old, value == INT_MIN ? NAN : double(value)); //The number of distinct doubles can't be kept up to date value by value
+		old = value == INT_MIN ? NAN : double(value);
+	}
+}
+
+void Column::setValue(size_t row, double value)
+{
+	if (row >= rowCount())
+		return;
+
+	double old = _data.doubles() ? _data.doubles()[row] : (_data.ints()[row] == INT_MIN ? NAN : double(_data.ints()[row]));
+
+	if (_data.doubles())	_data.doubles()[row] = value;
+	else					_data.ints()[row] = std::isnan(value) ? INT_MIN : int(value);
+
+	//The number of distinct doubles can't be kept up to date value by value, and for ints this is not the way they are set
+	_valueOverwritten(old, _data.doubles() || std::isnan(value) ? value : double(int(value)));
+}
+
+void Column::setValues(size_t firstRow, const int * values, size_t count)
+{
+	if (firstRow + count > rowCount())
+		_data.resize(firstRow + count);
+
+	if (_data.layout() == ColumnBuffer::Layout::ints)
+		std::memcpy(_data.ints() + firstRow, values, count * sizeof(int));
+	else
+		std::transform(values, values + count, _data.doubles() + firstRow, [](int value) { return value == INT_MIN ? NAN : double(value); });
+
+	_valuesChanged();
+}
+
+void Column::setValues(size_t firstRow, const double * values, size_t count)
+{
+	if (firstRow + count > rowCount())
+		_data.resize(firstRow + count);
+
+	if (_data.layout() == ColumnBuffer::Layout::doubles)
+		std::memcpy(_data.doubles() + firstRow, values, count * sizeof(double));
+	else
+		std::transform(values, values + count, _data.ints() + firstRow, [](double value) { return std::isnan(value) ? INT_MIN : int(value); });
 
-	int blockId = itr->first;
-	DataBlock *block = itr->second.get();
+	_valuesChanged();
+}
+
+size_t Column::readInto(int * out, size_t firstRow, size_t count) const
+{
+	count = firstRow >= rowCount() ? 0 : std::min(count, rowCount() - firstRow);
 
-	int blockIndex = row - blockId + DataBlock::capacity();
-	block->Data[blockIndex].i = value;
+	if (_data.layout() == ColumnBuffer::Layout::ints)
+		_data.readInts(firstRow, count, out);
+	else
+		std::transform(_data.doubles() + firstRow, _data.doubles() + firstRow + count, out, [](double value) { return std::isnan(value) ? INT_MIN : int(value); });
+
+	return count;
 }
 
-void Column::setValue(int row, double value)
+size_t Column::readInto(double * out, size_t firstRow, size_t count) const
 {
-	BlockMap::iterator itr = _blocks.upper_bound(row);
+	count = firstRow >= rowCount() ? 0 : std::min(count, rowCount() - firstRow);
 
-	if (itr == _blocks.end())
+	if (_data.layout() == ColumnBuffer::Layout::doubles)
+		std::memcpy(out, _data.doubles() + firstRow, count * sizeof(double));
+	else
 	{
-		//Log::log()  << "Column::setValue(), bad rowIndex" << std::endl;
-		return;
+		auto widen = [](int value) { return value == INT_MIN ? NAN : double(value); };
+
+		if (!_data.packed())
+			std::transform(_data.ints() + firstRow, _data.ints() + firstRow + count, out, widen);
+		else
+		{
+			std::vector<int> batch(std::min(count, ColumnEncoding::DECODE_BATCH));
+
+			for (size_t done = 0; done < count; done += batch.size())
+			{
+				size_t batchSize = std::min(batch.size(), count - done);
+
+				_data.readInts(firstRow + done, batchSize, batch.data());
+				std::transform(batch.begin(), batch.begin() + batchSize, out + done, widen);
+			}
+		}
+	}
+
+	return count;
+}
+
+void Column::gatherInto(int * out, const std::vector<size_t> & rows) const
+{
+	if (_data.layout() == ColumnBuffer::Layout::doubles)
+	{
+		const double * values = _data.doubles();
+
+		for (size_t row : rows)
+			*out++ = row >= rowCount() || std::isnan(values[row]) ? INT_MIN : int(values[row]);
 	}
+	else if (!_data.packed())
+	{
+		const int * values = _data.ints();
 
-	int blockId = itr->first;
-	DataBlock *block = itr->second.get();
+		for (size_t row : rows)
+			*out++ = row < rowCount() ? values[row] : INT_MIN;
+	}
+	else
+		for (size_t row : rows)
+			*out++ = _data.intAt(row);
+}
+
+void Column::gatherInto(double * out, const std::vector<size_t> & rows) const
+{
+	if (_data.layout() == ColumnBuffer::Layout::doubles)
+	{
+		const double * values = _data.doubles();
 
-	int blockIndex = row - blockId + DataBlock::capacity();
-	block->Data[blockIndex].d = value;
+		for (size_t row : rows)
+			*out++ = row < rowCount() ? values[row] : NAN;
+	}
+	else
+		for (size_t row : rows)
+		{
+			int value = _data.intAt(row);
+			*out++ = value == INT_MIN ? NAN : double(value);
+		}
 }
 
-bool Column::isValueEqual(int row, double value)
+bool Column::isValueEqual(size_t row, double value)
 {
-	if (row >= _rowCount)
+	if (row >= rowCount())
 		return false;
 
 	if (_columnType == columnType::scale)
 	{
-		double d = AsDoubles[row];
+		double d = doubleValues()[row];
 
 		if (Utils::isEmptyValue(value))
 			return Utils::isEmptyValue(d);
@@ -948,15 +1024,15 @@ bool Column::isValueEqual(int row, double value)
 	return false;
 }
 
-bool Column::isValueEqual(int row, int value)
+bool Column::isValueEqual(size_t row, int value)
 {
-	if (row >= _rowCount)
+	if (row >= rowCount())
 		return false;
 
 	if (_columnType == columnType::scale)
-		return AsDoubles[row] == value;
+		return doubleValues()[row] == value;
 
-	int intValue = AsInts[row];
+	int intValue = _data.intAt(row);
 	if (_columnType == columnType::nominal || _columnType == columnType::ordinal)
 	{
 		bool result = (intValue == value);
@@ -985,30 +1061,30 @@ bool Column::isValueEqual(int row, int value)
 	return false;
 }
 
-bool Column::isValueEqual(int row, const string &value)
+bool Column::isValueEqual(size_t row, const string &value)
 {
-	if (row >= _rowCount)
+	if (row >= rowCount())
 		return false;
 
 	bool result = false;
 	switch (_columnType)
 	{
-		case columnType::scale:		return std::to_string(AsDoubles[row]) == value;
+		case columnType::scale:		return std::to_string(doubleValues()[row]) == value;
 		case columnType::nominal:
-		case columnType::ordinal:	return std::to_string(AsInts[row]) == value;
+		case columnType::ordinal:	return std::to_string(_data.intAt(row)) == value;
 		default:
 		{
-			int key = AsInts[row];
-			return key == INT_MIN ? Utils::isEmptyValue(value) : (value.substr(0, 128) == _labels.getValueFromKey(key));
+			int key = _data.intAt(row);
+			return key == INT_MIN ? Utils::isEmptyValue(value) : (value == _labels.getValueFromKey(key));
 		}
 	}
 
 	return false;
 }
 
-string Column::_getScaleValue(int row)
+string Column::_getScaleValue(size_t row)
 {
-	double v = AsDoubles[row];
+	double v = doubleValues()[row];
 
 	if (v > DBL_MAX)
 	{
@@ -1032,11 +1108,11 @@ string Column::_getScaleValue(int row)
 	}
 }
 
-string Column::getOriginalValue(int row)
+string Column::getOriginalValue(size_t row)
 {
 	string result = Utils::emptyValue;
 
-	if (row < _rowCount)
+	if (row < rowCount())
 	{
 		if (_columnType == columnType::scale)
 		{
@@ -1044,7 +1120,7 @@ string Column::getOriginalValue(int row)
 		}
 		else
 		{
-			int key = AsInts[row];
+			int key = _data.intAt(row);
 			if (key == INT_MIN)
 				result = Utils::emptyValue;
 			else
@@ -1056,11 +1132,11 @@ string Column::getOriginalValue(int row)
 }
 
 
-string Column::operator [](int row)
+string Column::operator [](size_t row)
 {
 	string result = Utils::emptyValue;
 
-	if (row < _rowCount)
+	if (row < rowCount())
 	{
 		if (_columnType == columnType::scale)
 		{
@@ -1068,7 +1144,7 @@ string Column::operator [](int row)
 		}
 		else
 		{
-			int key = AsInts[row];
+			int key = _data.intAt(row);
 			result = _getLabelFromKey(key);
 		}
 	}
@@ -1076,114 +1152,254 @@ string Column::operator [](int row)
 	return result;
 }
 
-void Column::append(int rows)
+void Column::append(size_t rows)
 {
 	if (rows == 0)
 		return;
 
-	BlockMap::reverse_iterator itr = _blocks.rbegin();
-
-	if (itr == _blocks.rend()) // no blocks
+	try
 	{
-		ull firstId = DataBlock::capacity();
-		DataBlock *firstBlock = _mem->construct<DataBlock>(anonymous_instance)();
-
-		_blocks.insert(BlockEntry(firstId, firstBlock));
-		itr = _blocks.rbegin();
+		_data.resize(rowCount() + rows);
+		_valuesChanged();
 	}
+	catch (boost::interprocess::bad_alloc &e)
+	{
+		Log::log() << e.what() << " append column " << name() << ", append: " << rows << ", rowCount: " << rowCount() << std::endl;
+		throw e;
+	}
+}
 
-	BlockEntry entry = *itr;
-	DataBlock *block = entry.second.get();
-	ull id = entry.first;
+void Column::truncate(size_t rows)
+{
+	if (rows == 0) return;
 
-	int room = DataBlock::capacity() - block->rowCount();
-	int rowsLeft = rows - room;
-	if (rowsLeft <= 0)
+	if (rows > rowCount())
 	{
-		block->insert(rows);
-		_rowCount += rows;
-		return;
+		Log::log() << "Try to truncate more rows than existing!!" << std::endl;
+		rows = rowCount();
 	}
 
-	block->insert(room);
-	_rowCount += room;
+	_data.resize(rowCount() - rows);
+	_missing.dropTokensFrom(rowCount());
+	_valuesChanged();
+}
 
-	int newBlocksRequired = rowsLeft / DataBlock::capacity();
-	if (rowsLeft % DataBlock::capacity())
-		newBlocksRequired++;
+void Column::insertRows(size_t row, size_t count)
+{
+	try
+	{
+		//All the allocations first, so a bad_alloc leaves the rows as they were for the retry. Growing by half keeps repeated inserts amortized.
+		if(rowCount() + count > _data.capacity())
+			_data.reserve(std::max(rowCount() + count, _data.capacity() + _data.capacity() / 2));
 
-	for (int i = 0; i < newBlocksRequired; i++)
+		_missing.insertRows(row, count);
+		_data.insertRows(row, count);
+		_valuesChanged();
+	}
+	catch (boost::interprocess::bad_alloc &e)
 	{
-		try {
+		Log::log() << e.what() << " insertRows column " << name() << ", at: " << row << ", insert: " << count << ", rowCount: " << rowCount() << std::endl;
+		throw;
+	}
+}
+
+void Column::removeRows(size_t row, size_t count)
+{
+	_data.eraseRows(row, count);
+	_missing.eraseRows(row, count);
+	_valuesChanged();
+}
 
-		DataBlock *newBlock = _mem->construct<DataBlock>(anonymous_instance)();
+void Column::setColumnType(enum columnType columnType)
+{
+	_columnType = columnType;
+	_data.setLayout(columnType == columnType::scale ? ColumnBuffer::Layout::doubles : ColumnBuffer::Layout::ints);
+	_valuesChanged(); //Also called by all the setColumnAs* before they write the new values
+}
+
+const ColumnStats & Column::stats()
+{
+	if (!_stats.valid())
+		_refreshStats();
+
+	return _stats;
+}
 
-		int toInsert = min(rowsLeft, DataBlock::capacity());
-		newBlock->insert(toInsert);
-		rowsLeft -= toInsert;
+const MissingValues & Column::missingValues()
+{
+	if (!_stats.valid())
+		_refreshStats();
 
-		id += DataBlock::capacity();
-		_blocks.insert(BlockEntry(id, newBlock));
+	return _missing;
+}
 
-		_rowCount += toInsert;
+void Column::_refreshStats()
+{
+	_stats.reset();
+	_missing.refresh(_data);
 
-		}
-		catch (boost::interprocess::bad_alloc &e)
+	if (doubleValues() && _derived && _derived->sortIndex.current(_contentVersion))
+	{
+		//Already sorted, so the distinct values can be counted without sorting them again
+		const double			*	values		= doubleValues();
+		const ColumnSortIndex	&	sorted		= _derived->sortIndex;
+		size_t						distinct	= 0;
+
+		for (size_t row = 0; row < rowCount(); row++)
+			_stats.add(values[row]);
+
+		for (size_t i = 0; i < sorted.valueCount(); i++)
+			if (i == 0 || values[sorted[i]] != values[sorted[i - 1]])
+				distinct++;
+
+		_stats.setDistinct(distinct);
+	}
+	else if (doubleValues())
+	{
+		const double *		values = doubleValues();
+		std::vector<double>	sorted;
+		sorted.reserve(rowCount());
+
+		for (size_t row = 0; row < rowCount(); row++)
 		{
-			cout << e.what() << " ";
-			cout << "append column " << name() << ", append: " << rows << ", rowCount: " << _rowCount << std::endl;
-			throw e;
+			double value = values[row];
+			_stats.add(value);
+
+			if (!std::isnan(value))
+				sorted.push_back(value);
 		}
+
+		std::sort(sorted.begin(), sorted.end());
+		_stats.setDistinct(std::unique(sorted.begin(), sorted.end()) - sorted.begin());
 	}
+	else
+	{
+		std::vector<int>	decoded;
+		const int		*	values = intValues(decoded);
+
+		for (size_t row = 0; row < rowCount(); row++)
+			_stats.add(values[row] == INT_MIN ? NAN : double(values[row]));
+
+		_stats.setDistinct(_labels.size());
+	}
+}
+
+const ColumnSortIndex & Column::sortIndex()
+{
+	ColumnSortIndex & sorted = _makeDerived()->sortIndex;
+
+	if (!sorted.current(_contentVersion))
+		sorted.rebuild(_data, _contentVersion);
+
+	return sorted;
+}
+
+const ColumnSortIndex & Column::sortIndex() const
+{
+	static const ColumnSortIndex never(nullptr); //Never current and never allocates, for a column that has no sort index yet
+
+	return _derived ? _derived->sortIndex : never;
+}
+
+const ColumnSketches & Column::sketches()
+{
+	ColumnSketches & sketches = _makeDerived()->sketches;
+
+	if (!sketches.valid())
+		sketches.rebuild(_data);
+
+	return sketches;
+}
+
+const ColumnSketches & Column::sketches() const
+{
+	static const ColumnSketches never(nullptr);
+
+	return _derived ? _derived->sketches : never;
+}
+
+Column::Derived * Column::_makeDerived()
+{
+	if (!_derived)
+		_derived = _mem->construct<Derived>(boost::interprocess::anonymous_instance)(_mem);
+
+	return _derived.get();
+}
+
+void Column::_dropDerived()
+{
+	if (_derived)
+		_mem->destroy_ptr(_derived.get());
+
+	_derived = nullptr;
+}
+
+double Column::quantile(double p)
+{
+	const ColumnSortIndex & sorted = sortIndex();
+
+	if (sorted.valueCount() == 0)
+		return NAN;
+
+	double	position	= std::min(std::max(p, 0.0), 1.0) * (sorted.valueCount() - 1);
+	size_t	below		= size_t(position);
+	double	fraction	= position - below,
+			low			= doubleValues() ? doubleValues()[sorted[below]] : double(_data.intAt(sorted[below]));
+
+	if (fraction == 0)
+		return low;
+
+	double	high		= doubleValues() ? doubleValues()[sorted[below + 1]] : double(_data.intAt(sorted[below + 1]));
+
+	return low + fraction * (high - low);
 }
 
-void Column::truncate(int rows)
+bool Column::_valuesEqual(const Column & other) const
 {
-	if (rows <= 0) return;
+	if (_data.layout() != other._data.layout() || rowCount() != other.rowCount())
+		return false;
 
-	BlockMap::reverse_iterator itr = _blocks.rbegin();
-	DataBlock *block = itr->second.get();
+	if (sharesValuesWith(other))
+		return true;
 
-	int rowsToDelete = rows;
+	if (doubleValues())
+		return std::memcmp(doubleValues(), other.doubleValues(), rowCount() * sizeof(double)) == 0; //Bitwise, so NaN equals NaN
 
-	if (rowsToDelete > _rowCount)
-		rowsToDelete = _rowCount;
+	std::vector<int> batch(std::min(rowCount(), ColumnEncoding::DECODE_BATCH)), otherBatch(batch.size());
 
-	while (rowsToDelete > 0)
+	for (size_t from = 0; from < rowCount(); from += batch.size())
 	{
-		if (block->rowCount() >= rowsToDelete)
-		{
-			block->erase(rowsToDelete);
-			_rowCount -= rowsToDelete;
-			rowsToDelete = 0;
-		}
-		else
-		{
-			rowsToDelete -= block->rowCount();
-			_rowCount -= block->rowCount();
-			block->erase(block->rowCount());
-			//_mem->destroy_ptr<DataBlock>(block);
-			itr++;
-			if (itr == _blocks.rend())
-			{
-				Log::log() << "Try to erase more blocks than existing!!" << std::endl;
-				rowsToDelete = 0;
-				_rowCount = 0;
-			}
-			else
-			{
-				block = itr->second.get();
-			}
-		}
+		size_t count = readInto(batch.data(), from, batch.size());
+		other.readInto(otherBatch.data(), from, count);
+
+		if (!std::equal(batch.begin(), batch.begin() + count, otherBatch.begin()))
+			return false;
 	}
+
+	return true;
 }
 
-void Column::setColumnType(enum columnType columnType)
+void Column::_shareValues(const Column & other)
 {
-	_columnType = columnType;
+	//The values stay the same, so the stats, sort index and sketches stay what they are
+	_data = other._data;
+}
+
+const int * Column::intValues(std::vector<int> & decodeInto) const
+{
+	if (_data.layout() != ColumnBuffer::Layout::ints)
+		return nullptr;
+
+	if (!_data.packed())
+		return _data.ints();
+
+	decodeInto.resize(rowCount());
+	_data.readInts(0, rowCount(), decodeInto.data());
+
+	return decodeInto.data();
 }
 
-void Column::_setRowCount(int rowCount)
+void Column::_setRowCount(size_t rowCount)
 {
 	if (rowCount > this->rowCount())
 		append(rowCount - this->rowCount());
@@ -1195,97 +1411,94 @@ Column::Ints::IntsStruct::IntsStruct()
 {
 }
 
-Column *Column::IntsStruct::getParent() const
+Column *Column::IntsStruct::getParent()
+{
+	return const_cast<Column*>(static_cast<const IntsStruct*>(this)->getParent());
+}
+
+const Column *Column::IntsStruct::getParent() const
 {
 	Column *column		= (Column*) NULL;
 	char* intsAddress	= (char*)&column->AsInts;
 	char* baseAddress	= (char*)column;
 	char* thisAddress	= (char*)this;
 
-	return (Column*)(thisAddress - intsAddress + baseAddress);
+	return (const Column*)(thisAddress - intsAddress + baseAddress);
 }
 
-int& Column::IntsStruct::operator [](int rowIndex)
+int& Column::IntsStruct::operator [](size_t rowIndex)
 {
 	Column* parent = getParent();
 
-	BlockMap::iterator itr = parent->_blocks.upper_bound(rowIndex);
+	if (rowIndex >= parent->rowCount() || !parent->_data.ints())
+		throw std::out_of_range("Column::Ints[] got row " + std::to_string(rowIndex) + " of column '" + parent->name() + "', which " + (parent->_data.ints() ? "it doesn't have" : "does not hold ints"));
 
-	if (itr == parent->_blocks.end())
-	{
-		Log::log() << "Column::Ints[], bad rowIndex: " << rowIndex << std::endl;
-		Log::log() << "Nb of blocks: " << parent->_blocks.size() << std::endl;
-	}
+	return parent->_data.ints()[rowIndex];
+}
+
+int Column::IntsStruct::operator [](size_t rowIndex) const
+{
+	const Column * parent = getParent();
 
-	int blockId = itr->first;
-	DataBlock *block = itr->second.get();
+	if (rowIndex >= parent->rowCount() || parent->_data.layout() != ColumnBuffer::Layout::ints)
+		throw std::out_of_range("Column::Ints[] got row " + std::to_string(rowIndex) + " of column '" + parent->name() + "', which " + (parent->_data.layout() == ColumnBuffer::Layout::ints ? "it doesn't have" : "does not hold ints"));
 
-	int pos = rowIndex - blockId + DataBlock::capacity();
-	return block->Data[pos].i;
+	return parent->_data.intAt(rowIndex);
 }
 
 Column::Ints::iterator Column::Ints::begin()
 {
 	Column *parent = getParent();
-	BlockMap::iterator itr = parent->_blocks.begin();
-	return iterator(itr, 0);
+	return iterator(parent->_data.ints());
 }
 
 Column::Ints::iterator Column::Ints::end()
 {
-	BlockMap::iterator itr = getParent()->_blocks.end();
-	return iterator(itr, 0);
+	Column *parent = getParent();
+	return iterator(parent->_data.ints() ? parent->_data.ints() + parent->rowCount() : nullptr);
 }
 
-Column::Ints::iterator::iterator(BlockMap::iterator blockItr, int pos)
+Column::Ints::const_iterator Column::Ints::begin() const
 {
-	_blockItr = blockItr;
-	_currentPos = pos;
+	const Column *parent = getParent();
+	return const_iterator(&parent->_data, 0);
 }
 
-void Column::Ints::iterator::increment()
+Column::Ints::const_iterator Column::Ints::end() const
 {
-	_currentPos++;
-
-	if (_currentPos >= _blockItr->second->rowCount())
-	{
-		_blockItr++;
-		_currentPos = 0;
-	}
+	const Column *parent = getParent();
+	return const_iterator(&parent->_data, parent->_data.layout() == ColumnBuffer::Layout::ints ? parent->rowCount() : 0);
 }
 
-bool Column::Ints::iterator::equal(iterator const& other) const
+Column::Doubles::iterator Column::Doubles::begin()
 {
-	return this->_currentPos == other._currentPos && this->_blockItr == other._blockItr;
+	Column *parent = getParent();
+	return iterator(parent->_data.doubles());
 }
 
-int& Column::Ints::iterator::dereference() const
+Column::Doubles::iterator Column::Doubles::end()
 {
-	return _blockItr->second->Data[_currentPos].i;
+	Column *parent = getParent();
+	return iterator(parent->_data.doubles() ? parent->_data.doubles() + parent->rowCount() : nullptr);
 }
 
-Column::Doubles::iterator Column::Doubles::begin()
+Column::Doubles::const_iterator Column::Doubles::begin() const
 {
-	Column *parent = getParent();
-	BlockMap::iterator itr = parent->_blocks.begin();
-	return iterator(itr, 0);
+	return getParent()->doubleValues();
 }
 
-Column::Doubles::iterator Column::Doubles::end()
+Column::Doubles::const_iterator Column::Doubles::end() const
 {
-	Column *parent = getParent();
-	BlockMap::iterator itr = parent->_blocks.end();
-	return iterator(itr, 0);
+	const Column *parent = getParent();
+	return parent->doubleValues() ? parent->doubleValues() + parent->rowCount() : nullptr;
 }
 
-Column::Doubles::iterator::iterator(BlockMap::iterator blockItr, int pos)
+Column *Column::DoublesStruct::getParent()
 {
-	_blockItr = blockItr;
-	_currentPos = pos;
+	return const_cast<Column*>(static_cast<const DoublesStruct*>(this)->getParent());
 }
 
-
-Column *Column::DoublesStruct::getParent() const
+const Column *Column::DoublesStruct::getParent() const
 {
 	// This code seems quite weird... but this is a technique to get the address of the parent object from
 	// a member. We could have used offsetof function though.
@@ -1297,46 +1510,27 @@ Column *Column::DoublesStruct::getParent() const
 	char* intsAddress = (char*)&column->AsDoubles;
 	char* baseAddress = (char*)column;
 	char* thisAddress = (char*)this;
-	return (Column*)(thisAddress - intsAddress + baseAddress);
+	return (const Column*)(thisAddress - intsAddress + baseAddress);
 }
 
-double& Column::DoublesStruct::operator [](int rowIndex)
+double& Column::DoublesStruct::operator [](size_t rowIndex)
 {
 	Column *parent = getParent();
 
-	BlockMap::iterator itr = parent->_blocks.upper_bound(rowIndex);
+	if (rowIndex >= parent->rowCount() || !parent->_data.doubles())
+		throw std::out_of_range("Column::Doubles[] got row " + std::to_string(rowIndex) + " of column '" + parent->name() + "', which " + (parent->_data.doubles() ? "it doesn't have" : "does not hold doubles"));
 
-	if (itr == parent->_blocks.end())
-	{
-		//Log::log()  << "Column::Ints[], bad rowIndex" << std::endl;
-	}
-
-	int blockId = itr->first;
-	DataBlock *block = itr->second.get();
-
-	int pos = rowIndex - blockId + DataBlock::capacity();
-	return block->Data[pos].d;
+	return parent->_data.doubles()[rowIndex];
 }
 
-void Column::Doubles::iterator::increment()
+double Column::DoublesStruct::operator [](size_t rowIndex) const
 {
-	_currentPos++;
-
-	if (_currentPos >= _blockItr->second->rowCount())
-	{
-		_blockItr++;
-		_currentPos = 0;
-	}
-}
+	const Column * parent = getParent();
 
-bool Column::Doubles::iterator::equal(iterator const& other) const
-{
-	return this->_currentPos == other._currentPos && this->_blockItr == other._blockItr;
-}
+	if (rowIndex >= parent->rowCount() || !parent->doubleValues())
+		throw std::out_of_range("Column::Doubles[] got row " + std::to_string(rowIndex) + " of column '" + parent->name() + "', which " + (parent->doubleValues() ? "it doesn't have" : "does not hold doubles"));
 
-double& Column::Doubles::iterator::dereference() const
-{
-	return _blockItr->second->Data[_currentPos].d;
+	return parent->doubleValues()[rowIndex];
 }
 
 bool Column::allLabelsPassFilter() const
@@ -1359,42 +1553,51 @@ void Column::resetFilter()
 		labels()[i].setFilterAllows(true);
 }
 
-bool Column::isColumnDifferentFromStringValues(std::vector<std::string> strVals)
+bool Column::isColumnDifferentFromStringValues(const std::vector<std::string> & strVals, size_t skipRow, size_t skipCount)
 {
-	if(strVals.size() != rowCount()) return true;
+	if(strVals.size() + skipCount != rowCount()) return true;
 
-	for(int row = 0; row < strVals.size(); row++)
-		switch(getColumnType())
-		{
-		case columnType::ordinal:
-		case columnType::nominal:
-		{
-			int intValue;
-			if(!Utils::convertValueToIntForImport(strVals[row], intValue) || !isValueEqual(row, intValue))
-				return true;
-			break;
-		}
+	for(size_t row = 0; row < strVals.size(); row++)
+		if(!_isValueEqualToImported(row < skipRow ? row : row + skipCount, strVals[row]))
+			return true;
 
-		case columnType::scale:
-		{
-			double doubleValue;
-			if(!Utils::convertValueToDoubleForImport(	strVals[row], doubleValue) || !isValueEqual(row, doubleValue))
-				return true;
-			break;
-		}
+	return false;
+}
 
-		case columnType::nominalText:
-		{
-			if(!isValueEqual(row, strVals[row]))
-				return true;
-			break;
-		}
+size_t Column::firstRowDifferentFromStringValues(const std::vector<std::string> & strVals)
+{
+	size_t rows = std::min(strVals.size(), rowCount());
 
-		default:
-			return true;
-		}
+	for(size_t row = 0; row < rows; row++)
+		if(!_isValueEqualToImported(row, strVals[row]))
+			return row;
 
-	return false;
+	return rows;
+}
+
+bool Column::_isValueEqualToImported(size_t row, const std::string & strVal)
+{
+	switch(getColumnType())
+	{
+	case columnType::ordinal:
+	case columnType::nominal:
+	{
+		int intValue;
+		return Utils::convertValueToIntForImport(strVal, intValue) && isValueEqual(row, intValue);
+	}
+
+	case columnType::scale:
+	{
+		double doubleValue;
+		return Utils::convertValueToDoubleForImport(strVal, doubleValue) && isValueEqual(row, doubleValue);
+	}
+
+	case columnType::nominalText:
+		return isValueEqual(row, strVal);
+
+	default:
+		return false;
+	}
 }
 
 
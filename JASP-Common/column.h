@@ -25,8 +25,13 @@
 #include <boost/container/string.hpp>
 #include <boost/container/vector.hpp>
 
-#include "datablock.h"
+#include "columnbuffer.h"
+#include "columnsketches.h"
+#include "columnsortindex.h"
+#include "columnstats.h"
+#include "datasetversions.h"
 #include "labels.h"
+#include "missingvalues.h"
 
 #include "columntype.h"
 
@@ -34,17 +39,12 @@ class Column
 {
 	friend class DataSet;
 	friend class Columns;
+	friend class ColumnTypeConverter;
 	friend class ComputedColumn;
 	friend class ComputedColumns;
 	friend class DataSetLoader;
 	friend class boost::iterator_core_access;
 
-	typedef unsigned long long ull;
-	typedef boost::interprocess::allocator<boost::interprocess::offset_ptr<DataBlock>, boost::interprocess::managed_shared_memory::segment_manager> BlockAllocator;
-	typedef boost::container::map<ull, boost::interprocess::offset_ptr<DataBlock>, BlockAllocator>::value_type BlockEntry;
-	typedef boost::interprocess::allocator<BlockEntry, boost::interprocess::managed_shared_memory::segment_manager> BlockEntryAllocator;
-	typedef boost::container::map<ull, boost::interprocess::offset_ptr<DataBlock>, std::less<ull>, BlockEntryAllocator> BlockMap;
-
 	typedef boost::interprocess::allocator<char, boost::interprocess::managed_shared_memory::segment_manager> CharAllocator;
 	typedef boost::container::basic_string<char, std::char_traits<char>, CharAllocator> String;
 	typedef boost::interprocess::allocator<String, boost::interprocess::managed_shared_memory::segment_manager> StringAllocator;
@@ -53,7 +53,10 @@ public:
 	///ColumnType is set up to be used as bitflags in places such as assignedVariablesModel and such
 	//enum ColumnType { unknown = 0, nominal = 1, nominalText = 2, ordinal = 4, scale = 8 };
 
-	bool resetEmptyValues(std::map<int, std::string>& emptyValuesMap);
+	bool resetEmptyValues(); ///< Applies the current Utils::getEmptyValues() and returns whether anything changed
+
+	void							setEmptyValueTokens(const std::map<size_t, std::string> & tokens)	{ _missing.setTokens(tokens);		} ///< The original texts of the rows that were read as empty, by row
+	std::map<size_t, std::string>	emptyValueTokens()										const	{ return _missing.tokensAsMap();	}
 
 
 	bool overwriteDataWithScale(std::vector<double> scalarData);
@@ -69,34 +72,63 @@ public:
 		friend class Column;
 
 		class iterator : public boost::iterator_facade<
-				iterator, int, boost::forward_traversal_tag>
+				iterator, int, boost::random_access_traversal_tag>
+		{
+			friend class boost::iterator_core_access;
+
+		public:
+
+			explicit iterator(int * value) : _value(value) {}
+
+		private:
+
+			void		increment()								{ ++_value;						}
+			void		decrement()								{ --_value;						}
+			void		advance(std::ptrdiff_t n)				{ _value += n;					}
+			bool		equal(iterator const& other)	const	{ return _value == other._value;	}
+			int&		dereference()					const	{ return *_value;				}
+			std::ptrdiff_t distance_to(iterator const& other) const	{ return other._value - _value;	}
+
+			int * _value;
+		};
+
+		///Reads the rows one by one through ColumnBuffer::intAt, so a packed or shared column stays as it is
+		class const_iterator : public boost::iterator_facade<
+				const_iterator, int, boost::random_access_traversal_tag, int>
 		{
 			friend class boost::iterator_core_access;
 
 		public:
 
-			explicit iterator(BlockMap::iterator blockItr, int currentPos);
+			const_iterator(const ColumnBuffer * data, size_t row) : _data(data), _row(row) {}
 
 		private:
 
-			void increment();
-			bool equal(iterator const& other) const;
-			int& dereference() const;
+			void		increment()										{ ++_row;							}
+			void		decrement()										{ --_row;							}
+			void		advance(std::ptrdiff_t n)						{ _row += n;						}
+			bool		equal(const_iterator const& other)		const	{ return _row == other._row;		}
+			int			dereference()							const	{ return _data->intAt(_row);		}
+			std::ptrdiff_t distance_to(const_iterator const& other) const	{ return std::ptrdiff_t(other._row) - std::ptrdiff_t(_row);	}
 
-			BlockMap::iterator _blockItr;
-			int _currentPos;
+			const ColumnBuffer	*	_data;
+			size_t					_row;
 		};
 
-		int& operator[](int index);
+		int& operator[](size_t index);					///< Unpacks and unshares the column, so only for writing
+		int	 operator[](size_t index) const;
 
-		iterator begin();
-		iterator end();
+		iterator		begin();
+		iterator		end();
+		const_iterator	begin() const;
+		const_iterator	end() const;
 
 		IntsStruct();
 
 	private:
 
-		Column *getParent() const;
+				Column *getParent();
+		const	Column *getParent() const;
 
 	} Ints;
 
@@ -105,66 +137,94 @@ public:
 		friend class Column;
 
 		class iterator : public boost::iterator_facade<
-				iterator, double, boost::forward_traversal_tag>
+				iterator, double, boost::random_access_traversal_tag>
 		{
-
 			friend class boost::iterator_core_access;
 
 		public:
 
-			explicit iterator(BlockMap::iterator blockItr, int currentPos);
+			explicit iterator(double * value) : _value(value) {}
 
 		private:
 
-			void increment();
-			bool equal(iterator const& other) const;
-			double& dereference() const;
-
-			BlockMap::iterator _blockItr;
-			int _currentPos;
+			void		increment()								{ ++_value;						}
+			void		decrement()								{ --_value;						}
+			void		advance(std::ptrdiff_t n)				{ _value += n;					}
+			bool		equal(iterator const& other)	const	{ return _value == other._value;	}
+			double&		dereference()					const	{ return *_value;				}
+			std::ptrdiff_t distance_to(iterator const& other) const	{ return other._value - _value;	}
 
+			double * _value;
 		};
 
-		double& operator[](int index);
+		typedef const double * const_iterator; ///< Doubles are never packed, so reading them is just reading the array
+
+		double& operator[](size_t index);				///< Unshares the column, so only for writing
+		double	operator[](size_t index) const;
 
-		iterator begin();
-		iterator end();
+		iterator		begin();
+		iterator		end();
+		const_iterator	begin() const;
+		const_iterator	end() const;
 
 	private:
 		DoublesStruct() {}
 
-		Column *getParent() const;
+				Column *getParent();
+		const	Column *getParent() const;
 
 	} Doubles;
 
-	Column(boost::interprocess::managed_shared_memory *mem)  : _mem(mem), _name(mem->get_segment_manager()), _columnType(columnType::nominal), _rowCount(0), _blocks(std::less<ull>(), mem->get_segment_manager()), _labels(mem)
+	Column(boost::interprocess::managed_shared_memory::segment_manager *mem)  : _mem(mem), _name(mem), _columnType(columnType::nominal), _data(mem), _labels(mem), _missing(mem)
 	{
 		_id = ++count;
 	}
 
-	Column(const Column& col) : _mem(col._mem), _name(col._name), _columnType(col._columnType), _rowCount(col._rowCount), _blocks(col._blocks), _labels(col._labels)
+	///A copy does not get the older versions, but it does keep the epoch so it can serve as one of them. Nor does it get the sort index or sketches, it can build its own when asked.
+	Column(const Column& col) : _mem(col._mem), _name(col._name), _columnType(col._columnType), _data(col._data), _labels(col._labels), _stats(col._stats), _missing(col._missing), _epoch(col._epoch)
 	{
 		_id = ++count;
 	}
 
-	~Column() {}
+	///A copy in another segment, for SharedMemory::compactDataSet. It keeps the id, but not the versions or the epoch as the DataSetVersions there start over.
+	Column(boost::interprocess::managed_shared_memory::segment_manager *mem, const Column& col) : _mem(mem), _name(col._name.c_str(), col._name.size(), mem), _columnType(col._columnType), _data(mem, col._data), _labels(mem, col._labels), _stats(col._stats), _missing(mem, col._missing), _id(col._id)
+	{}
+
+	///Moving is what ColumnVector does when it reallocates or erases, this way neither the data nor the labels, name and missing values get copied around.
+	Column(Column&& col) : _mem(col._mem), _name(std::move(col._name)), _columnType(col._columnType), _data(std::move(col._data)), _labels(std::move(col._labels)), _stats(col._stats), _missing(std::move(col._missing)), _derived(col._derived), _contentVersion(col._contentVersion), _id(col._id), _epoch(col._epoch), _olderVersion(col._olderVersion)
+	{
+		col._derived		= nullptr;
+		col._olderVersion	= nullptr;
+	}
+
+	~Column() { _dropAllVersions(); _dropDerived(); }
 
 	std::string name() const;
 	int id() const;
-	void setName(std::string name);
 
-	void setValue(int row, int value);
-	void setValue(int row, double value);
+	void setValue(size_t row, int value);
+	void setValue(size_t row, double value);
+
+	///Whole ranges of rows at once, converted to the layout of the column (INT_MIN <-> NaN). The column first grows to firstRow + count
+	///in a single allocation if it is shorter, so this throws boost::interprocess::bad_alloc before anything was written.
+	void	setValues(size_t firstRow, const int	* values, size_t count);
+	void	setValues(size_t firstRow, const double	* values, size_t count);
+	size_t	readInto(int	* out, size_t firstRow, size_t count)	const;	///< Returns how many rows were read, packed or not
+	size_t	readInto(double	* out, size_t firstRow, size_t count)	const;
+	void	gatherInto(int		* out, const std::vector<size_t> & rows)	const;	///< out[i] gets row rows[i], for instance those of FilterBitmap::passingRows()
+	void	gatherInto(double	* out, const std::vector<size_t> & rows)	const;
 
-	bool isValueEqual(int row, int value);
-	bool isValueEqual(int row, double value);
-	bool isValueEqual(int row, const std::string &value);
+	bool isValueEqual(size_t row, int value);
+	bool isValueEqual(size_t row, double value);
+	bool isValueEqual(size_t row, const std::string &value);
 
-	std::string operator[](int row);
-	std::string getOriginalValue(int row);
+	std::string operator[](size_t row);
+	std::string getOriginalValue(size_t row);
 
-	void append(int rows);
-	void truncate(int rows);
+	void append(size_t rows);
+	void truncate(size_t rows);
+	void insertRows(size_t row, size_t count);	///< Empty rows in between, the ones from row on move down. The labels stay as they are, they do not know about rows.
+	void removeRows(size_t row, size_t count);	///< The rows after them move up, their empty value tokens along with them
 
 	// If the column is a scale, it uses the AsDoubles which is a mapping between the row numbers and the double values.
 	// Scale columns do not have labels.
@@ -176,28 +236,58 @@ public:
 	// The AsInts is then a mapping between the row numbers and these keys. In this case, if the label of one value
 	// is modified, the new value is in the label object, and the original string value is kept in another mapping
 	// structure (cf. labels.h).
-	// Both AsDoubles & AsInts get their space from the BlockMap _blocks which is a mapping of DataBlock.
+	// Both AsDoubles & AsInts get their space from the ColumnBuffer _data which is one contiguous array in shared memory.
+	// That buffer holds ints or doubles at their own width depending on the columnType, so only one of AsDoubles and AsInts
+	// has values at any time: the other one is an empty range. setColumnType takes care of converting the buffer.
+	// After loading the ints of most columns are packed (see ColumnEncoding), writing through AsInts unpacks them again.
+	// The same goes for a column that shares its values with another (see ColumnBuffer): writing through AsInts and AsDoubles
+	// gives it its own copy. Reading through a const AsInts or AsDoubles, intValues() or doubleValues() leaves the column as it is.
 	Doubles AsDoubles;
 	Ints AsInts;
 
 	void setColumnType(enum columnType columnType);
 	enum columnType getColumnType() const;
 
-	bool changeColumnType(enum columnType newColumnType);
+	bool changeColumnType(enum columnType newColumnType); ///< See ColumnTypeConverter, to convert on another thread use that directly
+
+	size_t rowCount() const { return _data.size(); }
+	size_t unusedBytes() const { return _data.bytesUnused(); }
+	size_t usedBytes() const { return _data.bytesUsed(); }
+
+	bool		pack() { return _columnType != columnType::scale && _data.pack(); }	///< Compresses the ints when that is worth it, they get unpacked on the next write
+	bool		packed() const { return _data.packed(); }
+	const int *	intValues(std::vector<int> & decodeInto) const;						///< All the ints, straight from shared memory unless they are packed, then decoded into decodeInto. nullptr for scale.
+	const double * doubleValues() const { return _data.doubles(); }					///< All the doubles, straight from shared memory. nullptr unless scale.
+	bool		sharesValuesWith(const Column & other) const { return _data.payload() && _data.payload() == other._data.payload(); }
+	bool		hasDerived() const { return bool(_derived); } ///< Whether something asked for its sort index or sketches already
 
-	size_t rowCount() const { return _rowCount; }
+			const ColumnStats & stats();						///< Recomputes the stats first if they are stale
+			const ColumnStats & stats() const { return _stats; }	///< For readers that cannot write to the column, check ColumnStats::valid()
+			const MissingValues & missingValues();				///< Its bitmap is refreshed together with the stats
+
+			const ColumnSortIndex &	sortIndex();						///< Rebuilds it first if the values changed since it was built
+			const ColumnSortIndex &	sortIndex() const;					///< For readers that cannot write to the column, check ColumnSortIndex::current(contentVersion())
+			uint64_t				contentVersion() const { return _contentVersion; } ///< Goes up whenever the values change
+			double					quantile(double p);					///< Like R's default (type 7) over the values that are not missing, NaN if there are none
+
+			const ColumnSketches &	sketches();							///< Rebuilds them first if they are stale
+			const ColumnSketches &	sketches() const;					///< For readers that cannot write to the column, check ColumnSketches::valid()
 
 			Labels & labels();
 	const	Labels & labels() const;
 
-	Column &operator=(const Column &columns);
+	Column &operator=(const Column &column);
+	Column &operator=(Column &&column);
 
-	void setSharedMemory(boost::interprocess::managed_shared_memory *mem);
+	///The newest version of this column that a reader at epoch may see, see DataSetVersions. Hold its ReadLock while using it.
+	const Column & version(DataSetVersions::Epoch epoch) const;
+
+	void setSharedMemory(boost::interprocess::managed_shared_memory::segment_manager *mem);
 
 	bool						setColumnAsScale(const std::vector<double> &values);
 
-	std::map<int, std::string>	setColumnAsNominalText(const std::vector<std::string> &values,	const std::map<std::string, std::string> &labels, bool * changedSomething = NULL);
-	std::map<int, std::string>	setColumnAsNominalText(const std::vector<std::string> &values, bool * changedSomething = NULL);
+	std::map<size_t, std::string>	setColumnAsNominalText(const std::vector<std::string> &values,	const std::map<std::string, std::string> &labels, bool * changedSomething = NULL); ///< Returns the empty value tokens by row
+	std::map<size_t, std::string>	setColumnAsNominalText(const std::vector<std::string> &values, bool * changedSomething = NULL);
 
 	bool						setColumnAsNominalOrOrdinal(const std::vector<int> &values,		std::map<int, std::string> uniqueValues,	bool is_ordinal = false);
 	bool						setColumnAsNominalOrOrdinal(const std::vector<int> &values,													bool is_ordinal = false);
@@ -208,43 +298,74 @@ public:
 
 	void resetFilter();
 
-	bool isColumnDifferentFromStringValues(std::vector<std::string> strVals);
+	bool	isColumnDifferentFromStringValues(const std::vector<std::string> & strVals, size_t skipRow = 0, size_t skipCount = 0);	///< Compares as if the rows [skipRow, skipRow + skipCount) were removed first
+	size_t	firstRowDifferentFromStringValues(const std::vector<std::string> & strVals);	///< The number of rows both have if neither differs before that
 
 private:	
+	bool		_isValueEqualToImported(size_t row, const std::string & strVal);
+	void		setName(std::string name);	///< Through Columns::setColumnName, which keeps its index of the names up to date
 
 	bool		_setColumnAsNominalOrOrdinal(const std::vector<int> &values, bool is_ordinal = false);
+	bool		_setInts(const std::vector<int> &values, const char * caller);	///< Writes values and INT_MIN in the rows after them, returns whether anything changed
 
-	void		_setRowCount(int rowCount);
+	void		_setRowCount(size_t rowCount);
 	std::string	_getLabelFromKey(int key) const;
-	std::string	_getScaleValue(int row);
+	std::string	_getScaleValue(size_t row);
 
 	void		_convertVectorIntToDouble(std::vector<int> &intValues, std::vector<double> &doubleValues);
 
-	bool		_resetEmptyValuesForNominal(std::map<int, std::string> &emptyValuesMap);
-	bool		_resetEmptyValuesForScale(std::map<int, std::string> &emptyValuesMap);
-	bool		_resetEmptyValuesForNominalText(std::map<int, std::string> &emptyValuesMap, bool tryToConvert = true);
+	bool		_resetEmptyValuesForNominal(std::map<size_t, std::string> &emptyValuesMap);
+	bool		_resetEmptyValuesForScale(std::map<size_t, std::string> &emptyValuesMap);
+	bool		_resetEmptyValuesForNominalText(std::map<size_t, std::string> &emptyValuesMap, bool tryToConvert = true);
+
 
-	bool		_changeColumnToNominalOrOrdinal(enum columnType newColumnType);
-	bool		_changeColumnToScale();
+	bool		_valuesEqual(const Column & other) const;	///< Only the values as they are stored, so ints are compared as keys and the labels are not looked at
+	void		_shareValues(const Column & other);			///< Makes this use the values of other until either is written to, they must be equal
+
+	void		_refreshStats();
+	void		_valuesChanged() { _stats.invalidate(); if (_derived) _derived->sketches.invalidate(); _contentVersion++; } ///< Makes the stats, the sort index and the sketches stale
+	void		_valueOverwritten(double oldValue, double newValue) { _stats.invalidate(); if (_derived) _derived->sketches.replace(oldValue, newValue); _contentVersion++; } ///< The sketches can take a single value
+	bool		_emptyValuesMightChange() const;
+
+	void		_keepVersion(DataSetVersions::Epoch newEpoch);
+	void		_dropUnseenVersions(const DataSetVersions & versions);
+	void		_dropAllVersions();
+
+	///The sort index and the sketches only get allocated once something asks for them, most columns of wide data never get sorted or summarized
+	struct Derived
+	{
+		Derived(boost::interprocess::managed_shared_memory::segment_manager * mem) : sortIndex(mem), sketches(mem) {}
+
+		ColumnSortIndex	sortIndex;
+		ColumnSketches	sketches;
+	};
+
+	Derived *	_makeDerived();	///< Throws boost::interprocess::bad_alloc if there is no room for it
+	void		_dropDerived();
 
 private:
-	boost::interprocess::managed_shared_memory * _mem = nullptr;
+	boost::interprocess::managed_shared_memory::segment_manager * _mem = nullptr;
 
 	String			_name;
 	enum columnType _columnType;
-	size_t			_rowCount;
-
-	BlockMap		_blocks;
+	ColumnBuffer	_data;
 	Labels			_labels;
+	ColumnStats		_stats;
+	MissingValues	_missing;
+	boost::interprocess::offset_ptr<Derived>	_derived;
+	uint64_t		_contentVersion = 0;
 
 	int				_id;
 	static int		count;
+
+	DataSetVersions::Epoch					_epoch = 0;		///< When the contents of this version were written
+	boost::interprocess::offset_ptr<Column>	_olderVersion;	///< Snapshots that pinned readers might still be reading, newest first
 };
 
 namespace boost
 {
-	template <> struct range_const_iterator< Column::Ints >		{ typedef Column::Ints::iterator type;		};
-	template <> struct range_const_iterator< Column::Doubles >	{ typedef Column::Doubles::iterator type;	};
+	template <> struct range_const_iterator< Column::Ints >		{ typedef Column::Ints::const_iterator type;	};
+	template <> struct range_const_iterator< Column::Doubles >	{ typedef Column::Doubles::const_iterator type;	};
 }
 
 
@@ -0,0 +1,318 @@
+#include "columnbuffer.h"
+#include <cstring>
+#include <climits>
+#include <cmath>
+#include <algorithm>
+
+const size_t ColumnBuffer::CACHE_LINE;
+const size_t ColumnBuffer::SMALL_BYTES;
+const size_t ColumnBuffer::SMALL_HEADER;
+
+ColumnBuffer::ColumnBuffer(SegmentManager * segment, Layout layout)
+	: _segment(segment), _layout(layout), _packed(segment)
+{}
+
+ColumnBuffer::ColumnBuffer(const ColumnBuffer & other)
+	: _segment(other._segment), _layout(other._layout), _packed(other._segment.get())
+{
+	*this = other;
+}
+
+ColumnBuffer::ColumnBuffer(SegmentManager * segment, const ColumnBuffer & other)
+	: _segment(segment), _layout(other._layout), _packed(segment)
+{
+	*this = other;
+}
+
+ColumnBuffer::ColumnBuffer(ColumnBuffer && other)
+	: _segment(other._segment), _bytes(other._bytes), _size(other._size), _capacity(other._capacity), _layout(other._layout), _packed(std::move(other._packed))
+{
+	other._bytes	= nullptr;
+	other._size		= 0;
+	other._capacity	= 0;
+}
+
+ColumnBuffer::~ColumnBuffer()
+{
+	release();
+}
+
+ColumnBuffer & ColumnBuffer::operator=(const ColumnBuffer & other)
+{
+	if(&other == this)
+		return *this;
+
+	if(other.packed())
+	{
+		//A packed copy is what a snapshot of the DataSetVersions usually is, so copy it as it is
+		release();
+		_packed	= other._packed;
+		_layout	= other._layout;
+		_size	= other._size;
+
+		return *this;
+	}
+
+	if(_segment == other._segment)
+	{
+		_share(other);
+		return *this;
+	}
+
+	_packed.release();
+
+	if(shared() || _layout != other._layout || _capacity < other._size)
+	{
+		release();
+		_layout = other._layout;
+		_reallocate(other._size);
+	}
+
+	if(other._size > 0)
+		std::memcpy(_bytes.get(), other._bytes.get(), other._size * elementSize());
+
+	_size = other._size;
+
+	return *this;
+}
+
+ColumnBuffer & ColumnBuffer::operator=(ColumnBuffer && other)
+{
+	if(&other == this)
+		return *this;
+
+	release();
+
+	_segment		= other._segment;
+	_bytes			= other._bytes;
+	_size			= other._size;
+	_capacity		= other._capacity;
+	_layout			= other._layout;
+	_packed			= std::move(other._packed);
+
+	other._bytes	= nullptr;
+	other._size		= 0;
+	other._capacity	= 0;
+
+	return *this;
+}
+
+void ColumnBuffer::setLayout(Layout layout)
+{
+	if(layout == _layout)
+		return;
+
+	unpack();
+
+	size_t	newCapacity	= _size;
+	char *	newBytes	= _allocate(newCapacity, layout);
+
+	if(layout == Layout::doubles)
+	{
+		const int	*	from	= reinterpret_cast<const int*>(_bytes.get());
+		double		*	to		= reinterpret_cast<double*>(newBytes);
+
+		for(size_t row = 0; row < _size; row++)
+			to[row] = from[row] == INT_MIN ? NAN : double(from[row]);
+	}
+	else
+	{
+		const double	*	from	= reinterpret_cast<const double*>(_bytes.get());
+		int				*	to		= reinterpret_cast<int*>(newBytes);
+
+		for(size_t row = 0; row < _size; row++)
+			to[row] = std::isnan(from[row]) || from[row] > INT_MAX || from[row] < INT_MIN ? INT_MIN : int(from[row]);
+	}
+
+	_dropBytes();
+
+	_bytes		= newBytes;
+	_capacity	= newCapacity;
+	_layout		= layout;
+}
+
+void ColumnBuffer::resize(size_t rows)
+{
+	unpack();
+
+	if(rows > _capacity)
+		_reallocate(std::max(rows, _capacity + _capacity / 2)); //Grow by at least 50% to keep repeated appends amortized
+	else if(shared())
+		_reallocate(_capacity);
+
+	if(rows > _size)
+		std::memset(_bytes.get() + _size * elementSize(), 0, (rows - _size) * elementSize());
+
+	_size = rows;
+}
+
+void ColumnBuffer::insertRows(size_t row, size_t count)
+{
+	if(count == 0)
+		return;
+
+	unpack();
+
+	row = std::min(row, _size);
+
+	if(_size + count > _capacity)
+		_reallocate(std::max(_size + count, _capacity + _capacity / 2));
+	else if(shared())
+		_reallocate(_capacity);
+
+	char * at = _bytes.get() + row * elementSize();
+	std::memmove(at + count * elementSize(), at, (_size - row) * elementSize());
+
+	if(_layout == Layout::doubles)	std::fill_n(reinterpret_cast<double*>(at),	count, double(NAN));
+	else							std::fill_n(reinterpret_cast<int*>(at),		count, INT_MIN);
+
+	_size += count;
+}
+
+void ColumnBuffer::eraseRows(size_t row, size_t count)
+{
+	if(row >= _size || count == 0)
+		return;
+
+	_prepareWrite();
+
+	count = std::min(count, _size - row);
+
+	char * at = _bytes.get() + row * elementSize();
+	std::memmove(at, at + count * elementSize(), (_size - row - count) * elementSize());
+
+	_size -= count;
+}
+
+void ColumnBuffer::reserve(size_t rows)
+{
+	unpack();
+
+	if(rows > _capacity)
+		_reallocate(rows);
+	else if(shared())
+		_reallocate(_capacity);
+}
+
+void ColumnBuffer::release()
+{
+	_packed.release();
+	_dropBytes();
+
+	_bytes		= nullptr;
+	_size		= 0;
+	_capacity	= 0;
+}
+
+char * ColumnBuffer::_allocate(size_t & capacity, Layout layout)
+{
+	if(capacity == 0)
+		return nullptr;
+
+	//Round up to whole cache lines, or header sizes for small arrays, the extra elements are free anyway
+	size_t	bytes	= capacity * elementSize(layout),
+			align	= _headerBytes(bytes);
+
+	bytes		= ((bytes + align - 1) / align) * align;
+	capacity	= bytes / elementSize(layout);
+
+	char * payload	= static_cast<char*>(align == CACHE_LINE ? _segment->allocate_aligned(CACHE_LINE + bytes, CACHE_LINE) : _segment->allocate(SMALL_HEADER + bytes)); //Throws boost::interprocess::bad_alloc, which is what DataSetPackage::enlargeDataSetIfNecessary is waiting for
+	new (payload) Payload{ {1} };
+
+	return payload + align;
+}
+
+void ColumnBuffer::_reallocate(size_t newCapacity)
+{
+	char * newBytes = _allocate(newCapacity, _layout);
+
+	if(_size > 0)
+		std::memcpy(newBytes, _bytes.get(), _size * elementSize());
+
+	_dropBytes();
+
+	_bytes		= newBytes;
+	_capacity	= newCapacity;
+}
+
+void ColumnBuffer::_share(const ColumnBuffer & other)
+{
+	if(other._bytes)
+		other._payload()->owners++; //Before release(), in case we already share it and are its last other owner
+
+	release();
+
+	_bytes		= other._bytes;
+	_capacity	= other._capacity;
+	_size		= other._size;
+	_layout		= other._layout;
+}
+
+void ColumnBuffer::_dropBytes()
+{
+	if(!_bytes)
+		return;
+
+	Payload * payload = _payload(); //Before _capacity changes, that tells how big its header is
+
+	if(--payload->owners == 0)
+	{
+		payload->~Payload();
+		_segment->deallocate(payload);
+	}
+}
+
+bool ColumnBuffer::pack()
+{
+	if(_layout != Layout::ints || packed() || _size == 0)
+		return packed();
+
+	try
+	{
+		if(!_packed.encode(reinterpret_cast<const int*>(_bytes.get()), _size))
+			return false;
+	}
+	catch(boost::interprocess::bad_alloc &)
+	{
+		return false; //Packing is there to save memory, not worth growing the segment for
+	}
+
+	_dropBytes(); //The others that share it keep it, packed or not
+	_bytes		= nullptr;
+	_capacity	= 0;
+
+	return true;
+}
+
+void ColumnBuffer::unpack()
+{
+	if(!packed())
+		return;
+
+	size_t	newCapacity	= _size;
+	char *	newBytes	= _allocate(newCapacity, _layout);
+
+	_packed.decode(0, _size, reinterpret_cast<int*>(newBytes));
+	_packed.release();
+
+	_bytes		= newBytes;
+	_capacity	= newCapacity;
+}
+
+void ColumnBuffer::readInts(size_t from, size_t count, int * out) const
+{
+	if(from + count > _size)
+		count = from < _size ? _size - from : 0;
+
+	if(packed())		_packed.decode(from, count, out);
+	else if(ints())		std::memcpy(out, ints() + from, count * sizeof(int));
+	else				std::fill(out, out + count, INT_MIN);
+}
+
+int ColumnBuffer::intAt(size_t row) const
+{
+	if(row >= _size)	return INT_MIN;
+	if(packed())		return _packed.at(row);
+
+	return ints() ? ints()[row] : INT_MIN;
+}
@@ -0,0 +1,108 @@
+#ifndef COLUMNBUFFER_H
+#define COLUMNBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+#include <boost/interprocess/managed_shared_memory.hpp>
+#include <boost/interprocess/offset_ptr.hpp>
+#include "columnencoding.h"
+
+/*
+ * ColumnBuffer is the storage of the values of a single Column.
+ * It is one contiguous, cache-line aligned array in the shared memory segment, so indexing a row is a single
+ * pointer addition instead of a lookup in a map of blocks. It grows geometrically, so appending rows stays amortized O(1).
+ * All pointers are offset_ptrs, so the buffer can be read from the Engines as well as from the Desktop,
+ * and it keeps working after SharedMemory::enlargeDataSet grew (and remapped) the segment.
+ *
+ * The elements are either ints (nominal, nominalText and ordinal) or doubles (scale), each stored at their own width.
+ * Changing the layout reallocates the buffer and converts the values, INT_MIN <-> NaN being the missing value.
+ *
+ * Ints can be packed into a ColumnEncoding, which frees the plain array. The non-const ints() unpacks them again, because
+ * whoever asks for it wants to write. Readers, including the Engines, use readInts() and intAt() which work either way.
+ *
+ * The array is copy-on-write: a copy in the same segment shares it, and the cache line in front of the values counts its owners.
+ * So a duplicated column, or a snapshot that DataSetVersions keeps, costs nothing until one of them is written to.
+ * Everything that writes (the non-const ints() and doubles() and all that resizes) first gets a private array if it is shared.
+ * A packed buffer is copied as it is, that is small already, and a copy into another segment always copies the values.
+ *
+ * Arrays of at most SMALL_BYTES are not cache-line aligned but only to SMALL_HEADER, with their count of owners in that header.
+ * Wide data has tens of thousands of such short columns, and aligning each to a cache line wasted about a third of their memory.
+ */
+class ColumnBuffer
+{
+public:
+	typedef boost::interprocess::managed_shared_memory::segment_manager SegmentManager;
+
+	enum class Layout { ints, doubles };
+
+	static const size_t CACHE_LINE		= 64,
+						SMALL_BYTES		= 16 * CACHE_LINE,
+						SMALL_HEADER	= 16;
+
+	ColumnBuffer(SegmentManager * segment, Layout layout = Layout::ints);
+	ColumnBuffer(const ColumnBuffer & other);
+	ColumnBuffer(SegmentManager * segment, const ColumnBuffer & other); ///< Copies other into segment, without the unused capacity
+	ColumnBuffer(ColumnBuffer && other);
+	~ColumnBuffer();
+
+	ColumnBuffer & operator=(const ColumnBuffer & other);
+	ColumnBuffer & operator=(ColumnBuffer && other);
+
+	size_t			size()				const	{ return _size;			}
+	size_t			capacity()			const	{ return _capacity;		}
+	Layout			layout()			const	{ return _layout;		}
+	SegmentManager *	segment()		const	{ return _segment.get();	}
+	size_t			elementSize()		const	{ return elementSize(_layout); }
+	size_t			bytesUsed()			const	{ return _capacity * elementSize() / owners() + _packed.bytesUsed(); }	///< A shared array is divided over its owners, so adding it up for all columns counts it once
+	size_t			bytesUnused()		const	{ return packed() ? 0 : (_capacity - _size) * elementSize() / owners(); }
+	bool			packed()			const	{ return _packed.kind() != ColumnEncoding::Kind::none; }
+	bool			shared()			const	{ return owners() > 1; }
+	size_t			owners()			const	{ return _bytes ? _payload()->owners.load() : 1; }
+	const void	*	payload()			const	{ return _bytes.get(); }	///< Is the same for buffers that share their values, nullptr when packed or empty
+
+	static size_t	elementSize(Layout layout)	{ return layout == Layout::doubles ? sizeof(double) : sizeof(int); }
+
+	///These return nullptr if the buffer does not have the requested layout, so nobody reads doubles out of an int column.
+	///The const ints() also returns nullptr while packed. The non-const ones unpack and unshare, so they can throw boost::interprocess::bad_alloc.
+			int		*	ints()						{ _prepareWrite(); return _layout == Layout::ints	? reinterpret_cast<int*>(_bytes.get())			: nullptr; }
+	const	int		*	ints()				const	{ return _layout == Layout::ints	? reinterpret_cast<const int*>(_bytes.get())	: nullptr; }
+			double	*	doubles()					{ _prepareWrite(); return _layout == Layout::doubles	? reinterpret_cast<double*>(_bytes.get())		: nullptr; }
+	const	double	*	doubles()			const	{ return _layout == Layout::doubles	? reinterpret_cast<const double*>(_bytes.get())	: nullptr; }
+
+	void			setLayout(Layout layout);	///< Reallocates to the width of the new layout and converts the values that are there.
+	void			resize(size_t rows);		///< New rows are zeroed, removed rows keep their memory so growing again is free.
+	void			reserve(size_t rows);		///< Makes sure there is room for rows without reallocating.
+	void			insertRows(size_t row, size_t count);	///< Moves the rows from row on count further and makes the new ones missing (INT_MIN or NaN), growing like resize does.
+	void			eraseRows(size_t row, size_t count);	///< Moves the rows after them back, keeping the memory just like resize.
+	void			release();					///< Gives all memory back to the segment.
+
+	bool			pack();						///< Encodes the ints if that at least halves their size, returns whether they are packed now.
+	void			unpack();					///< Decodes them into a plain array again, throws boost::interprocess::bad_alloc if there is no room for that.
+	void			readInts(size_t from, size_t count, int * out)	const;	///< Packed or not
+	int				intAt(size_t row)								const;	///< INT_MIN for rows that do not exist or a buffer of doubles
+
+private:
+	///Lives in the cache line (or SMALL_HEADER) in front of the values, so the values themselves stay aligned
+	struct Payload
+	{
+		std::atomic<uint32_t> owners;
+	};
+
+	static size_t	_headerBytes(size_t bytes)	{ return bytes <= SMALL_BYTES ? SMALL_HEADER : CACHE_LINE; }
+	Payload		*	_payload()		const	{ return reinterpret_cast<Payload*>(_bytes.get() - _headerBytes(_capacity * elementSize())); }
+	void			_prepareWrite()			{ if(packed()) unpack(); else if(shared()) _reallocate(_capacity); }
+
+	char		*	_allocate(size_t & capacity, Layout layout);
+	void			_reallocate(size_t newCapacity);	///< Also what gives a shared buffer its own array
+	void			_share(const ColumnBuffer & other);
+	void			_dropBytes();						///< Lets go of _bytes, and deallocates them if this was the last owner
+
+	boost::interprocess::offset_ptr<SegmentManager>	_segment;
+	boost::interprocess::offset_ptr<char>			_bytes;
+	size_t											_size		= 0,
+													_capacity	= 0;
+	Layout											_layout;
+	ColumnEncoding									_packed;
+};
+
+#endif // COLUMNBUFFER_H
@@ -0,0 +1,165 @@
+#include "columndescriptives.h"
+#include <cmath>
+#include <climits>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+///R's default quantile (type 7) of count sorted values, valueAt(i) gives the i-th smallest
+template<typename ValueAt>
+static double quantileType7(size_t count, double p, ValueAt valueAt)
+{
+	if (count == 0)
+		return NAN;
+
+	double	position	= std::min(std::max(p, 0.0), 1.0) * (count - 1);
+	size_t	below		= size_t(position);
+	double	fraction	= position - below,
+			low			= valueAt(below);
+
+	return fraction == 0 ? low : low + fraction * (valueAt(below + 1) - low);
+}
+
+ColumnDescriptives::Summary ColumnDescriptives::summarize(const Column & column, const FilterBitmap * filter, const std::vector<double> & probabilities)
+{
+	Summary	summary;
+	bool	filtered			= filter && !filter->allPass(),
+			countFrequencies	= column.getColumnType() != columnType::scale;
+
+	//Everything but the frequencies is already known if the stats and the sort index are up to date, then only the quantiles need a few rows
+	const ColumnSortIndex & sorted = column.sortIndex();
+
+	if (!filtered && !countFrequencies && column.stats().valid() && (probabilities.empty() || sorted.current(column.contentVersion())))
+	{
+		_takeStats(column.stats(), summary);
+
+		for (double p : probabilities)
+			summary.quantiles.push_back(quantileType7(sorted.valueCount(), p, [&](size_t i) { double value; column.readInto(&value, sorted[i], 1); return value; }));
+
+		return summary;
+	}
+
+	std::vector<size_t>	rows;
+	std::vector<double>	values;
+
+	if (filtered)
+		filter->passingRows(rows);
+
+	_readValues(column, filtered ? &rows : nullptr, values);
+	_summarizeValues(values, countFrequencies, probabilities, summary);
+
+	return summary;
+}
+
+ColumnDescriptives::GroupedSummaries ColumnDescriptives::summarizeGrouped(const Column & column, const Column & groupBy, const FilterBitmap * filter, const std::vector<double> & probabilities)
+{
+	if (groupBy.getColumnType() == columnType::scale)
+		throw std::runtime_error("Column '" + groupBy.name() + "' is scale and cannot be used to split '" + column.name() + "' into groups");
+
+	bool				filtered	= filter && !filter->allPass();
+	std::vector<size_t>	rows;
+	std::vector<double>	values;
+	std::vector<int>	groups;
+
+	if (filtered)
+		filter->passingRows(rows);
+
+	_readValues(column, filtered ? &rows : nullptr, values);
+
+	if (filtered)
+	{
+		groups.resize(rows.size());
+		groupBy.gatherInto(groups.data(), rows);
+	}
+	else
+	{
+		groups.resize(values.size(), INT_MIN);
+		groupBy.readInto(groups.data(), 0, groups.size()); //If groupBy is shorter the rest stays missing
+	}
+
+	//Split the values per group in one pass, groups are few so most rows go to the group of the row before
+	std::unordered_map<int, size_t>		groupIndex;
+	std::vector<int>					groupKeys;
+	std::vector<std::vector<double>>	groupValues;
+	int									lastGroup		= INT_MIN;
+	size_t								lastGroupIndex	= SIZE_MAX;
+
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		if (groups[i] != lastGroup || lastGroupIndex == SIZE_MAX)
+		{
+			auto found = groupIndex.find(groups[i]);
+
+			if (found == groupIndex.end())
+			{
+				found = groupIndex.insert(std::make_pair(groups[i], groupValues.size())).first;
+				groupKeys.push_back(groups[i]);
+				groupValues.push_back({});
+			}
+
+			lastGroup		= groups[i];
+			lastGroupIndex	= found->second;
+		}
+
+		groupValues[lastGroupIndex].push_back(values[i]);
+	}
+
+	GroupedSummaries	summaries;
+	bool				countFrequencies = column.getColumnType() != columnType::scale;
+
+	for (size_t g = 0; g < groupKeys.size(); g++)
+		_summarizeValues(groupValues[g], countFrequencies, probabilities, summaries[groupKeys[g]]);
+
+	return summaries;
+}
+
+void ColumnDescriptives::_readValues(const Column & column, const std::vector<size_t> * rows, std::vector<double> & values)
+{
+	if (rows)
+	{
+		values.resize(rows->size());
+		column.gatherInto(values.data(), *rows);
+	}
+	else
+	{
+		values.resize(column.rowCount());
+		column.readInto(values.data(), 0, values.size());
+	}
+}
+
+void ColumnDescriptives::_summarizeValues(std::vector<double> & values, bool countFrequencies, const std::vector<double> & probabilities, Summary & summary)
+{
+	ColumnStats stats;
+	stats.reset();
+
+	for (double value : values)
+		stats.add(value);
+
+	_takeStats(stats, summary);
+
+	if (countFrequencies)
+		for (double value : values)
+			if (!std::isnan(value))
+				summary.frequencies[int(value)]++;
+
+	if (probabilities.empty())
+		return;
+
+	//The missing values are moved to the back, only the others are sorted
+	auto valuesEnd = std::remove_if(values.begin(), values.end(), [](double value) { return std::isnan(value); });
+	std::sort(values.begin(), valuesEnd);
+
+	for (double p : probabilities)
+		summary.quantiles.push_back(quantileType7(stats.count(), p, [&](size_t i) { return values[i]; }));
+}
+
+void ColumnDescriptives::_takeStats(const ColumnStats & stats, Summary & summary)
+{
+	summary.count		= stats.count();
+	summary.missing		= stats.missing();
+	summary.mean		= stats.mean();
+	summary.variance	= stats.variance();
+	summary.min			= stats.min();
+	summary.max			= stats.max();
+}
@@ -0,0 +1,46 @@
+#ifndef COLUMNDESCRIPTIVES_H
+#define COLUMNDESCRIPTIVES_H
+
+#include <cmath>
+#include <map>
+#include <vector>
+#include "column.h"
+#include "filterbitmap.h"
+
+/*
+ * ColumnDescriptives computes the summaries everyone asks for of a Column straight from shared memory: counts, mean, variance, extremes, quantiles and frequencies.
+ * That way the Desktop does not need an Engine for them and the Engines (see .columnDescriptivesNative in R) don't need to copy the column into R first.
+ * The values are read in one go with Column::readInto/gatherInto, so packed columns are decoded a batch at a time, and then summed in a single loop.
+ * Without a filter the ColumnStats and ColumnSortIndex of the column are used when they are current, so often nothing has to be read at all.
+ * Only the non-missing values count towards everything but missing, variance is the sample variance and the quantiles are R's default (type 7).
+ * Frequencies are only kept for columns that are not scale and are by the ints of the column, so the keys of the labels for nominalText.
+ * A summary can also be split by a column that is not scale, the groups are its ints as well and INT_MIN is the group of the rows where it is missing.
+ * This works on const Columns, so the Engines can call it on the version they pinned as long as they hold the ReadLock.
+ */
+class ColumnDescriptives
+{
+public:
+	struct Summary
+	{
+		size_t					count		= 0,
+								missing		= 0;
+		double					mean		= NAN,
+								variance	= NAN,
+								min			= NAN,
+								max			= NAN;
+		std::vector<double>		quantiles;		///< One per requested probability
+		std::map<int, size_t>	frequencies;	///< Per int value, empty for scale columns
+	};
+
+	typedef std::map<int, Summary> GroupedSummaries;
+
+	static Summary			summarize(			const Column & column,								const FilterBitmap * filter = nullptr, const std::vector<double> & probabilities = {}); ///< filter is optional, only the rows that pass are summarized
+	static GroupedSummaries	summarizeGrouped(	const Column & column,	const Column & groupBy,		const FilterBitmap * filter = nullptr, const std::vector<double> & probabilities = {}); ///< Throws std::runtime_error if groupBy is scale
+
+private:
+	static void				_readValues(		const Column & column, const std::vector<size_t> * rows, std::vector<double> & values);
+	static void				_summarizeValues(	std::vector<double> & values, bool countFrequencies, const std::vector<double> & probabilities, Summary & summary); ///< Sorts values if there are probabilities
+	static void				_takeStats(			const ColumnStats & stats, Summary & summary);
+};
+
+#endif // COLUMNDESCRIPTIVES_H
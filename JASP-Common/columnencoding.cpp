@@ -0,0 +1,284 @@
+#include "columnencoding.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <vector>
+
+const size_t ColumnEncoding::MAX_DICTIONARY;
+const size_t ColumnEncoding::DECODE_BATCH; //std::min takes it by reference
+
+ColumnEncoding::ColumnEncoding(const ColumnEncoding & other)
+	: _segment(other._segment)
+{
+	*this = other;
+}
+
+ColumnEncoding::ColumnEncoding(ColumnEncoding && other)
+	: _segment(other._segment)
+{
+	*this = std::move(other);
+}
+
+ColumnEncoding::~ColumnEncoding()
+{
+	release();
+}
+
+ColumnEncoding & ColumnEncoding::operator=(const ColumnEncoding & other)
+{
+	if(&other == this)
+		return *this;
+
+	release();
+
+	if(other._bytes > 0)
+	{
+		_allocate(other._bytes);
+		std::memcpy(_words.get(), other._words.get(), _bytes);
+	}
+
+	_rows		= other._rows;
+	_entries	= other._entries;
+	_kind		= other._kind;
+	_bits		= other._bits;
+	_reference	= other._reference;
+
+	return *this;
+}
+
+ColumnEncoding & ColumnEncoding::operator=(ColumnEncoding && other)
+{
+	if(&other == this)
+		return *this;
+
+	release();
+
+	_segment	= other._segment;
+	_words		= other._words;
+	_bytes		= other._bytes;
+	_rows		= other._rows;
+	_entries	= other._entries;
+	_kind		= other._kind;
+	_bits		= other._bits;
+	_reference	= other._reference;
+
+	other._words	= nullptr;
+	other._bytes	= 0;
+	other._rows		= 0;
+	other._kind		= Kind::none;
+
+	return *this;
+}
+
+void ColumnEncoding::release()
+{
+	if(_words)
+		_segment->deallocate(_words.get());
+
+	_words	= nullptr;
+	_bytes	= 0;
+	_rows	= 0;
+	_kind	= Kind::none;
+}
+
+unsigned ColumnEncoding::_bitsFor(size_t codes)
+{
+	unsigned bits = 1;
+
+	while(bits < 16 && (size_t(1) << bits) < codes)
+		bits *= 2;
+
+	return bits;
+}
+
+size_t ColumnEncoding::_codeBytes(size_t rows, unsigned bits)
+{
+	size_t perWord = 64 / bits;
+
+	return ((rows + perWord - 1) / perWord) * sizeof(uint64_t);
+}
+
+void ColumnEncoding::_allocate(size_t bytes)
+{
+	//Throws boost::interprocess::bad_alloc, in which case nothing was changed yet
+	_words	= static_cast<uint64_t*>(_segment->allocate_aligned(bytes, 64));
+	_bytes	= bytes;
+
+	std::memset(_words.get(), 0, bytes);
+}
+
+void ColumnEncoding::_packCode(uint64_t * codes, size_t row, uint64_t code)
+{
+	size_t perWord = 64 / _bits;
+
+	codes[row / perWord] |= code << ((row % perWord) * _bits);
+}
+
+bool ColumnEncoding::encode(const int * values, size_t rows)
+{
+	release();
+
+	if(rows == 0 || rows > UINT32_MAX)
+		return false;
+
+	//A single pass to find out how large each of the encodings would be
+	std::vector<int>	distinct;
+	bool				fitsDictionary	= true;
+	int					minimum			= INT_MAX,
+						maximum			= INT_MIN;
+	size_t				runs			= 1;
+
+	for(size_t row = 0; row < rows; row++)
+	{
+		int value = values[row];
+
+		if(row > 0 && value == values[row - 1])
+			continue; //Nothing new to learn from a value that is the same as the one before
+
+		if(row > 0)
+			runs++;
+
+		if(value != INT_MIN)
+		{
+			minimum = std::min(minimum, value);
+			maximum = std::max(maximum, value);
+		}
+
+		if(fitsDictionary)
+		{
+			auto entry = std::lower_bound(distinct.begin(), distinct.end(), value);
+
+			if(entry == distinct.end() || *entry != value)
+			{
+				if(distinct.size() == MAX_DICTIONARY)	fitsDictionary = false;
+				else									distinct.insert(entry, value);
+			}
+		}
+	}
+
+	const size_t	doesNotFit			= SIZE_MAX,
+					dictionaryBytes		= !fitsDictionary ? doesNotFit : ((distinct.size() * sizeof(int) + sizeof(uint64_t) - 1) / sizeof(uint64_t)) * sizeof(uint64_t) + _codeBytes(rows, _bitsFor(distinct.size())),
+					runLengthBytes		= rows > UINT32_MAX ? doesNotFit : runs * sizeof(Run), //Run::end is 32 bits
+					referenceCodes		= 1 + (minimum > maximum ? 0 : size_t(int64_t(maximum) - int64_t(minimum)) + 1), //Code 0 is for INT_MIN
+					referenceBytes		= referenceCodes > (size_t(1) << 16) ? doesNotFit : _codeBytes(rows, _bitsFor(referenceCodes)),
+					smallest			= std::min(dictionaryBytes, std::min(runLengthBytes, referenceBytes));
+
+	if(smallest > (rows * sizeof(int)) / 2)
+		return false;
+
+	_allocate(smallest);
+
+	if(smallest == referenceBytes)
+	{
+		_kind		= Kind::frameOfReference;
+		_bits		= _bitsFor(referenceCodes);
+		_reference	= minimum;
+
+		for(size_t row = 0; row < rows; row++)
+			if(values[row] != INT_MIN)
+				_packCode(_words.get(), row, uint64_t(int64_t(values[row]) - int64_t(minimum)) + 1);
+	}
+	else if(smallest == runLengthBytes)
+	{
+		_kind		= Kind::runLength;
+		_entries	= runs;
+
+		Run * run = reinterpret_cast<Run*>(_words.get());
+
+		for(size_t row = 0; row < rows; row++)
+			if(row + 1 == rows || values[row + 1] != values[row])
+				*run++ = Run{ values[row], uint32_t(row + 1) };
+	}
+	else
+	{
+		_kind		= Kind::dictionary;
+		_entries	= distinct.size();
+		_bits		= _bitsFor(_entries);
+
+		std::copy(distinct.begin(), distinct.end(), reinterpret_cast<int*>(_words.get()));
+
+		uint64_t * codes = const_cast<uint64_t*>(_dictCodes());
+
+		for(size_t row = 0; row < rows; row++)
+			_packCode(codes, row, std::lower_bound(distinct.begin(), distinct.end(), values[row]) - distinct.begin());
+	}
+
+	_rows = rows;
+
+	return true;
+}
+
+template<typename CodeToValue>
+void ColumnEncoding::_unpackCodes(const uint64_t * codes, size_t from, size_t count, int * out, CodeToValue codeToValue) const
+{
+	const size_t	perWord	= 64 / _bits;
+	const uint64_t	mask	= (uint64_t(1) << _bits) - 1;
+	size_t			row		= from,
+					until	= from + count;
+
+	//One by one up to the start of a word, then a whole word at a time and then the rest
+	for(; row < until && row % perWord != 0; row++)
+		*out++ = codeToValue((codes[row / perWord] >> ((row % perWord) * _bits)) & mask);
+
+	for(; row + perWord <= until; row += perWord)
+	{
+		uint64_t word = codes[row / perWord];
+
+		for(size_t code = 0; code < perWord; code++, word >>= _bits)
+			*out++ = codeToValue(word & mask);
+	}
+
+	for(; row < until; row++)
+		*out++ = codeToValue((codes[row / perWord] >> ((row % perWord) * _bits)) & mask);
+}
+
+void ColumnEncoding::decode(size_t from, size_t count, int * out) const
+{
+	if(from + count > _rows)
+		count = from < _rows ? _rows - from : 0;
+
+	switch(_kind)
+	{
+	case Kind::dictionary:
+	{
+		const int * dictionary = _dictionary();
+		_unpackCodes(_dictCodes(), from, count, out, [dictionary](uint64_t code) { return dictionary[code]; });
+		break;
+	}
+
+	case Kind::frameOfReference:
+	{
+		const int64_t reference = _reference;
+		_unpackCodes(_words.get(), from, count, out, [reference](uint64_t code) { return code == 0 ? INT_MIN : int(reference + int64_t(code) - 1); });
+		break;
+	}
+
+	case Kind::runLength:
+	{
+		const Run	*	runs	= _runs(),
+					*	run		= std::upper_bound(runs, runs + _entries, from, [](size_t row, const Run & run) { return row < run.end; });
+
+		for(size_t row = from, until = from + count; row < until; run++)
+		{
+			size_t runUntil = std::min(size_t(run->end), until);
+
+			std::fill(out + (row - from), out + (runUntil - from), run->value);
+			row = runUntil;
+		}
+		break;
+	}
+
+	case Kind::none:
+		break;
+	}
+}
+
+int ColumnEncoding::at(size_t row) const
+{
+	int value = INT_MIN;
+
+	if(row < _rows)
+		decode(row, 1, &value);
+
+	return value;
+}
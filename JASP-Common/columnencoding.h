@@ -0,0 +1,74 @@
+#ifndef COLUMNENCODING_H
+#define COLUMNENCODING_H
+
+#include <cstdint>
+#include <boost/interprocess/managed_shared_memory.hpp>
+#include <boost/interprocess/offset_ptr.hpp>
+
+/*
+ * ColumnEncoding is a compressed, read-only copy of the ints of a ColumnBuffer in the shared memory segment.
+ * Most nominal and ordinal columns have only a handful of levels, so four bytes per row is mostly zeroes. There are three encodings:
+ *  - dictionary:		the distinct values (at most MAX_DICTIONARY, sorted) and per row the index into those, bit-packed.
+ *  - runLength:		the value and the end of every run of equal values, for sorted or grouped columns.
+ *  - frameOfReference:	per row the distance to the smallest value, bit-packed, for ints that lie close together.
+ * encode() picks whichever is smallest. Codes are 1, 2, 4, 8 or 16 bits wide so they never straddle a 64-bit word,
+ * and decode() unpacks a word at a time so it can be used to read batches of rows quickly.
+ * INT_MIN (missing) is just another dictionary entry or run, and code 0 in frameOfReference.
+ */
+class ColumnEncoding
+{
+public:
+	typedef boost::interprocess::managed_shared_memory::segment_manager SegmentManager;
+
+	enum class Kind { none, dictionary, runLength, frameOfReference };
+
+	static const size_t MAX_DICTIONARY	= 256;
+	static const size_t DECODE_BATCH	= 4096; ///< Rows per batch for readers that decode a column bit by bit
+
+	ColumnEncoding(SegmentManager * segment) : _segment(segment) {}
+	ColumnEncoding(const ColumnEncoding & other);
+	ColumnEncoding(ColumnEncoding && other);
+	~ColumnEncoding();
+
+	ColumnEncoding & operator=(const ColumnEncoding & other);
+	ColumnEncoding & operator=(ColumnEncoding && other);
+
+	Kind	kind()		const { return _kind;	}
+	size_t	size()		const { return _rows;	}
+	size_t	bytesUsed()	const { return _bytes;	}
+
+	bool	encode(const int * values, size_t rows);				///< Returns false and keeps nothing if no encoding takes at most half of the plain ints
+	void	decode(size_t from, size_t count, int * out)	const;
+	int		at(size_t row)									const;
+	void	release();
+
+private:
+	struct Run
+	{
+		int			value;
+		uint32_t	end;	///< One past the last row of the run
+	};
+
+	template<typename CodeToValue>
+	void				_unpackCodes(const uint64_t * codes, size_t from, size_t count, int * out, CodeToValue codeToValue) const;
+	void				_packCode(uint64_t * codes, size_t row, uint64_t code);
+	static unsigned		_bitsFor(size_t codes);
+	static size_t		_codeBytes(size_t rows, unsigned bits);
+
+	const int		*	_dictionary()	const { return reinterpret_cast<const int*>(_words.get());								}
+	const uint64_t	*	_dictCodes()	const { return _words.get() + (_entries * sizeof(int) + sizeof(uint64_t) - 1) / sizeof(uint64_t);	}
+	const Run		*	_runs()			const { return reinterpret_cast<const Run*>(_words.get());								}
+
+	void				_allocate(size_t bytes);
+
+	boost::interprocess::offset_ptr<SegmentManager>	_segment;
+	boost::interprocess::offset_ptr<uint64_t>		_words;		///< dictionary: the entries, padded to a word, followed by the codes. runLength: the Runs. frameOfReference: the codes
+	size_t											_rows		= 0,
+													_bytes		= 0,
+													_entries	= 0;	///< Number of dictionary entries or runs
+	Kind											_kind		= Kind::none;
+	unsigned										_bits		= 0;
+	int												_reference	= 0;	///< The smallest value, for frameOfReference
+};
+
+#endif // COLUMNENCODING_H
@@ -21,6 +21,9 @@
 
 #include "sharedmemory.h"
 
+#include <set>
+#include <algorithm>
+
 using namespace std;
 using boost::interprocess::offset_ptr;
 
@@ -63,29 +66,91 @@ void Columns::setRowCount(size_t rowCount)
 
 void Columns::setColumnCount(size_t columnCount)
 {
-	_columnStore.reserve(columnCount);
+	//Grown geometrically, adding columns one at a time to tens of thousands of them shouldn't move all of them every time
+	if(columnCount > _columnStore.capacity())
+		_columnStore.reserve(std::max(columnCount, _columnStore.capacity() + _columnStore.capacity() / 2));
+
 	for (size_t i = _columnStore.size(); i < columnCount; i++)
 		_columnStore.push_back(Column(_mem));
+
+	_rebuildNameIndex();
 }
 
 
 void Columns::removeColumn(size_t index)
 {
-	_columnStore.erase(_columnStore.begin() + index);
+	removeColumns(index, 1);
+}
+
+void Columns::insertColumns(size_t index, size_t count)
+{
+	if(count == 0)
+		return;
+
+	size_t rows = maxRowCount();
+
+	index = std::min(index, columnCount());
+
+	_columnStore.insert(_columnStore.begin() + index, count, Column(_mem));
+
+	try
+	{
+		for(size_t i = index; i < index + count; i++)
+			_columnStore[i]._setRowCount(rows);
+	}
+	catch (boost::interprocess::bad_alloc &)
+	{
+		removeColumns(index, count); //So that retrying after growing the segment does not add them twice
+		throw;
+	}
+
+	_rebuildNameIndex(); //Once for all of them, the columns after them moved
+}
+
+void Columns::removeColumns(size_t index, size_t count)
+{
+	if(index >= columnCount() || count == 0)
+		return;
+
+	count = std::min(count, columnCount() - index);
+
+	_columnStore.erase(_columnStore.begin() + index, _columnStore.begin() + index + count);
+	_rebuildNameIndex();
 }
 
 void Columns::removeColumn(std::string name)
 {
-	for (ColumnVector::iterator it = _columnStore.begin(); it != _columnStore.end(); ++it)
-		if((*it).name() == name)
-		{
-			_columnStore.erase(it);
-			return;
-		}
+	try						{ removeColumn(findIndexByName(name)); }
+	catch(columnNotFound &)	{}
 }
 
 
-void Columns::setSharedMemory(boost::interprocess::managed_shared_memory *mem)
+Columns::Columns(boost::interprocess::managed_shared_memory::segment_manager *mem, const Columns & other)
+	: _columnStore(mem), _nameIndex(mem), _mem(mem)
+{
+	_columnStore.reserve(other.columnCount());
+
+	std::map<const void*, size_t> copiedValues; //So columns that share their values still do so afterwards
+
+	for(const Column & column : other)
+	{
+		_columnStore.emplace_back(mem, column);
+
+		const void * values = column._data.payload();
+
+		if(!values)
+			continue;
+
+		auto copied = copiedValues.find(values);
+
+		if(copied == copiedValues.end())	copiedValues[values] = _columnStore.size() - 1;
+		else								_columnStore.back()._shareValues(_columnStore[copied->second]);
+	}
+
+	_rebuildNameIndex();
+}
+
+void Columns::setSharedMemory(boost::interprocess::managed_shared_memory::segment_manager *mem)
 {
 	_mem = mem;
 
@@ -95,11 +160,97 @@ void Columns::setSharedMemory(boost::interprocess::managed_shared_memory *mem)
 
 size_t Columns::findIndexByName(std::string name) const
 {
-		for(size_t i=0; i<_columnStore.size(); i++)
-			if(_columnStore[i].name() == name)
-				return i;
+	if(_nameIndex.empty())
+		throw columnNotFound(name);
+
+	uint64_t	hash	= _hashName(name);
+	size_t		mask	= _nameIndex.size() - 1,
+				found	= SIZE_MAX;
+
+	//Keep going until the end of the probe so that, as before, the first of columns with the same name is the one found
+	for(size_t slot = hash & mask; _nameIndex[slot].index != EMPTY_SLOT; slot = (slot + 1) & mask)
+	{
+		const NameSlot & nameSlot = _nameIndex[slot];
+
+		if(nameSlot.index != REMOVED_SLOT && nameSlot.hash == hash && size_t(nameSlot.index) < found && _columnStore[nameSlot.index].name() == name)
+			found = nameSlot.index;
+	}
+
+	if(found == SIZE_MAX)
+		throw columnNotFound(name);
+
+	return found;
+}
+
+void Columns::setColumnName(size_t index, std::string name)
+{
+	Column & column = at(index);
 
-	throw columnNotFound(name);
+	_eraseName(index, column.name());
+	column.setName(name);
+	_insertName(index, name);
+}
+
+uint64_t Columns::_hashName(const std::string & name)
+{
+	//FNV-1a, std::hash is not guaranteed to be the same in the Desktop and the Engines
+	uint64_t hash = 14695981039346656037ULL;
+
+	for(unsigned char c : name)
+		hash = (hash ^ c) * 1099511628211ULL;
+
+	return hash;
+}
+
+void Columns::_rebuildNameIndex()
+{
+	size_t slots = 16;
+
+	while(slots < _columnStore.size() * 2)
+		slots *= 2;
+
+	_nameIndex.assign(slots, NameSlot{ 0, EMPTY_SLOT });
+	_nameSlotsUsed = 0;
+
+	for(size_t i=0; i<_columnStore.size(); i++)
+		_insertName(i, _columnStore[i].name());
+}
+
+void Columns::_insertName(size_t index, const std::string & name)
+{
+	if((_nameSlotsUsed + 1) * 4 > _nameIndex.size() * 3)
+	{
+		_rebuildNameIndex(); //Picks up the name from the column itself, and gets rid of the removed slots
+		return;
+	}
+
+	uint64_t	hash	= _hashName(name);
+	size_t		mask	= _nameIndex.size() - 1,
+				slot	= hash & mask;
+
+	while(_nameIndex[slot].index >= 0)
+		slot = (slot + 1) & mask;
+
+	if(_nameIndex[slot].index == EMPTY_SLOT)
+		_nameSlotsUsed++;
+
+	_nameIndex[slot] = NameSlot{ hash, int(index) };
+}
+
+void Columns::_eraseName(size_t index, const std::string & name)
+{
+	if(_nameIndex.empty())
+		return;
+
+	uint64_t	hash	= _hashName(name);
+	size_t		mask	= _nameIndex.size() - 1;
+
+	for(size_t slot = hash & mask; _nameIndex[slot].index != EMPTY_SLOT; slot = (slot + 1) & mask)
+		if(_nameIndex[slot].index == int(index) && _nameIndex[slot].hash == hash)
+		{
+			_nameIndex[slot].index = REMOVED_SLOT;
+			return;
+		}
 }
 
 
@@ -107,12 +258,55 @@ Column * Columns::initializeColumnAs(int colIndex, std::string name)
 {
 	Column * column = &at(colIndex);
 
-	column->setName(name);
+	setColumnName(colIndex, name);
 	column->_setRowCount(maxRowCount());
 
 	return column;
 }
 
+Column * Columns::duplicateColumn(size_t index, std::string name)
+{
+	Column copy(at(index)); //Before it moves, the store might reallocate
+
+	_columnStore.push_back(std::move(copy));
+	setColumnName(columnCount() - 1, name);
+
+	return &_columnStore.back();
+}
+
+Column * Columns::createLabelView(size_t index, std::string name, const std::map<std::string, std::string> & newLabels)
+{
+	const Labels & labels = at(index).labels();
+
+	if(labels.size() == 0)
+		throw std::runtime_error("Column '" + at(index).name() + "' has no labels to give other texts");
+
+	//Two labels with the same text would be two levels with the same name in R, joining them means changing the values and that is not a view anymore
+	std::set<std::string> texts;
+
+	for(const Label & label : labels)
+	{
+		auto		newLabel	= newLabels.find(label.text());
+		std::string	text		= newLabel == newLabels.end() ? label.text() : newLabel->second;
+
+		if(!texts.insert(text).second)
+			throw std::runtime_error("Label '" + text + "' would appear twice in '" + name + "', a view can only give the labels other texts");
+	}
+
+	Column	*	view		= duplicateColumn(index, name);
+	Labels	&	viewLabels	= view->labels();
+
+	for(size_t row = 0; row < viewLabels.size(); row++)
+	{
+		auto newLabel = newLabels.find(viewLabels.getLabelFromRow(row));
+
+		if(newLabel != newLabels.end())
+			viewLabels.setLabelFromRow(row, newLabel->second);
+	}
+
+	return view;
+}
+
 std::vector<std::string> Columns::getColumnNames()
 {
 	std::vector<std::string> columnNames;
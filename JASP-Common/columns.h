@@ -20,6 +20,8 @@
 
 #include "column.h"
 
+#include <map>
+
 #include <boost/interprocess/managed_shared_memory.hpp>
 
 #include <boost/iterator/iterator_facade.hpp>
@@ -36,6 +38,16 @@ struct columnNotFound : public std::runtime_error
 typedef boost::interprocess::allocator<Column, boost::interprocess::managed_shared_memory::segment_manager> ColumnAllocator;
 typedef boost::container::vector<Column, ColumnAllocator> ColumnVector;
 
+/*
+ * Columns also keeps a hash table from column name to index next to the ColumnVector, in shared memory so the Engines use it as well.
+ * It is open addressing with linear probing, each slot has the hash of the name and the index of the column, and a lookup
+ * still compares the name of the column it lands on so a collision can never return the wrong one.
+ * The names can only be changed through setColumnName() and the columns only added or removed through Columns, which keep the table up to date.
+ *
+ * A duplicate of a column shares its values with it (see ColumnBuffer) until one of them is written to, and so does a label view:
+ * a duplicate that only shows other texts for the labels, as those live in the Column itself. Copying Columns into another segment keeps that sharing.
+ */
+
 class Columns
 {
 	friend class DataSet;
@@ -43,7 +55,8 @@ class Columns
 
 public:
 
-	Columns(boost::interprocess::managed_shared_memory *mem) : _columnStore(mem->get_segment_manager()), _mem(mem) { }
+	Columns(boost::interprocess::managed_shared_memory::segment_manager *mem) : _columnStore(mem), _nameIndex(mem), _mem(mem) { }
+	Columns(boost::interprocess::managed_shared_memory::segment_manager *mem, const Columns & other); ///< Copies all columns of other into mem
 
 			size_t	findIndexByName(std::string name) const;
 			Column& at(size_t index)							{ return _columnStore.at(index); }
@@ -53,6 +66,8 @@ public:
 
 	void removeColumn(size_t index);
 	void removeColumn(std::string name);
+	void insertColumns(size_t index, size_t count);	///< count empty columns before index, as long as the longest one
+	void removeColumns(size_t index, size_t count);
 
 	ColumnVector _columnStore;
 
@@ -75,12 +90,35 @@ public:
 
 	Column * initializeColumnAs(int colIndex, std::string name);
 	Column * createColumn(std::string name);
+	Column * duplicateColumn(size_t index, std::string name);	///< Appends a copy of the column that shares its values
+	Column * createLabelView(size_t index, std::string name, const std::map<std::string, std::string> & newLabels); ///< A duplicate with newLabels (old text to new) applied to its labels, throws std::runtime_error if it has none or they would not be unique
 	std::vector<std::string> getColumnNames();
 
+	void setColumnName(size_t index, std::string name);
+
 private:
-	void setSharedMemory(boost::interprocess::managed_shared_memory *mem);
+	struct NameSlot
+	{
+		uint64_t	hash;
+		int			index; ///< EMPTY_SLOT or REMOVED_SLOT if there is no column here
+	};
+
+	typedef boost::interprocess::allocator<NameSlot, boost::interprocess::managed_shared_memory::segment_manager>	NameSlotAllocator;
+	typedef boost::container::vector<NameSlot, NameSlotAllocator>												NameIndex;
+
+	static const int EMPTY_SLOT = -1, REMOVED_SLOT = -2;
+
+	static uint64_t _hashName(const std::string & name);
+	void _rebuildNameIndex();
+	void _insertName(size_t index, const std::string & name);
+	void _eraseName(size_t index, const std::string & name);
+
+	void setSharedMemory(boost::interprocess::managed_shared_memory::segment_manager *mem);
+
+	NameIndex	_nameIndex;
+	size_t		_nameSlotsUsed = 0; ///< Including the removed ones, they still make the probes longer
 
-	boost::interprocess::managed_shared_memory *_mem;
+	boost::interprocess::managed_shared_memory::segment_manager *_mem;
 
 
 	void setRowCount(size_t rowCount);
@@ -0,0 +1,327 @@
+#include "columnsketches.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+const size_t TDigest::COMPRESSION;
+const size_t TDigest::BUFFER_SIZE;
+const size_t HyperLogLog::PRECISION;
+const size_t HyperLogLog::REGISTERS;
+const size_t ColumnSketches::OVERWRITE_TOLERANCE;
+
+namespace
+{
+	const double PI = 3.14159265358979323846;
+
+	///The k1 scale function of the t-digest, a centroid may cover at most one unit of k
+	double	scaleK(double q)		{ return TDigest::COMPRESSION / (2 * PI) * std::asin(2 * q - 1);		}
+	double	scaleKInverse(double k)	{ return (std::sin(k * 2 * PI / TDigest::COMPRESSION) + 1) / 2;		}
+
+	///splitmix64's finalizer, spreads the bits of a value over the whole hash
+	uint64_t hashBits(uint64_t bits)
+	{
+		bits ^= bits >> 30;	bits *= 0xbf58476d1ce4e5b9ULL;
+		bits ^= bits >> 27;	bits *= 0x94d049bb133111ebULL;
+		bits ^= bits >> 31;
+
+		return bits;
+	}
+}
+
+void TDigest::allocate()
+{
+	_centroids.reserve(2 * COMPRESSION);
+	_buffer.reserve(BUFFER_SIZE);
+	clear();
+}
+
+void TDigest::release()
+{
+	boost::container::vector<Centroid,	CentroidAllocator>(_centroids.get_stored_allocator()).swap(_centroids);
+	boost::container::vector<double,	DoubleAllocator>(_buffer.get_stored_allocator()).swap(_buffer);
+	_totalWeight = 0;
+}
+
+void TDigest::clear()
+{
+	_centroids.clear();
+	_buffer.clear();
+	_totalWeight	= 0;
+	_min			= 0;
+	_max			= 0;
+}
+
+void TDigest::add(double value)
+{
+	if (std::isnan(value) || !allocated())
+		return;
+
+	if (count() == 0 || value < _min)	_min = value;
+	if (count() == 0 || value > _max)	_max = value;
+
+	if (_buffer.size() == BUFFER_SIZE)
+		_flush();
+
+	_buffer.push_back(value);
+}
+
+void TDigest::merge(const TDigest & other)
+{
+	if (!allocated() || other.count() == 0)
+		return;
+
+	if (count() == 0 || other._min < _min)	_min = other._min;
+	if (count() == 0 || other._max > _max)	_max = other._max;
+
+	std::vector<Centroid> all(_centroids.begin(), _centroids.end());
+
+	all.insert(all.end(), other._centroids.begin(), other._centroids.end());
+
+	for (double value : _buffer)		all.push_back({ value, 1 });
+	for (double value : other._buffer)	all.push_back({ value, 1 });
+
+	_totalWeight = count() + other.count();
+
+	std::sort(all.begin(), all.end());
+	_compress(all, _totalWeight);
+
+	_buffer.clear();
+	_centroids.assign(all.begin(), all.end());
+}
+
+void TDigest::_flush()
+{
+	if (_buffer.empty())
+		return;
+
+	std::vector<Centroid> all(_centroids.begin(), _centroids.end());
+
+	for (double value : _buffer)
+		all.push_back({ value, 1 });
+
+	_totalWeight += _buffer.size();
+
+	std::sort(all.begin(), all.end());
+	_compress(all, _totalWeight);
+
+	_buffer.clear();
+	_centroids.assign(all.begin(), all.end()); //At most COMPRESSION + 1 of them, so this fits in what allocate() reserved
+}
+
+void TDigest::_compress(std::vector<Centroid> & centroids, double totalWeight)
+{
+	if (centroids.empty())
+		return;
+
+	//Walk through them from small to large and merge each into the one before as long as that doesn't make it cover more than one unit of k
+	size_t	out			= 0;
+	double	weightSoFar	= 0,
+			qLimit		= scaleKInverse(scaleK(0) + 1) * totalWeight;
+
+	for (size_t i = 1; i < centroids.size(); i++)
+	{
+		Centroid	&	current	= centroids[out];
+		const Centroid	next	= centroids[i];
+
+		if (weightSoFar + current.weight + next.weight <= qLimit)
+		{
+			current.weight	+= next.weight;
+			current.mean	+= (next.mean - current.mean) * next.weight / current.weight;
+		}
+		else
+		{
+			weightSoFar		+= current.weight;
+			qLimit			= scaleKInverse(scaleK(std::min(1.0, weightSoFar / totalWeight)) + 1) * totalWeight;
+			centroids[++out] = next;
+		}
+	}
+
+	centroids.resize(out + 1);
+}
+
+double TDigest::quantile(double p) const
+{
+	if (count() == 0)
+		return NAN;
+
+	std::vector<Centroid> centroids(_centroids.begin(), _centroids.end());
+
+	if (!_buffer.empty())
+	{
+		//Reading must not change the digest, so the buffered values are merged into a copy
+		for (double value : _buffer)
+			centroids.push_back({ value, 1 });
+
+		std::sort(centroids.begin(), centroids.end());
+		_compress(centroids, count());
+	}
+
+	double	total	= count(),
+			index	= std::min(std::max(p, 0.0), 1.0) * total;
+
+	if (centroids.size() == 1)
+		return centroids[0].mean;
+
+	//Half of the weight of a centroid lies on either side of its mean, and between the means the values are spread evenly
+	const Centroid	&	first	= centroids.front(),
+					&	last	= centroids.back();
+
+	if (index < first.weight / 2)
+		return _min + (first.mean - _min) * index / (first.weight / 2);
+
+	if (index > total - last.weight / 2)
+		return _max - (_max - last.mean) * (total - index) / (last.weight / 2);
+
+	double cumulative = first.weight / 2;
+
+	for (size_t i = 0; i + 1 < centroids.size(); i++)
+	{
+		double between = (centroids[i].weight + centroids[i + 1].weight) / 2;
+
+		if (cumulative + between >= index)
+			return centroids[i].mean + (centroids[i + 1].mean - centroids[i].mean) * (index - cumulative) / between;
+
+		cumulative += between;
+	}
+
+	return _max;
+}
+
+void HyperLogLog::allocate()
+{
+	_registers.resize(REGISTERS);
+	clear();
+}
+
+void HyperLogLog::release()
+{
+	boost::container::vector<uint8_t, RegisterAllocator>(_registers.get_stored_allocator()).swap(_registers);
+}
+
+void HyperLogLog::clear()
+{
+	std::fill(_registers.begin(), _registers.end(), 0);
+}
+
+void HyperLogLog::add(double value)
+{
+	if (std::isnan(value) || !allocated())
+		return;
+
+	if (value == 0)
+		value = 0; //-0.0 is the same value as 0.0 but not the same bits
+
+	uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	uint64_t	hash		= hashBits(bits),
+				rest		= hash << PRECISION;
+	size_t		bucket		= hash >> (64 - PRECISION);
+	uint8_t		zeroRun		= 1;
+
+	while (zeroRun <= 64 - PRECISION && (rest & (uint64_t(1) << 63)) == 0)
+	{
+		zeroRun++;
+		rest <<= 1;
+	}
+
+	if (zeroRun > _registers[bucket])
+		_registers[bucket] = zeroRun;
+}
+
+void HyperLogLog::merge(const HyperLogLog & other)
+{
+	if (!allocated() || !other.allocated())
+		return;
+
+	for (size_t i = 0; i < REGISTERS; i++)
+		_registers[i] = std::max(_registers[i], other._registers[i]);
+}
+
+double HyperLogLog::distinct() const
+{
+	if (!allocated())
+		return NAN;
+
+	double	sum		= 0;
+	size_t	zeroes	= 0;
+
+	for (uint8_t reg : _registers)
+	{
+		sum += std::ldexp(1.0, -int(reg));
+
+		if (reg == 0)
+			zeroes++;
+	}
+
+	double	m			= REGISTERS,
+			estimate	= 0.7213 / (1 + 1.079 / m) * m * m / sum;
+
+	//For few values linear counting of the empty registers does better, the hashes are 64 bits so there is no correction for many
+	if (estimate <= 2.5 * m && zeroes > 0)
+		estimate = m * std::log(m / zeroes);
+
+	return estimate;
+}
+
+void ColumnSketches::rebuild(const ColumnBuffer & values)
+{
+	_valid = false;
+
+	if (!_digest.allocated())	_digest.allocate();
+	else						_digest.clear();
+
+	if (!_distinct.allocated())	_distinct.allocate();
+	else						_distinct.clear();
+
+	if (values.layout() == ColumnBuffer::Layout::doubles)
+		for (size_t row = 0; row < values.size(); row++)
+			_add(values.doubles()[row]);
+	else
+	{
+		std::vector<int> batch(std::min(values.size(), ColumnEncoding::DECODE_BATCH));
+
+		for (size_t from = 0; from < values.size(); from += batch.size())
+		{
+			size_t count = std::min(batch.size(), values.size() - from);
+			values.readInts(from, count, batch.data()); //Packed or not
+
+			for (size_t row = 0; row < count; row++)
+				_add(batch[row] == INT_MIN ? NAN : double(batch[row]));
+		}
+	}
+
+	_overwritten	= 0;
+	_valid			= true;
+}
+
+void ColumnSketches::release()
+{
+	_digest.release();
+	_distinct.release();
+
+	_valid			= false;
+	_overwritten	= 0;
+}
+
+void ColumnSketches::replace(double oldValue, double newValue)
+{
+	if (!_valid)
+		return;
+
+	if (!std::isnan(oldValue))
+		_overwritten++;
+
+	_add(newValue);
+
+	if (_overwritten * OVERWRITE_TOLERANCE > _digest.count())
+		_valid = false;
+}
+
+void ColumnSketches::_add(double value)
+{
+	_digest.add(value);
+	_distinct.add(value);
+}
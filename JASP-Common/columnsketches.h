@@ -0,0 +1,127 @@
+#ifndef COLUMNSKETCHES_H
+#define COLUMNSKETCHES_H
+
+#include <cstdint>
+#include <vector>
+#include <boost/container/vector.hpp>
+#include "columnbuffer.h"
+
+/*
+ * Sketches summarize all the values of a column in a few kilobytes, so medians, percentiles and the number of distinct values
+ * can be given right away instead of after sorting or hashing ten million rows. What they give is approximate, for exact answers
+ * there are Column::quantile() and ColumnStats::distinct().
+ *
+ * TDigest keeps clusters (centroids) of neighbouring values, small ones near the extremes and bigger ones in the middle,
+ * so its quantiles are most accurate in the tails. New values go into a buffer that is merged into the centroids when it is full.
+ * HyperLogLog hashes every value and keeps, per bucket of hashes, the longest run of leading zeros it saw, which says how many different hashes there were.
+ * Both are mergeable, so they can be added to value by value and combined.
+ *
+ * They allocate all they need in the segment when they are (re)built, so adding values later never allocates and can't throw.
+ */
+
+class TDigest
+{
+public:
+	typedef ColumnBuffer::SegmentManager SegmentManager;
+
+	struct Centroid
+	{
+		double mean, weight;
+		bool operator<(const Centroid & other) const { return mean < other.mean; }
+	};
+
+	static const size_t COMPRESSION		= 100,	///< The tails are resolved to roughly 1 / COMPRESSION of the values
+						BUFFER_SIZE		= 512;
+
+	TDigest(SegmentManager * segment) : _centroids(segment), _buffer(segment) {}
+
+	void	allocate();		///< Throws boost::interprocess::bad_alloc if there is no room
+	void	release();
+	void	clear();
+	void	add(double value);
+	void	merge(const TDigest & other);
+
+	bool	allocated()			const { return _centroids.capacity() > 0; }
+	double	count()				const { return _totalWeight + _buffer.size(); }
+	double	quantile(double p)	const;	///< NaN if there is nothing in it
+	size_t	bytesUsed()			const { return _centroids.capacity() * sizeof(Centroid) + _buffer.capacity() * sizeof(double); }
+
+private:
+	typedef boost::interprocess::allocator<Centroid,	SegmentManager>	CentroidAllocator;
+	typedef boost::interprocess::allocator<double,		SegmentManager>	DoubleAllocator;
+
+	void	_flush();
+	static void	_compress(std::vector<Centroid> & centroids, double totalWeight);
+
+	boost::container::vector<Centroid,	CentroidAllocator>	_centroids;
+	boost::container::vector<double,	DoubleAllocator>	_buffer;
+	double													_totalWeight	= 0,
+															_min			= 0,
+															_max			= 0;
+};
+
+class HyperLogLog
+{
+public:
+	typedef ColumnBuffer::SegmentManager SegmentManager;
+
+	static const size_t PRECISION	= 11,				///< 2^11 registers, so about 2.3% standard error
+						REGISTERS	= 1 << PRECISION;
+
+	HyperLogLog(SegmentManager * segment) : _registers(segment) {}
+
+	void	allocate();		///< Throws boost::interprocess::bad_alloc if there is no room
+	void	release();
+	void	clear();
+	void	add(double value);
+	void	merge(const HyperLogLog & other);
+
+	bool	allocated()	const { return _registers.size() == REGISTERS; }
+	double	distinct()	const;
+	size_t	bytesUsed()	const { return _registers.capacity(); }
+
+private:
+	typedef boost::interprocess::allocator<uint8_t, SegmentManager> RegisterAllocator;
+
+	boost::container::vector<uint8_t, RegisterAllocator> _registers;
+};
+
+/*
+ * ColumnSketches are the sketches of one Column, they live in it like its ColumnStats and ColumnSortIndex.
+ * Column::sketches() builds them in one pass when they are stale, the bulk setters mark them so and Column::setValue adds the new value.
+ * As a sketch can't forget a value an overwritten one is still counted, so once more than 1 in OVERWRITE_TOLERANCE
+ * of the values were overwritten they are stale as well and get rebuilt on the next Column::sketches().
+ */
+class ColumnSketches
+{
+public:
+	typedef ColumnBuffer::SegmentManager SegmentManager;
+
+	static const size_t OVERWRITE_TOLERANCE = 16;
+
+	ColumnSketches(SegmentManager * segment) : _digest(segment), _distinct(segment) {}
+
+	void	rebuild(const ColumnBuffer & values);		///< Throws boost::interprocess::bad_alloc if there is no room for them
+	void	release();									///< Makes them stale and gives their memory back
+	void	invalidate()								{ _valid = false; }
+	void	replace(double oldValue, double newValue);	///< For a single value that got overwritten, NaN for missing
+
+	bool	valid()					const	{ return _valid; }
+	double	quantile(double p)		const	{ return _digest.quantile(p);		} ///< Approximate, NaN if there are no values
+	double	median()				const	{ return _digest.quantile(0.5);		}
+	double	distinct()				const	{ return _distinct.distinct();		} ///< Approximate
+	size_t	bytesUsed()				const	{ return _digest.bytesUsed() + _distinct.bytesUsed(); }
+
+	const TDigest		& digest()			const	{ return _digest;	}
+	const HyperLogLog	& distinctSketch()	const	{ return _distinct;	}
+
+private:
+	void	_add(double value);
+
+	TDigest		_digest;
+	HyperLogLog	_distinct;
+	size_t		_overwritten	= 0;
+	bool		_valid			= false;
+};
+
+#endif // COLUMNSKETCHES_H
@@ -0,0 +1,87 @@
+#include "columnsortindex.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	///Sorts (value, row) pairs, so ties stay in the order of their rows without needing a stable sort
+	template<typename T, typename Row>
+	void sortPresentRows(std::vector<std::pair<T, Row>> & present, Row * out)
+	{
+		std::sort(present.begin(), present.end());
+
+		for(size_t i = 0; i < present.size(); i++)
+			out[i] = present[i].second;
+	}
+}
+
+void ColumnSortIndex::rebuild(const ColumnBuffer & values, uint64_t contentVersion)
+{
+	_built	= false;
+	_wide	= values.size() > UINT32_MAX;
+
+	//The other one is dropped first, so a bad_alloc leaves it stale instead of half built
+	if(_wide)	{ Rows(_rows.get_stored_allocator()).swap(_rows);					_valueCount = _build<uint64_t>(values, _wideRows);	}
+	else		{ WideRows(_wideRows.get_stored_allocator()).swap(_wideRows);		_valueCount = _build<uint32_t>(values, _rows);		}
+
+	_contentVersion	= contentVersion;
+	_built			= true;
+}
+
+template<typename Row, typename RowVector>
+size_t ColumnSortIndex::_build(const ColumnBuffer & values, RowVector & rows)
+{
+	rows.resize(values.size());
+
+	std::vector<Row>	missing;
+	size_t				present = 0;
+
+	if(values.layout() == ColumnBuffer::Layout::doubles)
+	{
+		const double * doubles = values.doubles();
+		std::vector<std::pair<double, Row>> pairs;
+		pairs.reserve(values.size());
+
+		for(size_t row = 0; row < values.size(); row++)
+			if(std::isnan(doubles[row]))	missing.push_back(Row(row));
+			else							pairs.push_back(std::make_pair(doubles[row], Row(row)));
+
+		sortPresentRows(pairs, rows.data());
+		present = pairs.size();
+	}
+	else
+	{
+		std::vector<int> batch(std::min(values.size(), ColumnEncoding::DECODE_BATCH));
+		std::vector<std::pair<int, Row>> pairs;
+		pairs.reserve(values.size());
+
+		for(size_t from = 0; from < values.size(); from += batch.size())
+		{
+			size_t count = std::min(batch.size(), values.size() - from);
+			values.readInts(from, count, batch.data()); //Packed or not
+
+			for(size_t row = 0; row < count; row++)
+				if(batch[row] == INT_MIN)	missing.push_back(Row(from + row));
+				else						pairs.push_back(std::make_pair(batch[row], Row(from + row)));
+		}
+
+		sortPresentRows(pairs, rows.data());
+		present = pairs.size();
+	}
+
+	std::copy(missing.begin(), missing.end(), rows.begin() + present);
+
+	return present;
+}
+
+void ColumnSortIndex::release()
+{
+	Rows(_rows.get_stored_allocator()).swap(_rows);
+	WideRows(_wideRows.get_stored_allocator()).swap(_wideRows);
+
+	_built		= false;
+	_wide		= false;
+	_valueCount	= 0;
+}
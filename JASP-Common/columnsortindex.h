@@ -0,0 +1,48 @@
+#ifndef COLUMNSORTINDEX_H
+#define COLUMNSORTINDEX_H
+
+#include <cstdint>
+#include <boost/container/vector.hpp>
+#include "columnbuffer.h"
+
+/*
+ * ColumnSortIndex is the order of the rows of a Column by their value, so sorting the data view, ranks and quantiles do not have to sort the column again every time.
+ * It is built lazily by Column::sortIndex() and stamped with the Column::contentVersion() it was built from, any change to the values makes it stale.
+ * Ties keep the order of their rows and the missing values (INT_MIN and NaN) come last. For nominalText the values are the keys of the labels,
+ * which were handed out in alphabetical order when the column was made.
+ * Like ColumnStats it lives in the Column, in shared memory, so the Engines can use it when it is current but only a writer rebuilds it.
+ * The rows are 32 bits, which halves the memory and the cache misses of walking it, only a column of more than UINT32_MAX rows gets 64 bit ones in _wideRows.
+ */
+class ColumnSortIndex
+{
+public:
+	typedef ColumnBuffer::SegmentManager											SegmentManager;
+	typedef boost::interprocess::allocator<uint32_t, SegmentManager>				RowAllocator;
+	typedef boost::container::vector<uint32_t, RowAllocator>						Rows;
+	typedef boost::interprocess::allocator<uint64_t, SegmentManager>				WideRowAllocator;
+	typedef boost::container::vector<uint64_t, WideRowAllocator>					WideRows;
+
+	ColumnSortIndex(SegmentManager * segment) : _rows(segment), _wideRows(segment) {}
+
+	void				rebuild(const ColumnBuffer & values, uint64_t contentVersion);	///< Throws boost::interprocess::bad_alloc if there is no room for it
+	void				release();														///< Makes it stale and gives its memory back
+
+	bool				current(uint64_t contentVersion)	const	{ return _built && _contentVersion == contentVersion; }
+	size_t				size()								const	{ return _wide ? _wideRows.size() : _rows.size();	}
+	size_t				valueCount()						const	{ return _valueCount;								} ///< The rows that are not missing, these come first
+	size_t				operator[](size_t i)				const	{ return _wide ? _wideRows[i] : _rows[i];			}
+	size_t				bytesUsed()							const	{ return _rows.capacity() * sizeof(uint32_t) + _wideRows.capacity() * sizeof(uint64_t); }
+
+private:
+	template<typename Row, typename RowVector>
+	size_t		_build(const ColumnBuffer & values, RowVector & rows); ///< Fills rows and returns how many of them are not missing
+
+	Rows		_rows;
+	WideRows	_wideRows;
+	bool		_wide			= false;
+	size_t		_valueCount		= 0;
+	uint64_t	_contentVersion	= 0;
+	bool		_built			= false;
+};
+
+#endif // COLUMNSORTINDEX_H
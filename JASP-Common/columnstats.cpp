@@ -0,0 +1,65 @@
+#include "columnstats.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+void ColumnStats::reset()
+{
+	_valid		= true;
+	_count		= 0;
+	_missing	= 0;
+	_distinct	= 0;
+	_min		= std::numeric_limits<double>::quiet_NaN();
+	_max		= std::numeric_limits<double>::quiet_NaN();
+	_sum		= 0;
+	_sumSquares	= 0;
+}
+
+void ColumnStats::add(double value)
+{
+	if(std::isnan(value))
+	{
+		_missing++;
+		return;
+	}
+
+	if(_count == 0 || value < _min)	_min = value;
+	if(_count == 0 || value > _max)	_max = value;
+
+	_count++;
+	_sum		+= value;
+	_sumSquares	+= value * value;
+}
+
+void ColumnStats::remove(double value)
+{
+	if(std::isnan(value))
+	{
+		if(_missing > 0)
+			_missing--;
+		return;
+	}
+
+	if(_count == 0 || value == _min || value == _max)
+	{
+		_valid = false;
+		return;
+	}
+
+	_count--;
+	_sum		-= value;
+	_sumSquares	-= value * value;
+}
+
+double ColumnStats::mean() const
+{
+	return _count == 0 ? std::numeric_limits<double>::quiet_NaN() : _sum / _count;
+}
+
+double ColumnStats::variance() const
+{
+	if(_count < 2)
+		return std::numeric_limits<double>::quiet_NaN();
+
+	return std::max(0.0, (_sumSquares - _sum * _sum / _count) / (_count - 1));
+}
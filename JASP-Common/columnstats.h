@@ -0,0 +1,46 @@
+#ifndef COLUMNSTATS_H
+#define COLUMNSTATS_H
+
+#include <cstddef>
+
+/*
+ * ColumnStats is the summary of the values of a Column that gets asked for over and over: how many there are, how many are missing,
+ * their extremes, sum and sum of squares and how many distinct values there are.
+ * It lives in the Column, so in shared memory, and is kept up to date by whoever writes to the Column (that is the Desktop, or an Engine for computed columns).
+ * Column::setValue updates it in place, the bulk setters and type changes mark it stale and Column::stats() recomputes it in one pass.
+ * Readers that can't write (the Engines) check valid() and otherwise compute what they need themselves.
+ * Missing values (NaN or INT_MIN) only count towards missing().
+ */
+class ColumnStats
+{
+public:
+	void	invalidate()					{ _valid = false; }
+	void	reset();						///< Valid and empty, ready for add()
+
+	void	add(double value);
+	void	remove(double value);			///< Invalidates if value was one of the extremes, as the new one is unknown then
+	void	setDistinct(size_t distinct)	{ _distinct = distinct; }
+
+	bool	valid()					const	{ return _valid;		}
+	size_t	count()					const	{ return _count;		}	///< Non-missing values
+	size_t	missing()				const	{ return _missing;		}
+	size_t	distinct()				const	{ return _distinct;		}
+	double	min()					const	{ return _min;			}
+	double	max()					const	{ return _max;			}
+	double	sum()					const	{ return _sum;			}
+	double	sumOfSquares()			const	{ return _sumSquares;	}
+	double	mean()					const;
+	double	variance()				const;	///< Sample variance
+
+private:
+	bool	_valid		= false;
+	size_t	_count		= 0,
+			_missing	= 0,
+			_distinct	= 0;
+	double	_min		= 0,
+			_max		= 0,
+			_sum		= 0,
+			_sumSquares	= 0;
+};
+
+#endif // COLUMNSTATS_H
@@ -0,0 +1,311 @@
+#include "columntypeconverter.h"
+#include "column.h"
+#include "utils.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+
+const size_t ColumnTypeConverter::BATCH;
+
+ColumnTypeConverter::Conversion ColumnTypeConverter::convert(const Column & column, columnType newType, Progress progress)
+{
+	Conversion conversion;
+
+	conversion.from	= column.getColumnType();
+	conversion.to	= newType;
+
+	if (newType == conversion.from)
+	{
+		conversion.outcome = Conversion::Outcome::unchanged;
+		return conversion;
+	}
+
+	switch (conversion.from)
+	{
+	case columnType::nominal:
+	case columnType::ordinal:
+		if (newType == columnType::scale)	_intsToDoubles(column, conversion, progress);
+		else								conversion.outcome = Conversion::Outcome::retyped;
+		break;
+
+	case columnType::nominalText:
+		_textsToNumbers(column, conversion, progress);
+		break;
+
+	case columnType::scale:
+		_doublesToInts(column, conversion, progress);
+
+		if (conversion.outcome == Conversion::Outcome::impossible && newType == columnType::nominal)
+			_doublesToTexts(column, conversion, progress);
+		break;
+
+	default:
+		break;
+	}
+
+	return conversion;
+}
+
+bool ColumnTypeConverter::apply(Column & column, const Conversion & conversion)
+{
+	switch (conversion.outcome)
+	{
+	case Conversion::Outcome::unchanged:	return true;
+	case Conversion::Outcome::retyped:		column._columnType = conversion.to;	return true;
+	case Conversion::Outcome::converted:	break;
+	default:								return false;
+	}
+
+	switch (conversion.to)
+	{
+	case columnType::scale:
+		column.setColumnAsScale(conversion.doubles);
+		break;
+
+	case columnType::nominalText:
+		_applyTexts(column, conversion);
+		break;
+
+	default:
+		if (conversion.from == columnType::nominalText)
+		{
+			//The labels of the text stay, as far as there are any for the values
+			std::map<int, std::string> labels = conversion.intLabels;
+
+			for (int value : conversion.distinctInts)
+				if (labels.count(value) == 0)
+					labels[value] = std::to_string(value);
+
+			column._labels.clear();
+			column._labels.syncInts(labels);
+		}
+		else
+			column._labels.syncInts(conversion.distinctInts);
+
+		column._setColumnAsNominalOrOrdinal(conversion.ints, conversion.to == columnType::ordinal);
+		break;
+	}
+
+	return true;
+}
+
+void ColumnTypeConverter::_doublesToInts(const Column & column, Conversion & conversion, Progress & progress)
+{
+	size_t					rows		= column.rowCount();
+	std::vector<double>		batch(std::min(rows, BATCH));
+	std::unordered_set<int>	distinct;
+
+	conversion.ints.resize(rows);
+
+	for (size_t from = 0; from < rows; from += batch.size())
+	{
+		size_t	count	= column.readInto(batch.data(), from, batch.size());
+		int	*	out		= conversion.ints.data() + from;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			if (Utils::isEmptyValue(batch[i]))
+				out[i] = INT_MIN;
+			else if (Utils::getIntValue(batch[i], out[i]))
+			{
+				if (i == 0 || out[i] != out[i - 1]) //Neighbouring rows often have the same value
+					distinct.insert(out[i]);
+			}
+			else
+			{
+				conversion.ints.clear();
+				return;
+			}
+		}
+
+		if (!_reportProgress(progress, from + count, rows, conversion))
+			return;
+	}
+
+	conversion.distinctInts.insert(distinct.begin(), distinct.end());
+	conversion.to		= conversion.to == columnType::ordinal ? columnType::ordinal : columnType::nominal;
+	conversion.outcome	= Conversion::Outcome::converted;
+}
+
+void ColumnTypeConverter::_doublesToTexts(const Column & column, Conversion & conversion, Progress & progress)
+{
+	size_t							rows		= column.rowCount();
+	std::vector<double>				batch(std::min(rows, BATCH));
+	std::unordered_map<double, int>	codes;
+
+	conversion.ints.resize(rows);
+
+	for (size_t from = 0; from < rows; from += batch.size())
+	{
+		size_t	count	= column.readInto(batch.data(), from, batch.size());
+		int	*	out		= conversion.ints.data() + from;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			if (std::isnan(batch[i]))
+			{
+				out[i] = INT_MIN;
+				continue;
+			}
+
+			auto code = codes.find(batch[i]);
+
+			if (code == codes.end())
+			{
+				code = codes.insert(std::make_pair(batch[i], int(conversion.texts.size()))).first;
+				conversion.texts.push_back(Utils::doubleToString(batch[i]));
+			}
+
+			out[i] = code->second;
+		}
+
+		if (!_reportProgress(progress, from + count, rows, conversion))
+			return;
+	}
+
+	conversion.to		= columnType::nominalText;
+	conversion.outcome	= Conversion::Outcome::converted;
+}
+
+void ColumnTypeConverter::_intsToDoubles(const Column & column, Conversion & conversion, Progress & progress)
+{
+	size_t				rows	= column.rowCount();
+	std::vector<int>	batch(std::min(rows, BATCH));
+
+	conversion.doubles.resize(rows);
+
+	for (size_t from = 0; from < rows; from += batch.size())
+	{
+		size_t		count	= column.readInto(batch.data(), from, batch.size());
+		double	*	out		= conversion.doubles.data() + from;
+
+		for (size_t i = 0; i < count; i++)
+			out[i] = batch[i] == INT_MIN || Utils::isEmptyValue(double(batch[i])) ? NAN : double(batch[i]);
+
+		if (!_reportProgress(progress, from + count, rows, conversion))
+			return;
+	}
+
+	conversion.outcome = Conversion::Outcome::converted;
+}
+
+void ColumnTypeConverter::_textsToNumbers(const Column & column, Conversion & conversion, Progress & progress)
+{
+	struct Parsed
+	{
+		bool		ok		= true,
+					used	= false;
+		double		number	= NAN;
+		int			integer	= INT_MIN;
+		std::string	label;
+	};
+
+	//Every label is parsed once, after that a row is just a lookup of its key
+	const Labels					&	labels	= column.labels();
+	bool								toScale	= conversion.to == columnType::scale;
+	std::vector<Parsed>					parsed;
+	std::unordered_map<int, size_t>		byKey;
+
+	parsed.reserve(labels.size());
+
+	for (const Label & label : labels)
+	{
+		Parsed		parse;
+		std::string	value = labels.getValueFromKey(label.value());
+
+		parse.label = label.text();
+
+		if (!Utils::isEmptyValue(value))
+			parse.ok = toScale ? Utils::getDoubleValue(value, parse.number) : Utils::getIntValue(value, parse.integer);
+
+		byKey[label.value()] = parsed.size();
+		parsed.push_back(parse);
+	}
+
+	size_t				rows	= column.rowCount();
+	std::vector<int>	batch(std::min(rows, BATCH));
+
+	if (toScale)	conversion.doubles.resize(rows);
+	else			conversion.ints.resize(rows);
+
+	for (size_t from = 0; from < rows; from += batch.size())
+	{
+		size_t count = column.readInto(batch.data(), from, batch.size());
+
+		for (size_t i = 0; i < count; i++)
+		{
+			auto		found	= batch[i] == INT_MIN ? byKey.end() : byKey.find(batch[i]);
+			Parsed	*	parse	= found == byKey.end() ? nullptr : &parsed[found->second]; //A key without a label counts as missing, as it has no value
+
+			if (parse && !parse->ok)
+			{
+				//nominalText to nominal: the values are not all integers, but the column can just stay nominalText, so it is not a failure
+				conversion.outcome = conversion.to == columnType::nominal ? Conversion::Outcome::unchanged : Conversion::Outcome::impossible;
+				conversion.doubles.clear();
+				conversion.ints.clear();
+				return;
+			}
+
+			if (parse)
+				parse->used = true;
+
+			if (toScale)	conversion.doubles[from + i]	= parse ? parse->number		: NAN;
+			else			conversion.ints[from + i]		= parse ? parse->integer	: INT_MIN;
+		}
+
+		if (!_reportProgress(progress, from + count, rows, conversion))
+			return;
+	}
+
+	if (!toScale)
+		for (const Parsed & parse : parsed)
+			if (parse.used && parse.integer != INT_MIN)
+			{
+				conversion.distinctInts.insert(parse.integer);
+				conversion.intLabels.insert(std::make_pair(parse.integer, parse.label)); //The first label with that value
+			}
+
+	conversion.outcome = Conversion::Outcome::converted;
+}
+
+bool ColumnTypeConverter::_reportProgress(Progress & progress, size_t done, size_t total, Conversion & conversion)
+{
+	if (!progress || progress(total == 0 ? 1.0 : double(done) / total))
+		return true;
+
+	conversion.outcome = Conversion::Outcome::cancelled;
+	conversion.doubles.clear();
+	conversion.ints.clear();
+
+	return false;
+}
+
+void ColumnTypeConverter::_applyTexts(Column & column, const Conversion & conversion)
+{
+	//Sorted and without duplicates like setColumnAsNominalText gives them to the labels, two different doubles can print the same
+	std::vector<std::string> sortedTexts(conversion.texts);
+
+	std::sort(sortedTexts.begin(), sortedTexts.end());
+	sortedTexts.erase(std::unique(sortedTexts.begin(), sortedTexts.end()), sortedTexts.end());
+	sortedTexts.erase(std::remove_if(sortedTexts.begin(), sortedTexts.end(), [](const std::string & text) { return Utils::isEmptyValue(text); }), sortedTexts.end());
+
+	std::map<std::string, int>	textToKey	= column._labels.syncStrings(sortedTexts, std::map<std::string, std::string>(), nullptr);
+	std::vector<int>			codeToKey(conversion.texts.size(), INT_MIN);
+
+	for (size_t code = 0; code < conversion.texts.size(); code++)
+	{
+		auto key = textToKey.find(conversion.texts[code]);
+
+		if (key != textToKey.end())
+			codeToKey[code] = key->second;
+	}
+
+	std::vector<int> keys(conversion.ints.size());
+
+	std::transform(conversion.ints.begin(), conversion.ints.end(), keys.begin(), [&](int code) { return code == INT_MIN ? INT_MIN : codeToKey[code]; });
+
+	column.setColumnType(columnType::nominalText);
+	column._setInts(keys, "ColumnTypeConverter::apply");
+}
@@ -0,0 +1,58 @@
+#ifndef COLUMNTYPECONVERTER_H
+#define COLUMNTYPECONVERTER_H
+
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "columntype.h"
+
+class Column;
+
+/*
+ * ColumnTypeConverter does what Column::changeColumnType asks for in two steps:
+ * convert() works out the new values from a const Column and doesn't change anything, so it can run on a worker thread as long as nobody writes to the column meanwhile.
+ * apply() then writes them into the Column, that is quick and has to happen where the Column may be written to, for the Desktop within a DataSet::ColumnWrite.
+ *
+ * Nothing goes through strings per row anymore: the values are read a batch at a time and
+ *  - doubles to ints is a check per value, and the distinct ones are collected in a hash for the labels,
+ *  - doubles to text formats every distinct double once and gives the rows a code into those,
+ *  - ints and text to numbers parse the value of every label once and then map the rows through a table by key.
+ * convert() reports progress after every batch, a Progress that returns false cancels it.
+ */
+class ColumnTypeConverter
+{
+public:
+	typedef std::function<bool(double fraction)> Progress; ///< Gets how far along it is, between 0 and 1, return false to cancel
+
+	static const size_t BATCH = 64 * 1024;
+
+	struct Conversion
+	{
+		enum class Outcome { converted, retyped, unchanged, impossible, cancelled };
+
+		Outcome						outcome	= Outcome::impossible;
+		columnType					from	= columnType::unknown,
+									to		= columnType::unknown;
+		std::vector<double>			doubles;		///< The values, when converted to scale
+		std::vector<int>			ints;			///< The values for nominal and ordinal, indices into texts for nominalText, INT_MIN when missing
+		std::set<int>				distinctInts;	///< Every value in ints, for nominal and ordinal
+		std::map<int, std::string>	intLabels;		///< The labels of the values that came from text
+		std::vector<std::string>	texts;			///< The distinct values for nominalText
+	};
+
+	static Conversion	convert(const Column & column, columnType newType, Progress progress = nullptr);
+	static bool			apply(Column & column, const Conversion & conversion); ///< Returns what Column::changeColumnType returns, true if the column is fine as it is now
+
+private:
+	static void			_doublesToInts(	const Column & column, Conversion & conversion, Progress & progress);
+	static void			_doublesToTexts(const Column & column, Conversion & conversion, Progress & progress);
+	static void			_intsToDoubles(	const Column & column, Conversion & conversion, Progress & progress);
+	static void			_textsToNumbers(const Column & column, Conversion & conversion, Progress & progress);
+
+	static bool			_reportProgress(Progress & progress, size_t done, size_t total, Conversion & conversion);
+	static void			_applyTexts(Column & column, const Conversion & conversion);
+};
+
+#endif // COLUMNTYPECONVERTER_H
@@ -22,16 +22,32 @@ using namespace std;
 /* DataSet is implemented as a set of columns */
 
 
+DataSet::ColumnWrite::ColumnWrite(DataSet & dataSet, Column & column, DataSetChanges::Kind kind, size_t firstRow, size_t rowCount)
+	: _versions(dataSet._versions), _changes(dataSet._changes), _column(column), _writer(dataSet._versions.writers()), _change{ 0, column.id(), firstRow, rowCount, kind }
+{
+	DataSetVersions::WriteLock lock(_versions.mutex()); //Waits for readers that are busy with the live column
+
+	_epoch = _versions.committed() + 1;
+	_column._keepVersion(_epoch);
+}
+
+DataSet::ColumnWrite::~ColumnWrite()
+{
+	DataSetVersions::WriteLock lock(_versions.mutex());
+
+	_versions.commit(_epoch);
+	_column._dropUnseenVersions(_versions);
+
+	_changes.record(_change.kind, _change.columnId, _change.firstRow, _change.rowCount);
+}
+
 void DataSet::setRowCount(size_t newRowCount)
 {
 	if(newRowCount != minRowCount() || newRowCount != maxRowCount())
 	{
 		_columns.setRowCount(newRowCount);
-
-		_filteredRowCount = newRowCount;
-		_filterVector.clear();
-		for(size_t i=0; i<newRowCount; i++)
-			_filterVector.push_back(true);
+		_filter.reset(newRowCount);
+		_changes.record(DataSetChanges::Kind::rows);
 	}
 }
 
@@ -41,79 +57,165 @@ void DataSet::setColumnCount(size_t newColumnCount)
 	{
 		_columns.setColumnCount(newColumnCount);
 		_columns.setRowCount(maxRowCount());
+		_changes.record(DataSetChanges::Kind::columns);
 	}
 }
 
-void DataSet::setSharedMemory(boost::interprocess::managed_shared_memory *mem)
+void DataSet::insertRows(size_t row, size_t count)
 {
-	_mem = mem;
-	_columns.setSharedMemory(mem);
+	if(count == 0)
+		return;
 
-	_filterVector = BoolVector(mem->get_segment_manager());
-	for(size_t i=0; i<maxRowCount(); i++)
-		_filterVector.push_back(true);
+	//The filter first, it is the smallest so if it cannot grow the columns have not been touched yet
+	_filter.insertRows(row, count, true);
+
+	size_t done = 0;
+
+	try
+	{
+		for(; done < columnCount(); done++)
+			_columns[done].insertRows(row, count);
+	}
+	catch (boost::interprocess::bad_alloc &)
+	{
+		//Put it back the way it was so enlargeDataSetIfNecessary can simply try again
+		for(size_t col = 0; col < done; col++)
+			_columns[col].removeRows(row, count);
+
+		_filter.eraseRows(row, count);
+		throw;
+	}
+
+	_changes.record(DataSetChanges::Kind::rows, -1, row);
 }
 
+void DataSet::removeRows(size_t row, size_t count)
+{
+	if(count == 0)
+		return;
+
+	for(Column & column : _columns)
+		column.removeRows(row, count);
 
-string DataSet::toString()
+	_filter.eraseRows(row, count);
+	_changes.record(DataSetChanges::Kind::rows, -1, row);
+}
+
+void DataSet::insertColumns(size_t index, size_t count)
 {
-	stringstream ss;
-	ss << "Column count: " << columnCount() << "\nRow count:    " << minRowCount() << " -> " << maxRowCount() << std::endl;
+	if(count == 0)
+		return;
 
-	for (auto & col : _columns)
-	{
-		ss << "Column name: " << col.name() << "  " << col.labels().size() << "Labels" << std::endl;
+	_columns.insertColumns(index, count);
+	_changes.record(DataSetChanges::Kind::columns);
+}
 
-		for (auto & label : col.labels())
-			ss << "    "  << ", Label Text: " << label.text() << " Label Value : " << label.value() << std::endl;
+void DataSet::removeColumns(size_t index, size_t count)
+{
+	if(count == 0)
+		return;
 
-		ss << "  Ints" << std::endl;
-		for (int key : col.AsInts)
-			ss << "    " << key << ": " << col._getLabelFromKey(key) << std::endl;
+	_columns.removeColumns(index, count);
+	_changes.record(DataSetChanges::Kind::columns);
+}
 
-	}
+Column & DataSet::duplicateColumn(size_t index, const std::string & name)
+{
+	Column * duplicate = _columns.duplicateColumn(index, name);
 
-	return ss.str();
+	_changes.record(DataSetChanges::Kind::columns);
+
+	return *duplicate;
 }
 
-std::map<string, std::map<int, string> > DataSet::resetEmptyValues(const std::map<std::string, std::map<int, std::string> >& emptyValuesPerColumnMap)
+Column & DataSet::createLabelView(size_t index, const std::string & name, const std::map<std::string, std::string> & newLabels)
 {
-	std::map<string, std::map<int, string> > colChanged;
+	Column * view = _columns.createLabelView(index, name, newLabels);
 
-	for (Column& col : _columns)
+	_changes.record(DataSetChanges::Kind::columns);
+
+	return *view;
+}
+
+bool DataSet::shareIdenticalValues(size_t index, const std::set<std::string> & candidates)
+{
+	Column & column = _columns.at(index);
+
+	for(const std::string & name : candidates)
 	{
-		std::map<int, string> emptyValuesMap;
+		int other = getColumnIndex(name);
+
+		if(other < 0 || size_t(other) == index)
+			continue;
+
+		if(column.sharesValuesWith(_columns[other]))
+			return true;
 
-		if (emptyValuesPerColumnMap.count(col.name()))
-			emptyValuesMap = emptyValuesPerColumnMap.at(col.name());
+		if(!column._valuesEqual(_columns[other]))
+			continue;
 
-		if (col.resetEmptyValues(emptyValuesMap))
-			colChanged[col.name()] = emptyValuesMap;
+		//The values do not change, but the Engines might be reading the ones that get freed
+		ColumnWrite write(*this, column);
+		column._shareValues(_columns[other]);
+
+		return true;
 	}
 
-	return colChanged;
+	return false;
 }
 
-bool DataSet::setFilterVector(std::vector<bool> filterResult)
+bool DataSet::setFilterVector(const std::vector<bool> & filterResult)
 {
-	bool changed = false;
+	if(!_filter.assign(filterResult))
+		return false;
 
+	_changes.record(DataSetChanges::Kind::filter);
+	return true;
+}
+
+void DataSet::setSharedMemory(boost::interprocess::managed_shared_memory::segment_manager *mem)
+{
+	_mem = mem;
+	_columns.setSharedMemory(mem);
+}
+
+
+string DataSet::toString()
+{
+	stringstream ss;
+	ss << "Column count: " << columnCount() << "\nRow count:    " << minRowCount() << " -> " << maxRowCount() << std::endl;
 
-	for(size_t i=0; i<filterResult.size(); i++)
+	for (auto & col : _columns)
 	{
-		if(_filterVector[i] != filterResult[i])
-			changed = true;
+		ss << "Column name: " << col.name() << "  " << col.labels().size() << "Labels" << std::endl;
+
+		for (auto & label : col.labels())
+			ss << "    "  << ", Label Text: " << label.text() << " Label Value : " << label.value() << std::endl;
+
+		ss << "  Ints" << std::endl;
+		std::vector<int>	decoded;
+		const int		*	keys = col.intValues(decoded);
+
+		for (size_t row = 0; keys && row < col.rowCount(); row++)
+			ss << "    " << keys[row] << ": " << col._getLabelFromKey(keys[row]) << std::endl;
 
-		_filterVector[i] = filterResult[i];
 	}
 
-	_filteredRowCount = 0;
+	return ss.str();
+}
 
-	for(bool row : _filterVector)
-		if(row)
-			_filteredRowCount++;
+std::vector<std::string> DataSet::resetEmptyValues()
+{
+	std::vector<std::string> colChanged;
 
-	return changed;
+	for (Column& col : _columns)
+		if (col.resetEmptyValues())
+		{
+			colChanged.push_back(col.name());
+			_changes.record(DataSetChanges::Kind::values, col.id());
+		}
+
+	return colChanged;
 }
 
 bool DataSet::allColumnsPassFilter() const
@@ -162,14 +264,45 @@ size_t DataSet::getMaximumColumnWidthInCharacters(size_t columnIndex) const
 		return 0;
 
 	default:
-	{
-		int tempVal = 0;
+		return col.labels().maxLabelLength() + extraPad;
+	}
 
-		for(int labelIndex=0; labelIndex < static_cast<int>(col.labels().size()); labelIndex++)
-			tempVal = std::max(tempVal, static_cast<int>(col.labels().getLabelFromRow(labelIndex).length()));
+}
 
-		return tempVal + extraPad;
-	}
-	}
+size_t DataSet::unusedColumnBytes() const
+{
+	size_t unused = 0;
+
+	for(const Column & col : _columns)
+		unused += col.unusedBytes();
+
+	return unused;
+}
+
+size_t DataSet::derivedColumnCount() const
+{
+	size_t derived = 0;
+
+	for(const Column & col : _columns)
+		if(col.hasDerived())
+			derived++;
+
+	return derived;
+}
+
+void DataSet::refreshColumnStats()
+{
+	for(Column & col : _columns)
+		col.stats();
+}
+
+size_t DataSet::packColumns()
+{
+	size_t packed = 0;
+
+	for(Column & col : _columns)
+		if(col.pack())
+			packed++;
 
+	return packed;
 }
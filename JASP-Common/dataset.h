@@ -19,19 +19,38 @@
 #define DATASET_H
 
 #include <map>
+#include <set>
 
 #include "columns.h"
-
-typedef boost::interprocess::allocator<bool, boost::interprocess::managed_shared_memory::segment_manager> BoolAllocator;
-typedef boost::container::vector<bool, BoolAllocator> BoolVector;
+#include "datasetchanges.h"
+#include "filterbitmap.h"
 
 class DataSet
 {
-	typedef std::map<std::string, std::map<int, std::string>> emptyValsType;
-
 public:
 
-	DataSet(boost::interprocess::managed_shared_memory *mem) : _columns(mem), _filterVector(mem->get_segment_manager()), _mem(mem) { }
+	///Changes the contents of column while the Engines keep running, see DataSetVersions. Changing the column is only allowed while this exists and these do not nest.
+	///Once done the change is recorded in changes() as kind for the given rows.
+	class ColumnWrite
+	{
+	public:
+		ColumnWrite(DataSet & dataSet, Column & column, DataSetChanges::Kind kind = DataSetChanges::Kind::values, size_t firstRow = 0, size_t rowCount = DataSetChanges::ALL_ROWS);
+		~ColumnWrite();
+
+	private:
+		DataSetVersions				&	_versions;
+		DataSetChanges				&	_changes;
+		Column						&	_column;
+		DataSetVersions::WriterLock		_writer;
+		DataSetVersions::Epoch			_epoch;
+		DataSetChanges::Change			_change;
+	};
+
+	DataSet(boost::interprocess::managed_shared_memory::segment_manager *mem) : _columns(mem), _filter(mem), _mem(mem) { }
+
+	///Copies all of dataSet into mem, which is what SharedMemory::compactDataSet does. The versions and the log of changes start over,
+	///so readers of the log find out they lost track and assume everything changed.
+	DataSet(boost::interprocess::managed_shared_memory::segment_manager *mem, const DataSet & dataSet) : _columns(mem, dataSet._columns), _filter(mem, dataSet._filter), _synchingData(dataSet._synchingData), _mem(mem) { }
 	~DataSet() {}
 
 	size_t minRowCount()	const	{ return _columns.minRowCount(); }
@@ -45,34 +64,59 @@ public:
 			Column& column(std::string name)			{ return _columns.get(name);	}
 	const	Column& column(size_t index)		const	{ return _columns.at(index);	}
 	const	Column& column(std::string name)	const	{ return _columns.get(name);	}
+	const	Column& columnVersion(const std::string & name, DataSetVersions::Epoch pinned) const { return _columns.get(name).version(_versions.readEpoch(pinned)); } ///< Hold a ReadLock on versions().mutex() while using it
+
+	DataSetVersions & versions()					{ return _versions; }
+	DataSetChanges	& changes()						{ return _changes;	}
 
 	int  getColumnIndex(std::string name) { try{ return _columns.findIndexByName(name); } catch(...) { return -1;	} }
 	void setRowCount(size_t rowCount);
 	void setColumnCount(size_t columnCount);
 
-	void setSharedMemory(boost::interprocess::managed_shared_memory *mem);
+	///These change the shape in one go instead of row by row or column by column, the filter and the empty values of the columns move along.
+	///New rows are empty and pass the filter, new columns are empty as well.
+	void insertRows(size_t row, size_t count);
+	void removeRows(size_t row, size_t count);
+	void insertColumns(size_t index, size_t count);
+	void removeColumns(size_t index, size_t count);
+
+	///Appended at the end, sharing the values with the column at index until either is written to, see Columns
+	Column & duplicateColumn(size_t index, const std::string & name);
+	Column & createLabelView(size_t index, const std::string & name, const std::map<std::string, std::string> & newLabels);
+
+	///If column index has the same values as one of candidates, for instance a computed column that turned out to be a copy, it shares them from then on.
+	///Returns whether it does now.
+	bool shareIdenticalValues(size_t index, const std::set<std::string> & candidates);
+
+	void setSharedMemory(boost::interprocess::managed_shared_memory::segment_manager *mem);
 
 	std::string toString();
-	std::map<std::string, std::map<int, std::string> > resetEmptyValues(const emptyValsType& emptyValuesMap);
+	std::vector<std::string> resetEmptyValues(); ///< Returns the names of the columns that changed
 
-	bool				setFilterVector(std::vector<bool> filterResult);
-	BoolVector	&		filterVector()				{ return _filterVector; }
-	int					filteredRowCount()	const	{ return _filteredRowCount; }
+	bool				setFilterVector(const std::vector<bool> & filterResult);
+			FilterBitmap &	filter()									{ return _filter; }
+	const	FilterBitmap &	filter()							const	{ return _filter; }
+	size_t				filteredRowCount()	const	{ return _filter.passingCount(); }
 
 	bool allColumnsPassFilter()				const;
 	bool synchingData()						const	{ return _synchingData; }
 	void setSynchingData(bool newVal);
 
 	size_t						getMaximumColumnWidthInCharacters(size_t columnIndex) const;
+	size_t						unusedColumnBytes() const;
+	size_t						derivedColumnCount() const; ///< How many columns have a sort index or sketches, none right after loading
+	void						refreshColumnStats();
+	size_t						packColumns(); ///< Returns how many columns are packed now
 	std::vector<std::string> 	getColumnNames() { return _columns.getColumnNames();};
 
 private:
 	Columns			_columns;
-	int				_filteredRowCount = 0;
-	BoolVector		_filterVector;
+	FilterBitmap	_filter;
 	bool			_synchingData;
+	DataSetVersions	_versions;
+	DataSetChanges	_changes;
 
-	boost::interprocess::managed_shared_memory *_mem;
+	boost::interprocess::managed_shared_memory::segment_manager *_mem;
 };
 
 #endif // DATASET_H
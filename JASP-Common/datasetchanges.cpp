@@ -0,0 +1,90 @@
+#include "datasetchanges.h"
+#include <chrono>
+
+DataSetChanges::DataSetChanges()
+{
+	_first = Version(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+
+	_next.store(_first);
+
+	for(Slot & slot : _slots)
+		slot.published.store(0, std::memory_order_relaxed);
+}
+
+DataSetChanges::Version DataSetChanges::record(Kind kind, int columnId, size_t firstRow, size_t rowCount)
+{
+	Version		version	= _next.fetch_add(1, std::memory_order_acq_rel);
+	Slot	&	slot	= _slots[version % CAPACITY];
+
+	slot.published.store(0, std::memory_order_relaxed); //Readers that copy the slot meanwhile see it changed underneath them
+	std::atomic_thread_fence(std::memory_order_release);
+
+	slot.change = Change{ version, columnId, firstRow, rowCount, kind };
+
+	slot.published.store(version, std::memory_order_release);
+
+	return version;
+}
+
+bool DataSetChanges::since(Version & seen, std::vector<Change> & changes) const
+{
+	Version last = latest();
+
+	if(seen + 1 < _first || seen > last || last - seen > CAPACITY)
+	{
+		seen = last; //Never looked, looked at another log or too long ago
+		return false;
+	}
+
+	for(Version version = seen + 1; version <= last; version++)
+	{
+		const Slot & slot = _slots[version % CAPACITY];
+
+		Version published = slot.published.load(std::memory_order_acquire);
+
+		if(published > version)
+		{
+			seen = last;
+			return false;
+		}
+
+		if(published != version)
+			break; //Still being written, the next call picks it up
+
+		Change change = slot.change;
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if(slot.published.load(std::memory_order_relaxed) != version)
+		{
+			seen = last;
+			return false;
+		}
+
+		changes.push_back(change);
+		seen = version;
+	}
+
+	return true;
+}
+
+bool DataSetChanges::columnsChangedSince(Version & seen) const
+{
+	std::vector<Change> changes;
+
+	if(!since(seen, changes))
+		return true;
+
+	for(const Change & change : changes)
+		switch(change.kind)
+		{
+		case Kind::columns:
+		case Kind::columnName:
+		case Kind::everything:
+			return true;
+
+		default:
+			break;
+		}
+
+	return false;
+}
@@ -0,0 +1,61 @@
+#ifndef DATASETCHANGES_H
+#define DATASETCHANGES_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/*
+ * DataSetChanges is a log of what changed in the DataSet, kept in the shared memory segment next to it so the Engines can read it as well.
+ * Every change gets the next version and goes in a ring of CAPACITY slots, a reader keeps the last version it looked at and asks since()
+ * for everything after it. That way it can see exactly which columns (by Column::id()) and rows changed and skip the rest of its work.
+ *
+ * Writers claim a version with a single atomic increment and publish the slot afterwards, readers check the version of a slot before and after
+ * copying it, so neither ever waits for the other. When a reader falls so far behind that the ring went round, since() says so and
+ * it should assume everything changed.
+ * Versions start at the steady clock of the moment the log was made, so a version from the log of an earlier DataSet is never mistaken for one of this one.
+ */
+class DataSetChanges
+{
+public:
+	typedef uint64_t Version;
+
+	enum class Kind : uint8_t { values, labels, columnType, columnName, rows, columns, filter, everything };
+
+	struct Change
+	{
+		Version		version;
+		int			columnId;	///< -1 when it is not about a single column
+		size_t		firstRow,
+					rowCount;	///< ALL_ROWS when the whole column (or the DataSet) is affected
+		Kind		kind;
+	};
+
+	static const size_t CAPACITY = 1024;
+	static const size_t ALL_ROWS = SIZE_MAX;
+
+	DataSetChanges();
+
+	Version		record(Kind kind, int columnId = -1, size_t firstRow = 0, size_t rowCount = ALL_ROWS);
+	Version		latest()		const { return _next.load(std::memory_order_acquire) - 1; }
+
+	///Appends the changes after seen to changes and moves seen along. Returns false if some of them were lost, then the reader should assume everything changed.
+	bool		since(Version & seen, std::vector<Change> & changes)	const;
+	bool		columnsChangedSince(Version & seen)						const;	///< Were columns added, removed or renamed? Also moves seen along
+
+private:
+	struct Slot
+	{
+		std::atomic<Version>	published;
+		Change					change;
+	};
+
+	static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "The versions are shared between processes, so their atomics must not depend on a lock in one of them");
+
+	Version					_first;
+	std::atomic<Version>	_next;
+	Slot					_slots[CAPACITY];
+};
+
+#endif // DATASETCHANGES_H
@@ -0,0 +1,43 @@
+#include "datasetsizeplanner.h"
+#include "columnbuffer.h"
+#include "column.h"
+#include "label.h"
+#include <algorithm>
+
+//Every allocation in the segment carries a header of the allocator, this is a generous guess of it
+static const size_t ALLOCATION_OVERHEAD	= 2 * ColumnBuffer::CACHE_LINE;
+//Room for the DataSet, the names of the columns and the bookkeeping of the segment manager itself
+static const size_t BASE_BYTES			= 1024 * 1024;
+//A guess of the text of a label plus its share of the hashtable of the StringPool
+static const size_t LABEL_TEXT_BYTES	= 64;
+
+size_t DataSetSizePlanner::_alignedAllocation(size_t bytes)
+{
+	return ((bytes + ColumnBuffer::CACHE_LINE - 1) / ColumnBuffer::CACHE_LINE) * ColumnBuffer::CACHE_LINE + ALLOCATION_OVERHEAD;
+}
+
+void DataSetSizePlanner::addColumn(size_t rows, bool scale, size_t labelCount)
+{
+	_columns++;
+	_maxRows = std::max(_maxRows, rows);
+
+	_columnBytes += _alignedAllocation(rows * ColumnBuffer::elementSize(ColumnBuffer::Layout::ints));
+
+	//The importers size all columns as ints first and a scale column then gets a fresh buffer of doubles, the ints leave a hole that usually stays empty
+	if(scale)
+		_columnBytes += _alignedAllocation(rows * ColumnBuffer::elementSize(ColumnBuffer::Layout::doubles));
+
+	//Labels are pushed back one by one, so the vector can end up with up to twice the room it needs
+	//and their key index is kept between a quarter and half full. Their texts go in the StringPool.
+	if(labelCount > 0)
+		_columnBytes += _alignedAllocation(2 * labelCount * sizeof(Label)) + _alignedAllocation(4 * labelCount * sizeof(int)) + labelCount * LABEL_TEXT_BYTES;
+}
+
+size_t DataSetSizePlanner::plannedBytes() const
+{
+	size_t	columnObjects	= _alignedAllocation(2 * _columns * sizeof(Column)),	//Columns is a vector as well
+			filterBitmap	= _alignedAllocation((_maxRows + 63) / 64 * sizeof(uint64_t)),
+			total			= BASE_BYTES + columnObjects + filterBitmap + _columnBytes;
+
+	return total + total / 10; //Some slack for fragmentation, growing once more later on is much more expensive than this
+}
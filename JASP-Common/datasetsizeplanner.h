@@ -0,0 +1,29 @@
+#ifndef DATASETSIZEPLANNER_H
+#define DATASETSIZEPLANNER_H
+
+#include <cstddef>
+
+/*
+ * DataSetSizePlanner estimates how large the shared memory segment needs to be to hold a DataSet before it is filled.
+ * An importer describes every column it is about to load (rows, whether it will be scale and how many labels it will get)
+ * and passes plannedBytes() to SharedMemory::reserveDataSet, which then grows the segment once.
+ * Without this a big load starts out in the default segment and goes through many rounds of bad_alloc -> enlargeDataSet -> retry.
+ * The estimate errs on the large side, whatever is left over gets reported by SharedMemory::logMemoryUsage.
+ */
+class DataSetSizePlanner
+{
+public:
+	void	addColumn(size_t rows, bool scale, size_t labelCount);
+
+	size_t	columnCount()	const { return _columns; }
+	size_t	plannedBytes()	const;
+
+private:
+	static size_t	_alignedAllocation(size_t bytes);
+
+	size_t	_columns		= 0,
+			_maxRows		= 0,
+			_columnBytes	= 0;
+};
+
+#endif // DATASETSIZEPLANNER_H
@@ -0,0 +1,30 @@
+#include "datasetversions.h"
+
+DataSetVersions::Epoch DataSetVersions::pin(size_t reader)
+{
+	if(reader >= MAX_READERS)
+		return UNPINNED;
+
+	WriteLock lock(_mutex);
+
+	return _pins[reader] = _committed;
+}
+
+void DataSetVersions::unpin(size_t reader)
+{
+	if(reader >= MAX_READERS)
+		return;
+
+	WriteLock lock(_mutex);
+
+	_pins[reader] = UNPINNED;
+}
+
+bool DataSetVersions::pinnedBetween(Epoch from, Epoch until) const
+{
+	for(Epoch pinned : _pins)
+		if(pinned != UNPINNED && pinned >= from && pinned < until)
+			return true;
+
+	return false;
+}
@@ -0,0 +1,52 @@
+#ifndef DATASETVERSIONS_H
+#define DATASETVERSIONS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <boost/interprocess/sync/interprocess_mutex.hpp>
+#include <boost/interprocess/sync/interprocess_sharable_mutex.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/interprocess/sync/sharable_lock.hpp>
+
+/*
+ * DataSetVersions lets the Engines read a consistent DataSet while the contents of a column are changed, without pausing them.
+ * Every write to a column (see DataSet::ColumnWrite) gets the next epoch. Before anything is changed the column is copied
+ * into an immutable snapshot that keeps the epoch the column had until then, and that is chained behind the live column.
+ * An Engine pins the last committed epoch when an analysis starts and reads the newest version of every column that
+ * is not newer than its pin (Column::version). Once no pin can see a snapshot anymore the writer throws it away.
+ *
+ * This only covers the contents of existing columns: adding or removing columns, changing the row count,
+ * loading data and growing the segment still pause the Engines.
+ */
+class DataSetVersions
+{
+public:
+	typedef uint64_t																				Epoch;
+	typedef boost::interprocess::interprocess_sharable_mutex										Mutex;
+	typedef boost::interprocess::sharable_lock<Mutex>												ReadLock;	///< Hold while reading from a resolved version
+	typedef boost::interprocess::scoped_lock<Mutex>													WriteLock;	///< Taken by writers to snapshot and to commit
+	typedef boost::interprocess::scoped_lock<boost::interprocess::interprocess_mutex>				WriterLock;
+
+	static const size_t	MAX_READERS	= 64;
+	static const Epoch	UNPINNED	= 0;
+
+	Epoch	pin(size_t reader);								///< Returns the epoch the reader is now reading, UNPINNED if there is no slot for it
+	void	unpin(size_t reader);
+	Epoch	readEpoch(Epoch pinned)					const	{ return pinned == UNPINNED ? _committed : pinned; } ///< Unpinned readers see the last commit, call while holding a ReadLock
+
+	Mutex								&	mutex()			{ return _mutex;	}
+	boost::interprocess::interprocess_mutex	&	writers()	{ return _writers;	}
+
+	//These expect the caller to hold a lock on mutex()
+	Epoch	committed()								const	{ return _committed; }
+	void	commit(Epoch epoch)								{ _committed = epoch; }
+	bool	pinnedBetween(Epoch from, Epoch until)	const;	///< Is any reader pinned at an epoch in [from, until)?
+
+private:
+	Mutex										_mutex;		///< Guards the pins, the commits and the version chains of the columns
+	boost::interprocess::interprocess_mutex		_writers;	///< Only one column is written at a time, otherwise a commit could make another half-written column visible
+	Epoch										_committed			= 1,
+												_pins[MAX_READERS]	= {};
+};
+
+#endif // DATASETVERSIONS_H
@@ -0,0 +1,168 @@
+#include "filterbitmap.h"
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+static inline size_t popCount(uint64_t word)		{ return __popcnt64(word); }
+static inline size_t trailingZeros(uint64_t word)	{ unsigned long index; _BitScanForward64(&index, word); return index; }
+#else
+static inline size_t popCount(uint64_t word)		{ return __builtin_popcountll(word); }
+static inline size_t trailingZeros(uint64_t word)	{ return __builtin_ctzll(word); }
+#endif
+
+void FilterBitmap::reset(size_t rows)
+{
+	_rows		= rows;
+	_passing	= rows;
+
+	_words.assign((rows + 63) / 64, ~uint64_t(0));
+
+	if(rows % 64 != 0)
+		_words.back() = (uint64_t(1) << (rows % 64)) - 1;
+}
+
+bool FilterBitmap::assign(const std::vector<bool> & passes)
+{
+	bool	changed	= false;
+	size_t	rows	= std::min(passes.size(), _rows);
+
+	for(size_t word = 0; word * 64 < rows; word++)
+	{
+		uint64_t	bits	= _words[word];
+		size_t		first	= word * 64,
+					last	= std::min(first + 64, rows);
+
+		for(size_t row = first; row < last; row++)
+			if(passes[row])	bits |=  (uint64_t(1) << (row - first));
+			else			bits &= ~(uint64_t(1) << (row - first));
+
+		if(bits != _words[word])
+		{
+			_words[word]	= bits;
+			changed			= true;
+		}
+	}
+
+	if(changed)
+		_recount();
+
+	return changed;
+}
+
+bool FilterBitmap::set(size_t row, bool passes)
+{
+	if(row >= _rows || test(row) == passes)
+		return false;
+
+	_words[row / 64] ^= uint64_t(1) << (row % 64);
+
+	if(passes)	_passing++;
+	else		_passing--;
+
+	return true;
+}
+
+void FilterBitmap::insertRows(size_t row, size_t count, bool passes)
+{
+	if(count == 0)
+		return;
+
+	row			= std::min(row, _rows);
+
+	size_t tail	= _rows - row;
+
+	_words.resize((_rows + count + 63) / 64, 0); //First, so nothing changed yet if this throws
+	_rows += count;
+
+	//From the back, a word at a time, so nothing gets overwritten before it moved
+	for(size_t done = tail; done > 0;)
+	{
+		size_t bits = std::min<size_t>(64, done);
+		done -= bits;
+		_setBitsAt(row + count + done, _bitsAt(row + done), bits);
+	}
+
+	for(size_t done = 0; done < count; done += 64)
+		_setBitsAt(row + done, passes ? ~uint64_t(0) : 0, std::min<size_t>(64, count - done));
+
+	if(passes)
+		_passing += count;
+}
+
+void FilterBitmap::eraseRows(size_t row, size_t count)
+{
+	if(row >= _rows || count == 0)
+		return;
+
+	count		= std::min(count, _rows - row);
+
+	size_t tail	= _rows - row - count;
+
+	for(size_t done = 0; done < tail; done += 64)
+		_setBitsAt(row + done, _bitsAt(row + count + done), std::min<size_t>(64, tail - done));
+
+	_rows -= count;
+	_words.resize((_rows + 63) / 64);
+	_clearPastEnd();
+	_recount();
+}
+
+uint64_t FilterBitmap::_bitsAt(size_t bit) const
+{
+	size_t		word	= bit / 64,
+				shift	= bit % 64;
+	uint64_t	bits	= word < _words.size() ? _words[word] >> shift : 0;
+
+	if(shift != 0 && word + 1 < _words.size())
+		bits |= _words[word + 1] << (64 - shift);
+
+	return bits;
+}
+
+void FilterBitmap::_setBitsAt(size_t bit, uint64_t bits, size_t count)
+{
+	uint64_t	mask	= count == 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+	size_t		word	= bit / 64,
+				shift	= bit % 64;
+
+	bits &= mask;
+
+	_words[word] = (_words[word] & ~(mask << shift)) | (bits << shift);
+
+	if(shift != 0 && shift + count > 64)
+		_words[word + 1] = (_words[word + 1] & ~(mask >> (64 - shift))) | (bits >> (64 - shift));
+}
+
+void FilterBitmap::_clearPastEnd()
+{
+	if(_rows % 64 != 0)
+		_words.back() &= (uint64_t(1) << (_rows % 64)) - 1;
+}
+
+void FilterBitmap::passingRows(std::vector<size_t> & rows) const
+{
+	rows.clear();
+	rows.reserve(_passing);
+
+	for(size_t word = 0; word < _words.size(); word++)
+		for(uint64_t bits = _words[word]; bits != 0; bits &= bits - 1)
+			rows.push_back(word * 64 + trailingZeros(bits));
+}
+
+std::vector<bool> FilterBitmap::toVector() const
+{
+	std::vector<bool> out(_rows);
+
+	for(size_t row = 0; row < _rows; row++)
+		out[row] = test(row);
+
+	return out;
+}
+
+void FilterBitmap::_recount()
+{
+	_passing = 0;
+
+	for(uint64_t word : _words)
+		_passing += popCount(word);
+}
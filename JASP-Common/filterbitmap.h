@@ -0,0 +1,51 @@
+#ifndef FILTERBITMAP_H
+#define FILTERBITMAP_H
+
+#include <vector>
+#include <cstdint>
+#include <boost/interprocess/managed_shared_memory.hpp>
+#include <boost/container/vector.hpp>
+
+/*
+ * FilterBitmap stores which rows of the DataSet pass the filter, one bit per row packed in 64-bit words, in shared memory.
+ * It keeps track of how many rows pass while it is changed so filteredRowCount() is free,
+ * and passingRows() turns it into the list of passing rows with a popcount/count-trailing-zeros walk over the words,
+ * so that readers like rbridge_readDataSet can gather the rows they need instead of testing every cell.
+ * The bits past the last row in the last word are always zero.
+ */
+class FilterBitmap
+{
+public:
+	typedef boost::interprocess::managed_shared_memory::segment_manager					SegmentManager;
+	typedef boost::interprocess::allocator<uint64_t, SegmentManager>					WordAllocator;
+	typedef boost::container::vector<uint64_t, WordAllocator>							Words;
+
+	FilterBitmap(SegmentManager * segment) : _words(segment) {}
+	FilterBitmap(SegmentManager * segment, const FilterBitmap & other) : _words(other._words.begin(), other._words.end(), WordAllocator(segment)), _rows(other._rows), _passing(other._passing) {} ///< Copies other into segment
+
+	void				reset(size_t rows);										///< All rows pass
+	bool				assign(const std::vector<bool> & passes);				///< Sets the rows that passes covers, returns whether anything changed
+	bool				set(size_t row, bool passes);							///< Returns whether it changed
+	void				insertRows(size_t row, size_t count, bool passes);		///< The rows from row on move count further, the new ones pass or not
+	void				eraseRows(size_t row, size_t count);					///< The rows after them move back count
+
+	bool				test(size_t row)		const { return row < _rows && (_words[row / 64] >> (row % 64)) & 1; }
+	size_t				size()					const { return _rows;			}
+	size_t				passingCount()			const { return _passing;		}
+	bool				allPass()				const { return _passing == _rows; }
+
+	void				passingRows(std::vector<size_t> & rows)	const;		///< Fills rows with the indices of the rows that pass, in order
+	std::vector<bool>	toVector()								const;
+
+private:
+	void				_recount();
+	uint64_t			_bitsAt(size_t bit)								const;	///< The 64 bits starting at bit, zeroes past the end
+	void				_setBitsAt(size_t bit, uint64_t bits, size_t count);	///< Writes the lowest count (at most 64) of bits starting at bit
+	void				_clearPastEnd();
+
+	Words	_words;
+	size_t	_rows		= 0,
+			_passing	= 0;
+};
+
+#endif // FILTERBITMAP_H
@@ -17,52 +17,45 @@
 
 #include "ipcchannel.h"
 #include "tempfiles.h"
+#include "processinfo.h"
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include "boost/nowide/convert.hpp"
+#include <algorithm>
+#include <chrono>
+#include <thread>
 #include "log.h"
 
 using namespace std;
 using namespace boost;
 using namespace boost::posix_time;
 
-IPCChannel::IPCChannel(std::string name, size_t channelNumber, bool isSlave)
+const size_t IPCChannel::RING_BYTES;
+const size_t IPCChannel::SEND_STALL_SECONDS;
+
+IPCChannel::IPCChannel(std::string name, size_t channelNumber, bool isSlave, size_t ringBytes)
 	:
 	  _baseName(		name + "#" + std::to_string(channelNumber)	),
-	  _nameControl(		name + "_control"							),
-	  _nameMtS(			name + "_MasterToSlave"						),
-	  _nameStM(			name + "_SlaveToMaster"						),
+	  _nameMtS(			_baseName + "_MasterToSlave"				),
+	  _nameStM(			_baseName + "_SlaveToMaster"				),
 	  _channelNumber(	channelNumber								),
 	  _isSlave(			isSlave										)
 {
-	_memoryControl			= new interprocess::managed_shared_memory(interprocess::open_or_create, _baseName.c_str(), 4096);
-
-	_sizeMtoS				= _memoryControl->find_or_construct<size_t>("sizeMasterToSlave")(1024 * 1024 * 8);
-	_sizeStoM				= _memoryControl->find_or_construct<size_t>("sizeSlaveToMaster")(1024 * 1024 * 8);
+	const size_t segmentSize = ringBytes + 64 * 1024; //Room for the IPCRing itself and the bookkeeping of the segment
 
-	_memoryMasterToSlave	= new interprocess::managed_shared_memory(interprocess::open_or_create, _nameMtS.c_str(), *_sizeMtoS);
-	_memorySlaveToMaster	= new interprocess::managed_shared_memory(interprocess::open_or_create, _nameStM.c_str(), *_sizeStoM);
+	_memoryMasterToSlave	= new interprocess::managed_shared_memory(interprocess::open_or_create, _nameMtS.c_str(), segmentSize);
+	_memorySlaveToMaster	= new interprocess::managed_shared_memory(interprocess::open_or_create, _nameStM.c_str(), segmentSize);
 
-	TempFiles::addShmemFileName(_baseName);
 	TempFiles::addShmemFileName(_nameMtS);
 	TempFiles::addShmemFileName(_nameStM);
 
 	generateNames();
 
-	_mutexIn  = _memoryControl->find_or_construct<interprocess::interprocess_mutex>(_mutexInName.c_str())();
-	_mutexOut = _memoryControl->find_or_construct<interprocess::interprocess_mutex>(_mutexOutName.c_str())();
-
-	_memoryIn  = _isSlave ? _memoryMasterToSlave : _memorySlaveToMaster;
-	_memoryOut = _isSlave ? _memorySlaveToMaster : _memoryMasterToSlave;
-
-	_sizeIn  = _isSlave ? _sizeMtoS : _sizeStoM;
-	_sizeOut = _isSlave ? _sizeStoM : _sizeMtoS;
+	interprocess::managed_shared_memory	*	memoryIn	= _isSlave ? _memoryMasterToSlave : _memorySlaveToMaster,
+										*	memoryOut	= _isSlave ? _memorySlaveToMaster : _memoryMasterToSlave;
 
-	_previousSizeIn = *_sizeIn;
-	_previousSizeOut = *_sizeOut;
-
-	_dataIn		= _memoryIn->find_or_construct<String>(_dataInName.c_str())		(_memoryIn->get_segment_manager());
-	_dataOut	= _memoryOut->find_or_construct<String>(_dataOutName.c_str())	(_memoryOut->get_segment_manager());
+	_ringIn		= memoryIn->find_or_construct<IPCRing>(_ringInName.c_str())		(memoryIn->get_segment_manager(),	ringBytes);
+	_ringOut	= memoryOut->find_or_construct<IPCRing>(_ringOutName.c_str())	(memoryOut->get_segment_manager(),	ringBytes);
 
 #ifdef __APPLE__
 	_semaphoreIn  = sem_open(_mutexInName.c_str(),  O_CREAT, S_IWUSR | S_IRGRP | S_IROTH, 0);
@@ -123,28 +116,27 @@ IPCChannel::~IPCChannel()
 	if(_isSlave)
 		return;
 
-	delete _memoryControl;
 	delete _memoryMasterToSlave;
 	delete _memorySlaveToMaster;
 
-	_memoryControl			= nullptr;
 	_memoryMasterToSlave	= nullptr;
 	_memorySlaveToMaster	= nullptr;
+	_ringIn					= nullptr;
+	_ringOut				= nullptr;
 
-	interprocess::shared_memory_object::remove(_baseName.c_str());
 	interprocess::shared_memory_object::remove(_nameMtS.c_str());
 	interprocess::shared_memory_object::remove(_nameStM.c_str());
 }
 
 void IPCChannel::generateNames()
 {
-	stringstream mutexInName, mutexOutName, dataInName, dataOutName, semaphoreInName, semaphoreOutName;
+	stringstream mutexInName, mutexOutName, ringInName, ringOutName, semaphoreInName, semaphoreOutName;
 
 	std::string in  = _isSlave ? "-s" : "-m";
 	std::string out = _isSlave ? "-m" : "-s";
 
-	dataInName			<< _baseName << in  << 'd' << _channelNumber;
-	dataOutName			<< _baseName << out << 'd' << _channelNumber;
+	ringInName			<< _baseName << in  << 'r' << _channelNumber;
+	ringOutName			<< _baseName << out << 'r' << _channelNumber;
 	mutexInName			<< _baseName << in  << 'm' << _channelNumber;
 	mutexOutName		<< _baseName << out << 'm' << _channelNumber;
 	semaphoreInName		<< _baseName << in  << 's' << _channelNumber;
@@ -154,72 +146,57 @@ void IPCChannel::generateNames()
 	_semaphoreInName	= semaphoreInName.str();
 	_mutexOutName		= mutexOutName.str();
 	_mutexInName		= mutexInName.str();
-	_dataOutName		= dataOutName.str();
-	_dataInName			= dataInName.str();
+	_ringOutName		= ringOutName.str();
+	_ringInName			= ringInName.str();
 }
 
-void IPCChannel::rebindMemoryInIfSizeChanged()
+void IPCChannel::send(const string & data)
 {
-	if(_previousSizeIn < *_sizeIn)
-	{
-		Log::log() << "rebindMemoryInIfSizeChanged! Size changed!\n" << std::flush;
+	//A message longer than a frame goes in pieces, the receiver puts them back together
+	size_t	maxFrame	= _ringOut->maxFrame(),
+			offset		= 0;
 
-		delete _memoryIn;
-		_previousSizeIn = *_sizeIn;
-		_memoryIn		= new interprocess::managed_shared_memory(interprocess::open_only, _isSlave ? _nameMtS.c_str() : _nameStM.c_str());
+	do
+	{
+		size_t	piece	= std::min(maxFrame, data.size() - offset);
+		bool	last	= offset + piece == data.size();
 
-		if(_isSlave)	_memoryMasterToSlave	= _memoryIn;
-		else			_memorySlaveToMaster	= _memoryIn;
+		if(!_ringOut->tryPush(data.data() + offset, piece, last))
+			waitForRoom(data.data() + offset, piece, last);
 
-		_dataIn = _memoryIn->find<String>(_dataInName.c_str()).first;
+		offset += piece;
 	}
-}
-
-void IPCChannel::doubleMemoryOut()
-{
-	Log::log() << "IPCChannel::doubleMemoryOut is called and new memsize: ";
-
-	std::string memOutName = _isSlave ? _nameStM : _nameMtS;
-
-	_memoryOut->destroy<String>(_dataOutName.c_str());
-
-	if(!interprocess::managed_shared_memory::grow(memOutName.c_str(), *_sizeOut))
-		throw std::runtime_error("Growing IPCChannel failed!");
+	while(offset < data.size());
 
-	_memoryOut = new interprocess::managed_shared_memory(interprocess::open_only, memOutName.c_str());
-
-	if(_isSlave)	_memorySlaveToMaster = _memoryOut;
-	else			_memoryMasterToSlave = _memoryOut;
-
-	_dataOut	= _memoryOut->construct<String>(_dataOutName.c_str())(_memoryOut->get_segment_manager());
-	*_sizeOut	= _memoryOut->get_size();
-
-	Log::log() << *_sizeOut << "\n" << std::flush;
+	post();
 }
 
-void IPCChannel::send(string &&data, bool alreadyLockedMutex)
+void IPCChannel::waitForRoom(const char * data, size_t size, bool lastOfMessage)
 {
-	send(data, alreadyLockedMutex);
-}
+	post(); //Whatever is in there already might be all the receiver needs to start reading
 
+	uint64_t								consumed		= _ringOut->consumed();
+	std::chrono::steady_clock::time_point	stalledSince	= std::chrono::steady_clock::now();
 
-void IPCChannel::send(string &data, bool alreadyLockedMutex)
-{
-	if(!alreadyLockedMutex)
-		_mutexOut->lock();
-
-	try
+	while(!_ringOut->tryPush(data, size, lastOfMessage))
 	{
-		_dataOut->assign(data.begin(), data.end());
-	}
-	catch (boost::interprocess::bad_alloc &e)	{ goto retryAfterDoublingMemory; }
-	catch (std::length_error &e)				{ goto retryAfterDoublingMemory; }
-	catch(std::exception & e)
-	{
-		Log::log() << "IPCChannel::send encountered an exception: " << e.what() << std::endl;
-		throw e; //no need to unlock because this will crash stuff
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		if(_ringOut->consumed() != consumed)
+		{
+			consumed		= _ringOut->consumed();
+			stalledSince	= std::chrono::steady_clock::now();
+		}
+		else if(_isSlave ? !ProcessInfo::isParentRunning() : std::chrono::steady_clock::now() - stalledSince > std::chrono::seconds(SEND_STALL_SECONDS))
+		{
+			Log::log() << "IPCChannel::send gave up waiting for room in the channel, the other side stopped reading it." << std::endl;
+			throw std::runtime_error("IPCChannel is full and nobody reads it!");
+		}
 	}
+}
 
+void IPCChannel::post()
+{
 #ifdef __APPLE__
 	sem_post(_semaphoreOut);
 #elif defined _WIN32
@@ -227,47 +204,54 @@ void IPCChannel::send(string &data, bool alreadyLockedMutex)
 #else
 	_semaphoreOut->post();
 #endif
+}
 
+bool IPCChannel::receive(string &data, int timeout)
+{
+	if(_receivedIn.empty() && !takeFromRing(timeout))
+		return false;
 
-	_mutexOut->unlock();
-	return; // return here to avoid going to retryAfterDoublingMemory
-
-retryAfterDoublingMemory:
-		Log::log() << "IPCChannel::send out buffer is too small!\n" << std::flush;
-
-		doubleMemoryOut();
+	data = std::move(_receivedIn.front());
+	_receivedIn.pop_front();
 
-		send(data, true); //try again!
+	return true;
 }
 
-bool IPCChannel::receive(string &data, int timeout)
+size_t IPCChannel::receiveAll(std::deque<string> & messages, int timeout)
 {
+	if(_receivedIn.empty() && !takeFromRing(timeout))
+		return 0;
 
-	if (tryWait(timeout))
-	{
-		_mutexIn->lock();
+	size_t count = _receivedIn.size();
 
-		while (tryWait()); // clear it completely
+	std::move(_receivedIn.begin(), _receivedIn.end(), std::back_inserter(messages));
+	_receivedIn.clear();
 
-		try
-		{
-			rebindMemoryInIfSizeChanged();
-			data.assign(_dataIn->c_str(), _dataIn->size());
-		}
-		catch(std::exception & e)
-		{
-			Log::log() << "IPCChannel::receive encountered an exception: " << e.what() << std::endl;
-			throw e;
-		}
-
-		_mutexIn->unlock();
+	return count;
+}
 
+bool IPCChannel::takeFromRing(int timeout)
+{
+	//The ring is always checked before waiting, so a wake-up that was already used up for an earlier message never leaves one behind
+	if(_ringIn->drain(_partialIn, _receivedIn) > 0)
 		return true;
-	}
 
-	return false;
+	if(!tryWait(timeout))
+		return false;
+
+	while (tryWait()); // clear it completely, everything that was posted for is in the ring already
+
+	return _ringIn->drain(_partialIn, _receivedIn) > 0;
 }
 
+void IPCChannel::discardReceived()
+{
+	_ringIn->discard();
+	_partialIn.clear();
+	_receivedIn.clear();
+
+	while (tryWait());
+}
 
 bool IPCChannel::tryWait(int timeout)
 {
@@ -306,8 +290,3 @@ bool IPCChannel::tryWait(int timeout)
 	return messageWaiting;
 
 }
-
-std::string IPCChannel::lastSentMsg() const
-{
-	return _dataOut->data();
-}
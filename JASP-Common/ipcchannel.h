@@ -35,58 +35,57 @@
 #endif
 
 #include <boost/interprocess/managed_shared_memory.hpp>
-#include <boost/container/string.hpp>
-
-typedef boost::interprocess::allocator<char,	boost::interprocess::managed_shared_memory::segment_manager	> CharAllocator;
-typedef boost::container::basic_string<char,	std::char_traits<char>, CharAllocator						> String;
-typedef boost::interprocess::allocator<String,	boost::interprocess::managed_shared_memory::segment_manager	> StringAllocator;
+#include <deque>
+#include "ipcring.h"
 
+/*
+ * IPCChannel connects the Desktop (master) with one Engine (slave) through a shared memory segment per direction,
+ * each holding an IPCRing so a side can queue as many messages as it likes without waiting for the other to read the previous one.
+ * send() waits only when the ring is full, and when the other side doesn't read anymore it gives up: the master after SEND_STALL_SECONDS
+ * without progress and the slave as soon as its parent is gone. The semaphores only wake up the receiver, receive() always looks in the ring first.
+ *
+ * The size of the rings only limits how much can be waiting to be read, not how big a message can be, because those go in pieces.
+ * Only the master decides it: it creates the segments before starting the slave, which then finds the rings in them as they are.
+ */
 class IPCChannel
 {
 public:
-	IPCChannel(std::string name, size_t channelNumber, bool isSlave = false);
-	~IPCChannel();
+	static const size_t	RING_BYTES			= 1024 * 1024,	///< Per direction, the default. Big enough for all but the largest results to be sent in one go without the engine waiting for the Desktop
+						SEND_STALL_SECONDS	= 30;
 
-	std::string lastSentMsg() const;
+	IPCChannel(std::string name, size_t channelNumber, bool isSlave = false, size_t ringBytes = RING_BYTES);
+	~IPCChannel();
 
-	void send(std::string		&	data,	bool alreadyLockedMutex = false);
-	void send(std::string		&&	data,	bool alreadyLockedMutex = false);
-	bool receive(std::string	&	data,	int timeout = 0);
+	void	send(const std::string	&	data);
+	bool	receive(std::string		&	data,		int timeout = 0);	///< Gives the oldest message that came in
+	size_t	receiveAll(std::deque<std::string> & messages,	int timeout = 0);	///< Appends all messages that came in, returns how many
+	void	discardReceived();	///< Drops all that came in and wasn't received yet, for when the other side was restarted
 
 	size_t channelNumber() { return _channelNumber; }
 
 private:
 	bool tryWait(int timeout = 0);
+	void post();
+	void waitForRoom(const char * data, size_t size, bool lastOfMessage);
+	bool takeFromRing(int timeout);
 
-	void doubleMemoryOut();
-	void rebindMemoryInIfSizeChanged();
 	void generateNames();
 
 	std::string										_baseName,
-													_nameControl,
 													_nameMtS,
 													_nameStM;
 	size_t											_channelNumber;
 	bool											_isSlave;
-	boost::interprocess::managed_shared_memory	*	_memoryControl			= nullptr,
-												*	_memoryMasterToSlave	= nullptr,
-												*	_memorySlaveToMaster	= nullptr,
-												*	_memoryIn				= nullptr,
-												*	_memoryOut				= nullptr;
-	boost::interprocess::interprocess_mutex		*	_mutexOut				= nullptr,
-												*	_mutexIn				= nullptr;
-	String										*	_dataOut				= nullptr,
-												*	_dataIn					= nullptr;
-	size_t										*	_sizeMtoS				= nullptr,
-												*	_sizeStoM				= nullptr,
-												*	_sizeIn					= nullptr,
-												*	_sizeOut				= nullptr,
-													_previousSizeIn,
-													_previousSizeOut;
+	boost::interprocess::managed_shared_memory	*	_memoryMasterToSlave	= nullptr,
+												*	_memorySlaveToMaster	= nullptr;
+	IPCRing										*	_ringIn					= nullptr,
+												*	_ringOut				= nullptr;
+	std::string										_partialIn;
+	std::deque<std::string>							_receivedIn;
 	std::string										_mutexInName,
 													_mutexOutName,
-													_dataInName,
-													_dataOutName,
+													_ringInName,
+													_ringOutName,
 													_semaphoreInName,
 													_semaphoreOutName;
 #ifdef __APPLE__
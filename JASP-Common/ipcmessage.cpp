@@ -0,0 +1,94 @@
+//
+// Copyright (C) 2013-2018 University of Amsterdam
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "ipcmessage.h"
+#include <cstring>
+#include <stdexcept>
+
+const int32_t IPCMessage::NO_TYPE;
+const uint8_t IPCMessage::VERSION;
+
+std::string IPCMessage::encode(const Json::Value & json)
+{
+	int32_t type = NO_TYPE;
+
+	if(json.isObject() && json.get("typeRequest", Json::nullValue).isString())
+	{
+		std::string typeRequest = json["typeRequest"].asString();
+
+		try							{ type = int32_t(engineStateFromString(typeRequest)); }
+		catch(missingEnumVal &)		{} //Then the receiver can have a look at it itself
+	}
+
+	std::string body = Json::FastWriter().write(json);
+
+	if(!body.empty() && body.back() == '\n') //FastWriter ends with one, nobody needs it
+		body.pop_back();
+
+	return encode(body, type);
+}
+
+std::string IPCMessage::encode(const std::string & json, int32_t type)
+{
+	Header header;
+
+	header.magic[0]	= 'J';
+	header.magic[1]	= 'M';
+	header.version	= VERSION;
+	header.body		= json.empty() ? Body::empty : Body::json;
+	header.type		= type;
+	header.length	= json.size();
+
+	std::string message;
+
+	message.reserve(sizeof(Header) + json.size());
+	message.append(reinterpret_cast<const char *>(&header), sizeof(Header));
+	message.append(json);
+
+	return message;
+}
+
+IPCMessage::Decoded IPCMessage::decode(const std::string & message, Json::Value & json)
+{
+	Header header;
+
+	if(message.size() < sizeof(Header))
+		throw std::runtime_error("IPCMessage of " + std::to_string(message.size()) + " bytes is too short to even hold its header");
+
+	std::memcpy(&header, message.data(), sizeof(Header));
+
+	if(header.magic[0] != 'J' || header.magic[1] != 'M' || header.version != VERSION)
+		throw std::runtime_error("IPCMessage has an unknown header, the other side might be a different version of JASP");
+
+	if(header.length != message.size() - sizeof(Header))
+		throw std::runtime_error("IPCMessage says its body is " + std::to_string(header.length) + " bytes but it is " + std::to_string(message.size() - sizeof(Header)));
+
+	Decoded decoded;
+
+	decoded.body	= header.body;
+	decoded.type	= header.type;
+
+	if(decoded.body == Body::json)
+	{
+		const char * body = message.data() + sizeof(Header);
+		decoded.parsed = Json::Reader().parse(body, body + header.length, json, false);
+	}
+	else
+		json = Json::nullValue;
+
+	return decoded;
+}
@@ -0,0 +1,69 @@
+//
+// Copyright (C) 2013-2018 University of Amsterdam
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef IPCMESSAGE_H
+#define IPCMESSAGE_H
+
+#include <cstdint>
+#include <string>
+#include "enginedefinitions.h"
+#include "jsonredirect.h"
+
+/*
+ * IPCMessage is how the Desktop and the Engines frame what they send each other over an IPCChannel:
+ * a fixed Header that says what kind of message it is (the engineState of its "typeRequest") and how long the body is, followed by the body.
+ * The body is compact json, without the indentation of toStyledString, which made a big table of results several times bigger than it is.
+ * Json that already is a string, like the results coming from R, goes in as it is instead of being parsed and written out again just to frame it.
+ * Both sides run on the same machine, so the header is in its native byte order.
+ */
+class IPCMessage
+{
+public:
+	enum class Body : uint8_t { empty, json };
+
+	static const int32_t	NO_TYPE = -1;	///< For a message whose sender didn't say what it is, then the "typeRequest" in the body does
+
+	struct Header
+	{
+		char		magic[2];
+		uint8_t		version;
+		Body		body;
+		int32_t		type;		///< An engineState or NO_TYPE
+		uint64_t	length;		///< Of the body that follows
+	};
+
+	struct Decoded
+	{
+		Body		body	= Body::empty;
+		int32_t		type	= NO_TYPE;
+		bool		parsed	= false;	///< Whether there was a json body and it could be parsed
+
+		bool		hasType()	const { return type != NO_TYPE; }
+		engineState	state()		const { return engineState(type); }
+	};
+
+	static const uint8_t	VERSION = 1;
+
+	static std::string	encode(const Json::Value & json);							///< Writes it compact, the type comes from its "typeRequest"
+	static std::string	encode(const std::string & json, int32_t type = NO_TYPE);	///< For json that is a string already, an empty one gives an empty body
+	static Decoded		decode(const std::string & message, Json::Value & json);	///< Throws std::runtime_error when message isn't an IPCMessage
+
+private:
+	static_assert(sizeof(Header) == 16, "The header is the same for both sides and should not get padded differently");
+};
+
+#endif // IPCMESSAGE_H
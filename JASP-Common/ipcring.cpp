@@ -0,0 +1,117 @@
+//
+// Copyright (C) 2013-2018 University of Amsterdam
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "ipcring.h"
+#include <cstring>
+#include <stdexcept>
+
+const size_t IPCRing::ALIGNMENT;
+const size_t IPCRing::CACHE_LINE;
+
+IPCRing::IPCRing(SegmentManager * segment, size_t capacity)
+	: _capacity(capacity / ALIGNMENT * ALIGNMENT), _segment(segment)
+{
+	if(_capacity < 4 * _frameBytes(ALIGNMENT))
+		throw std::runtime_error("IPCRing of " + std::to_string(capacity) + " bytes is too small to hold any messages");
+
+	_bytes = static_cast<char*>(segment->allocate_aligned(_capacity, CACHE_LINE));
+
+	_head.store(0, std::memory_order_relaxed);
+	_tail.store(0, std::memory_order_release);
+}
+
+IPCRing::~IPCRing()
+{
+	if(_bytes)
+		_segment->deallocate(_bytes.get());
+
+	_bytes = nullptr;
+}
+
+bool IPCRing::tryPush(const char * data, size_t size, bool lastOfMessage)
+{
+	if(size > maxFrame())
+		throw std::logic_error("IPCRing::tryPush got a frame of " + std::to_string(size) + " bytes, but they can be at most " + std::to_string(maxFrame()));
+
+	uint64_t	head		= _head.load(std::memory_order_relaxed),
+				tail		= _tail.load(std::memory_order_acquire);
+	size_t		frame		= _frameBytes(size),
+				offset		= head % _capacity,
+				untilEnd	= _capacity - offset,
+				skip		= frame > untilEnd ? untilEnd : 0; //maxFrame() keeps frame + skip below _capacity
+
+	if(_capacity - (head - tail) < frame + skip)
+		return false;
+
+	if(skip > 0)
+	{
+		FrameHeader paddingHeader{ 0, FrameFlag::padding };
+		std::memcpy(_bytes.get() + offset, &paddingHeader, sizeof(FrameHeader));
+
+		head	+= skip;
+		offset	=  0;
+	}
+
+	FrameHeader header{ uint32_t(size), lastOfMessage ? uint32_t(FrameFlag::lastOfMessage) : 0 };
+
+	std::memcpy(_bytes.get() + offset,							&header,	sizeof(FrameHeader));
+	std::memcpy(_bytes.get() + offset + sizeof(FrameHeader),	data,		size);
+
+	_head.store(head + frame, std::memory_order_release); //Only now can the reader see the frame, and all of it
+
+	return true;
+}
+
+size_t IPCRing::drain(std::string & partial, std::deque<std::string> & messages)
+{
+	uint64_t	tail		= _tail.load(std::memory_order_relaxed),
+				head		= _head.load(std::memory_order_acquire);
+	size_t		completed	= 0;
+
+	while(tail != head)
+	{
+		size_t		offset = tail % _capacity;
+		FrameHeader	header;
+
+		std::memcpy(&header, _bytes.get() + offset, sizeof(FrameHeader));
+
+		if(header.flags & FrameFlag::padding)
+		{
+			tail += _capacity - offset;
+			continue;
+		}
+
+		partial.append(_bytes.get() + offset + sizeof(FrameHeader), header.size);
+		tail += _frameBytes(header.size);
+
+		if(header.flags & FrameFlag::lastOfMessage)
+		{
+			messages.push_back(std::move(partial));
+			partial.clear();
+			completed++;
+		}
+	}
+
+	_tail.store(tail, std::memory_order_release);
+
+	return completed;
+}
+
+void IPCRing::discard()
+{
+	_tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+}
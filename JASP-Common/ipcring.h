@@ -0,0 +1,91 @@
+//
+// Copyright (C) 2013-2018 University of Amsterdam
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef IPCRING_H
+#define IPCRING_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <boost/interprocess/managed_shared_memory.hpp>
+#include <boost/interprocess/offset_ptr.hpp>
+
+/*
+ * IPCRing is a queue of messages in shared memory from exactly one writer to exactly one reader, each in its own process.
+ * It is a ring of bytes: the writer puts frames at _head and the reader takes them from _tail, both only ever grow and
+ * each is written by one side only, so neither needs a lock and a full or empty ring is simply head - tail == capacity or 0.
+ *
+ * A frame is a FrameHeader (size and flags) followed by the payload, padded to ALIGNMENT, and is never split over the end of the ring:
+ * if it doesn't fit there the writer puts a padding frame in the rest and continues at the start.
+ * A message longer than maxFrame() is sent as several frames and only the last one is marked as such, so any message fits
+ * in a ring of any size as long as the reader keeps reading. When there is no room tryPush() returns false and the writer
+ * has to wait for the reader, that is the backpressure.
+ *
+ * drain() takes every frame there is in one go and moves the tail only once, so a reader that fell behind catches up cheaply.
+ */
+class IPCRing
+{
+public:
+	typedef boost::interprocess::managed_shared_memory::segment_manager SegmentManager;
+
+	static const size_t	ALIGNMENT	= 8,
+						CACHE_LINE	= 64;
+
+	IPCRing(SegmentManager * segment, size_t capacity); ///< Throws boost::interprocess::bad_alloc if the segment doesn't have capacity bytes
+	~IPCRing();
+
+	IPCRing(const IPCRing &)				= delete;
+	IPCRing & operator=(const IPCRing &)	= delete;
+
+	size_t		capacity()	const { return _capacity; }
+	size_t		maxFrame()	const { return _capacity / 4; }	///< The largest payload that goes in one frame
+	uint64_t	consumed()	const { return _tail.load(std::memory_order_acquire); } ///< Grows every time the reader takes something
+	bool		empty()		const { return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire); }
+
+	//For the writer:
+	bool		tryPush(const char * data, size_t size, bool lastOfMessage); ///< size at most maxFrame(), false if there is no room for it right now
+
+	//For the reader:
+	size_t		drain(std::string & partial, std::deque<std::string> & messages);	///< Appends every message completed to messages, partial keeps the start of one that isn't. Returns how many were completed.
+	void		discard();															///< Drops everything that is in the ring now
+
+private:
+	struct FrameHeader
+	{
+		uint32_t	size,
+					flags;
+	};
+
+	enum FrameFlag : uint32_t { lastOfMessage = 1, padding = 2 };
+
+	static size_t	_frameBytes(size_t size) { return sizeof(FrameHeader) + (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT; }
+
+	static_assert(sizeof(FrameHeader) == ALIGNMENT,	"A frame header must keep the frames after it aligned");
+	static_assert(ATOMIC_LLONG_LOCK_FREE == 2,		"The positions are shared between processes, so their atomics must not depend on a lock in one of them");
+
+	//The head and the tail get a cache line each, otherwise every write of one side makes the other side reload the line it reads
+	std::atomic<uint64_t>								_head;
+	char												_headPadding[CACHE_LINE - sizeof(std::atomic<uint64_t>)];
+	std::atomic<uint64_t>								_tail;
+	char												_tailPadding[CACHE_LINE - sizeof(std::atomic<uint64_t>)];
+	size_t												_capacity;
+	boost::interprocess::offset_ptr<char>				_bytes;
+	boost::interprocess::offset_ptr<SegmentManager>		_segment;
+};
+
+#endif // IPCRING_H
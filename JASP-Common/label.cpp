@@ -17,48 +17,46 @@
 
 #include "label.h"
 
-#include <sstream>
-#include <cstring>
-
-void Label::_setLabel(const std::string &label) {
-    _stringLength = label.length();
-    if (sizeof(_stringValue) < label.length())
-        _stringLength = sizeof(_stringValue);
-
-    std::memcpy(_stringValue, label.c_str(), _stringLength);
+Label::Label(StringPool & pool, const std::string &label, int value, bool filterAllows, bool isText)
+{
+	_stringValue	= pool.intern(label);
+	_originalValue	= _stringValue;
+	_hasIntValue	= !isText;
+	_intValue		= value;
+	_filterAllow	= filterAllows;
 }
 
-Label::Label(const std::string &label, int value, bool filterAllows, bool isText)
+Label::Label(StringPool & pool, int value)
 {
-    _setLabel(label);
-	_hasIntValue = !isText;
-	_intValue = value;
-	_filterAllow = filterAllows;
+	_stringValue	= pool.intern(std::to_string(value));
+	_originalValue	= _stringValue;
+	_hasIntValue	= true;
+	_intValue		= value;
 }
 
-Label::Label(int value)
+Label::Label(StringPool & pool, const Label & other)
 {
-	std::stringstream ss;
-	ss << value;
-	std::string asString = ss.str();
-
-	std::memcpy(_stringValue, asString.c_str(), asString.length());
-	_stringLength = asString.length();
-
-	_hasIntValue = true;
-	_intValue = value;
+	_stringValue	= pool.intern(other.text());
+	_originalValue	= pool.intern(other.originalValue());
+	_hasIntValue	= other._hasIntValue;
+	_intValue		= other._intValue;
+	_filterAllow	= other._filterAllow;
 }
 
 Label::Label()
 {
-	_hasIntValue = false;
-	_intValue = -1;
-	_stringLength = 0;
+	_hasIntValue	= false;
+	_intValue		= -1;
 }
 
 std::string Label::text() const
 {
-	return std::string(_stringValue, _stringLength);
+	return _stringValue.str();
+}
+
+std::string Label::originalValue() const
+{
+	return _originalValue.str();
 }
 
 bool Label::hasIntValue() const
@@ -71,23 +69,17 @@ int Label::value() const
 	return _intValue;
 }
 
-void Label::setLabel(const std::string &label) {
-	_setLabel(label);
+void Label::setLabel(StringPool & pool, const std::string &label)
+{
+	_stringValue = pool.intern(label);
 }
 
-void Label::setValue(int value)
+void Label::setOriginalValue(StringPool & pool, const std::string &originalValue)
 {
-	_intValue = value;
+	_originalValue = pool.intern(originalValue);
 }
 
-Label &Label::operator=(const Label &label)
+void Label::setValue(int value)
 {
-	this->_hasIntValue	= label._hasIntValue;
-	this->_intValue		= label._intValue;
-	this->_filterAllow	= label._filterAllow;
-
-	std::memcpy(_stringValue, label._stringValue, label._stringLength);
-	_stringLength = label._stringLength;
-
-	return *this;
+	_intValue = value;
 }
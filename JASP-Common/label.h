@@ -19,6 +19,7 @@
 #define LABEL_H
 
 #include <string>
+#include "stringpool.h"
 
 /*********
  * Label is a class that stores the value of a column if it is not a Scale (a Nominal Int, Nominal Text, or Ordinal).
@@ -27,35 +28,37 @@
  * _stringValue can be then changed in the Variable tab in JASP.
  * If the value is a string, _intValue is the key that maps the label with the AsInts property of the column object.
  * _stringValue is then the value, that can be changed in the Variable tab in JASP. If changed the original value
- * is saved in the _orgStringValues static property of the Labels class.
+ * is kept in _originalValue.
+ * Both strings live in the StringPool of the segment, so a Label only keeps where they are.
  *********/
 
 class Label
 {
 public:
-	static const int MAX_LABEL_LENGTH = 128;
-	Label(const std::string &label, int value, bool filterAllows, bool isText = true);
-	Label(int value);
+	Label(StringPool & pool, const std::string &label, int value, bool filterAllows, bool isText = true);
+	Label(StringPool & pool, int value);
+	Label(StringPool & pool, const Label & other); ///< A copy with its texts in pool, which can be the pool of another segment
 	Label();
 
 	std::string text() const;
+	size_t textLength() const { return _stringValue.length; }
+	std::string originalValue() const;
 	bool hasIntValue() const;
 	int value() const;
-    void setLabel(const std::string &label);
-	void setValue(int value);
-	Label& operator=(const Label &label);
+	void setLabel(StringPool & pool, const std::string &label);
+	void setOriginalValue(StringPool & pool, const std::string &originalValue);
 
 	bool filterAllows() const { return _filterAllow; }
 	void setFilterAllows(bool allowFilter) { _filterAllow = allowFilter; }
 
 private:
+	friend class Labels;
+	void setValue(int value); ///< Only for Labels, which has to keep its index of the keys up to date
 
-	bool _hasIntValue;
-	int _intValue;
-	char _stringValue[MAX_LABEL_LENGTH];
-	int  _stringLength;
-
-    void _setLabel(const std::string &label);
+	bool				_hasIntValue;
+	int					_intValue;
+	StringPool::Text	_stringValue,
+						_originalValue;
 
 	bool _filterAllow = true;
 };
@@ -28,16 +28,25 @@ const char * labelNotFound::what() const noexcept
 	return std::runtime_error::what();
 }
 
-map<int, map<int, string> > Labels::_orgStringValues;
-int Labels::_counter = 0;
-
 typedef unsigned int uint;
 
-Labels::Labels(boost::interprocess::managed_shared_memory *mem)
-	: _labels(mem->get_segment_manager())
+Labels::Labels(boost::interprocess::managed_shared_memory::segment_manager *mem)
+	: _labels(mem), _keyIndex(mem)
 {
-	 _id = ++Labels::_counter;
-	_mem = mem;
+	_mem	= mem;
+	_pool	= StringPool::pool(mem);
+}
+
+Labels::Labels(boost::interprocess::managed_shared_memory::segment_manager *mem, const Labels & other)
+	: _labels(mem), _keyIndex(other._keyIndex.begin(), other._keyIndex.end(), LabelKeyIndexAllocator(mem)), _maxLabelLength(other._maxLabelLength)
+{
+	_mem	= mem;
+	_pool	= StringPool::pool(mem);
+
+	_labels.reserve(other._labels.size());
+
+	for(const Label & label : other._labels)
+		_labels.push_back(Label(*_pool, label)); //The rows stay the same so the key index can be copied as is
 }
 
 Labels::~Labels()
@@ -47,12 +56,16 @@ Labels::~Labels()
 void Labels::clear()
 {
 	_labels.clear();
+	_keyIndex.clear();
+	_maxLabelLength = 0;
 }
 
 int Labels::add(int display)
 {
-	Label label(display);
+	Label label(*_pool, display);
 	_labels.push_back(label);
+	_addToKeyIndex(_labels.size() - 1);
+	_maxLabelLength = std::max(_maxLabelLength, label.textLength());
 
 	return display;
 }
@@ -64,8 +77,10 @@ int Labels::add(const std::string &display)
 
 int Labels::add(int key, const std::string &display, bool filterAllows, bool isText)
 {
-	Label label(display, key, filterAllows, isText);
+	Label label(*_pool, display, key, filterAllows, isText);
 	_labels.push_back(label);
+	_addToKeyIndex(_labels.size() - 1);
+	_maxLabelLength = std::max(_maxLabelLength, label.textLength());
 
 	return key;
 }
@@ -80,32 +95,28 @@ void Labels::removeValues(std::set<int> valuesToRemove)
 				return std::find(valuesToRemove.begin(), valuesToRemove.end(), label.value()) != valuesToRemove.end();
 			}),
 				_labels.end());
+
+	_rebuildKeyIndex();
+	_recomputeMaxLabelLength();
 }
 
 std::map<string, int> Labels::_resetLabelValues(int& maxValue)
 {
 	std::map<string, int> result;
-	map<int, string> &orgStringValues = getOrgStringValues();
-	map<int, string> newOrgStringValues;
 	int labelValue = 1;
 	for (Label& label : _labels)
 	{
-		int oldLabelValue = label.value();
-
-		if (orgStringValues.find(oldLabelValue) != orgStringValues.end())
-			newOrgStringValues[labelValue] = orgStringValues[oldLabelValue];
-
-		if (oldLabelValue != labelValue)
+		if (label.value() != labelValue)
 			label.setValue(labelValue);
 
 		result[label.text()] = labelValue;
 		labelValue++;
 	}
 
-	orgStringValues.clear();
-	orgStringValues.insert(newOrgStringValues.begin(), newOrgStringValues.end());
 	maxValue = labelValue - 1;
 
+	_rebuildKeyIndex();
+
 	return result;
 }
 
@@ -156,21 +167,11 @@ bool Labels::syncInts(const std::set<int> &values)
 
 std::map<std::string, int> Labels::syncStrings(const std::vector<std::string> &new_values, const std::map<std::string, std::string> &new_labels, bool *changedSomething)
 {
-	std::vector<std::pair<std::string,std::string> > valuesToAdd;
 	std::map<std::string, std::vector<unsigned int> > mapValuesToAdd;
 	unsigned int valuesToAddIndex = 0;
 
 	for (const std::string& newValue : new_values)
-	{
-		std::string shortValue	= newValue.length() > Label::MAX_LABEL_LENGTH ? newValue.substr(0, Label::MAX_LABEL_LENGTH) : newValue;
-		valuesToAdd.push_back(make_pair(newValue, shortValue));
-		auto elt = mapValuesToAdd.find(shortValue);
-		if (elt != mapValuesToAdd.end())
-			elt->second.push_back(valuesToAddIndex);
-		else
-			mapValuesToAdd[shortValue] = { valuesToAddIndex };
-		valuesToAddIndex++;
-	}
+		mapValuesToAdd[newValue].push_back(valuesToAddIndex++);
 	
 	std::set<int>				valuesToRemove;
 	std::map<std::string, int>	result;
@@ -188,7 +189,7 @@ std::map<std::string, int> Labels::syncStrings(const std::vector<std::string> &n
 		if (elt != mapValuesToAdd.end())
 		{
 			for (uint i : elt->second)
-				result[valuesToAdd[i].first] = labelValue;
+				result[new_values[i]] = labelValue;
 			mapValuesToAdd.erase(elt);
 		}
 		else
@@ -204,15 +205,15 @@ std::map<std::string, int> Labels::syncStrings(const std::vector<std::string> &n
 		result = _resetLabelValues(maxLabelKey);
 	}
 	
-	for (auto elt : valuesToAdd)
+	for (const std::string& newLabel : new_values)
 	{
-		const std::string& newLabel = elt.first;
-		const std::string& shortLabel = elt.second;
-		if (mapValuesToAdd.find(shortLabel) != mapValuesToAdd.end())
+		auto elt = mapValuesToAdd.find(newLabel);
+		if (elt != mapValuesToAdd.end())
 		{
 			maxLabelKey++;
-			add(maxLabelKey, shortLabel, true);
+			add(maxLabelKey, newLabel, true);
 			result[newLabel] = maxLabelKey;
+			mapValuesToAdd.erase(elt);
 		}
 	}
 
@@ -244,24 +245,31 @@ std::set<int> Labels::getIntValues()
 	return result;
 }
 
-map<int, string> &Labels::getOrgStringValues() const
+map<int, string> Labels::getOrgStringValues() const
 {
-	return Labels::_orgStringValues[_id];
+	map<int, string> orgStringValues;
+
+	for (const Label & label : _labels)
+		if (!label.hasIntValue() && label.originalValue() != label.text())
+			orgStringValues[label.value()] = label.originalValue();
+
+	return orgStringValues;
 }
 
 void Labels::setOrgStringValues(int key, std::string value)
 {
-	getOrgStringValues()[key] = value;
+	int row = getRowFromKey(key);
+
+	if (row >= 0)	_labels[row].setOriginalValue(*_pool, value);
+	else			Log::log() << "Cannot set original value '" << value << "' for unknown label key " << key << std::endl;
 }
 
 const Label &Labels::getLabelObjectFromKey(int index) const
-
 {
-	for (const Label &label: _labels)
-	{
-		if (label.value() == index)
-			return label;
-	}
+	int row = getRowFromKey(index);
+
+	if (row >= 0)
+		return _labels[row];
 
 	Log::log() << "Cannot find entry " << index << std::endl;
 	for(const Label &label: _labels)
@@ -272,6 +280,62 @@ const Label &Labels::getLabelObjectFromKey(int index) const
 	throw labelNotFound("Cannot find this entry");
 }
 
+int Labels::getRowFromKey(int key) const
+{
+	return _findInKeyIndex(key); //Every change of a key goes through Labels, which keeps the index up to date, so a miss means it isn't there
+}
+
+static size_t labelKeyHash(int key)
+{
+	return static_cast<unsigned int>(key) * 2654435761u; //Knuth's multiplicative hash, the keys are mostly small consecutive ints
+}
+
+void Labels::_rebuildKeyIndex()
+{
+	size_t slots = 16;
+	while (slots < 2 * _labels.size())
+		slots *= 2;
+
+	_keyIndex.assign(slots, 0);
+
+	for (size_t row = 0; row < _labels.size(); row++)
+		_addToKeyIndex(row);
+}
+
+void Labels::_addToKeyIndex(size_t row)
+{
+	//Keep the table at most half full so the probe sequences stay short
+	if (2 * _labels.size() > _keyIndex.size())
+		return _rebuildKeyIndex();
+
+	size_t	mask = _keyIndex.size() - 1,
+			slot = labelKeyHash(_labels[row].value()) & mask;
+
+	while (_keyIndex[slot] != 0)
+		slot = (slot + 1) & mask;
+
+	_keyIndex[slot] = row + 1;
+}
+
+int Labels::_findInKeyIndex(int key) const
+{
+	if (_keyIndex.empty())
+		return -1;
+
+	size_t	mask = _keyIndex.size() - 1,
+			slot = labelKeyHash(key) & mask;
+
+	for (int row = _keyIndex[slot]; row != 0; row = _keyIndex[slot])
+	{
+		if (size_t(row) <= _labels.size() && _labels[row - 1].value() == key)
+			return row - 1;
+
+		slot = (slot + 1) & mask;
+	}
+
+	return -1;
+}
+
 bool Labels::setLabelFromRow(int row, const string &display)
 {
 	if (row >= (int)_labels.size() || row < 0)
@@ -305,18 +369,21 @@ void Labels::log()
 
 void Labels::_setNewStringForLabel(Label &label, const string &display)
 {
-	int label_value = label.value();
-	string label_string = label.text();
+	//The original value was set when the label was made and stays, whatever the user renames it to
+	bool wasLongest = label.textLength() == _maxLabelLength;
 
-	if (!label.hasIntValue())
-	{
-		map<int, string> &orgStringValues = getOrgStringValues();
+	label.setLabel(*_pool, display);
 
-		if (orgStringValues.find(label_value) == orgStringValues.end())
-			orgStringValues[label_value] = label_string;
-	}
+	if (wasLongest)	_recomputeMaxLabelLength();
+	else			_maxLabelLength = std::max(_maxLabelLength, label.textLength());
+}
+
+void Labels::_recomputeMaxLabelLength()
+{
+	_maxLabelLength = 0;
 
-	label.setLabel(display);
+	for (const Label & label : _labels)
+		_maxLabelLength = std::max(_maxLabelLength, label.textLength());
 }
 
 string Labels::_getValueFromLabel(const Label &label) const
@@ -327,11 +394,7 @@ string Labels::_getValueFromLabel(const Label &label) const
 
 string Labels::_getOrgValueFromLabel(const Label &label) const
 {
-	map<int, string> &orgStringValues	= getOrgStringValues();
-	map<int, string>::const_iterator it = orgStringValues.find(label.value());
-
-	if (it == orgStringValues.end())	return label.text();
-	else								return it->second;
+	return label.hasIntValue() ? label.text() : label.originalValue();
 }
 
 string Labels::getValueFromKey(int key) const
@@ -382,6 +445,9 @@ void Labels::set(vector<Label> &labels)
 	{
 		_labels.push_back(label);
 	}
+
+	_rebuildKeyIndex();
+	_recomputeMaxLabelLength();
 }
 
 size_t Labels::size() const
@@ -393,14 +459,17 @@ Labels &Labels::operator=(const Labels &labels)
 {
 	if (&labels != this)
 	{
-		this->_mem = labels._mem;
-		this->_labels = labels._labels;
+		this->_mem		= labels._mem;
+		this->_pool		= labels._pool;
+		this->_labels	= labels._labels;
+		this->_keyIndex	= labels._keyIndex;
+		this->_maxLabelLength = labels._maxLabelLength;
 	}
 
 	return *this;
 }
 
-void Labels::setSharedMemory(boost::interprocess::managed_shared_memory *mem)
+void Labels::setSharedMemory(boost::interprocess::managed_shared_memory::segment_manager *mem)
 {
 	_mem = mem;
 }
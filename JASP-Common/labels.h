@@ -32,6 +32,9 @@
 typedef boost::interprocess::allocator<Label, boost::interprocess::managed_shared_memory::segment_manager> LabelAllocator;
 typedef boost::container::vector<Label, LabelAllocator> LabelVector;
 
+typedef boost::interprocess::allocator<int, boost::interprocess::managed_shared_memory::segment_manager> LabelKeyIndexAllocator;
+typedef boost::container::vector<int, LabelKeyIndexAllocator> LabelKeyIndex;
+
 #include <boost/iterator/iterator_facade.hpp>
 #include <boost/range/const_iterator.hpp>
 
@@ -46,7 +49,10 @@ struct labelNotFound : public std::runtime_error
 class Labels
 {
 public:
-			Labels(boost::interprocess::managed_shared_memory *mem);
+			Labels(boost::interprocess::managed_shared_memory::segment_manager *mem);
+			Labels(boost::interprocess::managed_shared_memory::segment_manager *mem, const Labels & other); ///< Copies other into mem, see SharedMemory::compactDataSet
+			Labels(const Labels & other)	= default;
+			Labels(Labels && other)			= default; ///< So moving a Column around in the ColumnVector doesn't copy its labels
 	virtual ~Labels();
 
 	void	clear();
@@ -62,28 +68,31 @@ public:
 
 	void	set(std::vector<Label> &labels);
 	size_t	size() const;
+	size_t	maxLabelLength() const { return _maxLabelLength; } ///< Length of the longest text of the labels, kept up to date as they change
 
 	Labels	& operator=(const Labels& labels);
+	Labels	& operator=(Labels && labels)	= default;
 	Label	& operator[](size_t index);
 
-	void setSharedMemory(boost::interprocess::managed_shared_memory *mem);
+	void setSharedMemory(boost::interprocess::managed_shared_memory::segment_manager *mem);
 	typedef LabelVector::const_iterator const_iterator;
 
 	const_iterator begin() const;
 	const_iterator end() const;
 
-	std::map<int, std::string> &getOrgStringValues() const;
+	std::map<int, std::string> getOrgStringValues() const; ///< The original values of the text labels that were renamed by the user
 	void setOrgStringValues(int key, std::string value);
 
 	// Get Value or Label from the key given by the AsInts struncture of Column
 	std::string getValueFromKey(int key) const;
 	const Label &getLabelObjectFromKey(int key) const;
+	int getRowFromKey(int key) const; ///< Returns -1 if there is no label with that key
 
 	// These 3 methods are used by the Variable Page to get/set the value & label of a Variable
 	// (confusing is that a Variable is a Label object). The row means here the row of the
 	// Variable in the table (as displayed to the user).
-	// getValueFromRow will maybe need the _orgStringValues if the value is a string and has been
-	// changed by the user: the original value is then stored in _orgStringValues
+	// getValueFromRow will maybe need the original value if the value is a string and has been
+	// changed by the user: the original value is then stored in the Label itself
 	std::string getLabelFromRow(int) const;
 	std::string getValueFromRow(int) const;
 	bool setLabelFromRow(int row, const std::string &display);
@@ -96,15 +105,19 @@ private:
 	std::string					_getOrgValueFromLabel(const Label &label) const;
 	std::map<std::string, int>	_resetLabelValues(int &maxValue);
 
-	boost::interprocess::managed_shared_memory * _mem = nullptr;
+	void						_rebuildKeyIndex();
+	void						_addToKeyIndex(size_t row);
+	int							_findInKeyIndex(int key) const;
+	void						_recomputeMaxLabelLength();
+
+	boost::interprocess::managed_shared_memory::segment_manager * _mem = nullptr;
+	boost::interprocess::offset_ptr<StringPool>	_pool;
 
 	LabelVector		_labels;
-	int				_id;
-	static int		_counter;
-	// Original string values: used only when value is a string and when the label has been changed
-	// This map is not in the shared memory (it's only used by the JASP-Desktop): this allows this map to grow
-	// without risking to fill up the shared memory.
-	static std::map<int, std::map<int, std::string> > _orgStringValues;
+	// Open addressing hashtable from the key of a label to its row in _labels, so that looking up the label of a value in a column doesn't need to go through all labels.
+	// Each slot holds row + 1, 0 means empty. It lives in shared memory because the Engines look up labels just as much.
+	LabelKeyIndex	_keyIndex;
+	size_t			_maxLabelLength = 0;
 };
 
 namespace boost
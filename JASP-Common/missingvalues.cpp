@@ -0,0 +1,107 @@
+#include "missingvalues.h"
+#include <climits>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+MissingValues::MissingValues(boost::interprocess::managed_shared_memory::segment_manager * mem)
+	: _validRows(mem), _tokens(mem)
+{
+	_pool = StringPool::pool(mem);
+}
+
+MissingValues::MissingValues(boost::interprocess::managed_shared_memory::segment_manager * mem, const MissingValues & other)
+	: _validRows(mem, other._validRows), _tokens(mem)
+{
+	_pool = StringPool::pool(mem);
+
+	_tokens.reserve(other._tokens.size());
+
+	for(const Token & token : other._tokens)
+		_tokens.push_back(Token{ token.row, _pool->intern(token.text.str()) });
+}
+
+void MissingValues::setTokens(const std::map<size_t, std::string> & tokens)
+{
+	_tokens.clear();
+	_tokens.reserve(tokens.size());
+
+	for(const auto & rowToken : tokens) //std::map is sorted so the rows end up in order
+		_tokens.push_back(Token{ rowToken.first, _pool->intern(rowToken.second) });
+}
+
+std::map<size_t, std::string> MissingValues::tokensAsMap() const
+{
+	std::map<size_t, std::string> tokens;
+
+	for(const Token & token : _tokens)
+		tokens.insert(tokens.end(), std::make_pair(token.row, token.text.str()));
+
+	return tokens;
+}
+
+void MissingValues::dropTokensFrom(size_t row)
+{
+	while(!_tokens.empty() && _tokens.back().row >= row)
+		_tokens.pop_back();
+}
+
+void MissingValues::insertRows(size_t row, size_t count)
+{
+	_validRows.insertRows(row, count, false);
+
+	for(Token & token : _tokens)
+		if(token.row >= row)
+			token.row += count;
+}
+
+void MissingValues::eraseRows(size_t row, size_t count)
+{
+	_validRows.eraseRows(row, count);
+
+	//The tokens are sorted by row, so dropping those in the range keeps them sorted
+	size_t kept = 0;
+
+	for(size_t i = 0; i < _tokens.size(); i++)
+	{
+		Token token = _tokens[i];
+
+		if(token.row >= row && token.row < row + count)
+			continue;
+
+		if(token.row >= row + count)
+			token.row -= count;
+
+		_tokens[kept++] = token;
+	}
+
+	_tokens.resize(kept);
+}
+
+void MissingValues::refresh(const ColumnBuffer & values)
+{
+	_validRows.reset(values.size());
+
+	if(values.layout() == ColumnBuffer::Layout::ints)
+	{
+		std::vector<int> batch(std::min(values.size(), ColumnEncoding::DECODE_BATCH));
+
+		for(size_t from = 0; from < values.size(); from += batch.size())
+		{
+			size_t count = std::min(batch.size(), values.size() - from);
+			values.readInts(from, count, batch.data());
+
+			for(size_t row = 0; row < count; row++)
+				if(batch[row] == INT_MIN)
+					_validRows.set(from + row, false);
+		}
+	}
+	else if(values.doubles())
+	{
+		const double * doubles = values.doubles();
+
+		for(size_t row = 0; row < values.size(); row++)
+			if(std::isnan(doubles[row]))
+				_validRows.set(row, false);
+	}
+}
@@ -0,0 +1,53 @@
+#ifndef MISSINGVALUES_H
+#define MISSINGVALUES_H
+
+#include <map>
+#include <string>
+#include "columnbuffer.h"
+#include "filterbitmap.h"
+#include "stringpool.h"
+
+/*
+ * MissingValues keeps track of the rows of a Column that have no value, and of what was originally in those that were read from text.
+ * The values themselves keep INT_MIN and NaN, because those are what R gets as NA and rbridge copies straight out of the ColumnBuffer.
+ * Next to them there is a bitmap of the rows that do have a value, so counting missing values is a popcount, and a table sorted by row
+ * with the original tokens ("NA", ".", "999") of the rows that were made empty, their texts deduplicated in the StringPool.
+ * When the user changes what counts as empty only these tokens need to be looked at to find the rows that get a value again.
+ */
+class MissingValues
+{
+public:
+	typedef ColumnBuffer::SegmentManager SegmentManager;
+
+	struct Token
+	{
+		size_t				row;
+		StringPool::Text	text;
+	};
+
+	typedef boost::interprocess::allocator<Token, SegmentManager>	TokenAllocator;
+	typedef boost::container::vector<Token, TokenAllocator>			Tokens;
+
+	MissingValues(boost::interprocess::managed_shared_memory::segment_manager * mem);
+	MissingValues(boost::interprocess::managed_shared_memory::segment_manager * mem, const MissingValues & other); ///< Copies other into mem, tokens and all
+
+	void						setTokens(const std::map<size_t, std::string> & tokens);
+	std::map<size_t, std::string>	tokensAsMap()				const;
+	const Tokens			&	tokens()						const	{ return _tokens;			}
+	void						clearTokens()							{ _tokens.clear();			}
+	void						dropTokensFrom(size_t row);				///< For when rows are truncated
+	void						insertRows(size_t row, size_t count);	///< The new rows are missing, but without a token
+	void						eraseRows(size_t row, size_t count);
+
+	void						refresh(const ColumnBuffer & values);	///< Rebuilds the bitmap from the INT_MIN/NaN in values
+	void						setValid(size_t row, bool valid)		{ _validRows.set(row, valid); }
+	const FilterBitmap		&	validRows()						const	{ return _validRows;		} ///< The rows with a value "pass"
+	size_t						missingCount()					const	{ return _validRows.size() - _validRows.passingCount(); }
+
+private:
+	FilterBitmap								_validRows;
+	Tokens										_tokens;
+	boost::interprocess::offset_ptr<StringPool>	_pool;
+};
+
+#endif // MISSINGVALUES_H
@@ -19,8 +19,13 @@
 
 #include "processinfo.h"
 #include "tempfiles.h"
+#include "stringpool.h"
+#include "dirs.h"
 
+#include <memory>
 #include <sstream>
+#include <type_traits>
+#include <boost/interprocess/managed_heap_memory.hpp>
 
 #include "log.h"
 
@@ -28,24 +33,33 @@ using namespace std;
 using namespace boost;
 
 interprocess::managed_shared_memory *SharedMemory::_memory = NULL;
+interprocess::managed_mapped_file *SharedMemory::_mappedFile = NULL;
+bool SharedMemory::_useMappedFile = false;
 string SharedMemory::_memoryName;
 
+///Where compactDataSet keeps the DataSet while the segment is made anew, its segment_manager has to be the same type for that
+typedef interprocess::basic_managed_heap_memory<char, interprocess::rbtree_best_fit<interprocess::mutex_family>, interprocess::iset_index> StagingMemory;
+static_assert(std::is_same<StagingMemory::segment_manager, SharedMemory::SegmentManager>::value, "A DataSet can only be copied between segments with the same segment_manager");
+
 DataSet *SharedMemory::createDataSet()
 {
-	if (_memory == NULL)
+	if (_memory == NULL && _mappedFile == NULL)
 	{
 		stringstream ss;
 		ss << "JASP-DATA-";
 		ss << ProcessInfo::currentPID();
 		_memoryName = ss.str();
 
-		TempFiles::addShmemFileName(_memoryName);
-
 		interprocess::shared_memory_object::remove(_memoryName.c_str());
-		_memory = new interprocess::managed_shared_memory(interprocess::create_only, _memoryName.c_str(), 6 * 1024 * 1024);
+		interprocess::file_mapping::remove(mappedFilePath().c_str());
+
+		std::string shmemFileName = _useMappedFile ? _memoryName + ".mapped" : _memoryName;
+		TempFiles::addShmemFileName(shmemFileName); //So the heartbeat keeps it and deleteOrphans removes it if we crash
+
+		createSegment(INITIAL_SIZE);
 	}
 
-	DataSet * data = _memory->construct<DataSet>(interprocess::unique_instance)(_memory);
+	DataSet * data = segment()->construct<DataSet>(interprocess::unique_instance)(segment());
 	return data;
 }
 
@@ -54,16 +68,25 @@ DataSet *SharedMemory::retrieveDataSet(unsigned long parentPID)
 	DataSet * data = nullptr;
 	try
 	{
-		if (_memory == nullptr)
+		if (_memory == nullptr && _mappedFile == nullptr)
 		{
 			if(parentPID == 0)
 				parentPID = ProcessInfo::parentPID();
 
 			_memoryName = "JASP-DATA-" + std::to_string(parentPID);
-			_memory		= new interprocess::managed_shared_memory(interprocess::open_only, _memoryName.c_str());
+
+			try
+			{
+				_memory		= new interprocess::managed_shared_memory(interprocess::open_only, _memoryName.c_str());
+			}
+			catch (const interprocess::interprocess_exception&)
+			{
+				//Desktop might have put it in a file instead
+				_mappedFile	= new interprocess::managed_mapped_file(interprocess::open_only, mappedFilePath().c_str());
+			}
 		}
 
-		data = _memory->find<DataSet>(interprocess::unique_instance).first;
+		data = segment()->find<DataSet>(interprocess::unique_instance).first;
 	}
 	catch (const interprocess::interprocess_exception& e)
 	{
@@ -76,24 +99,168 @@ DataSet *SharedMemory::retrieveDataSet(unsigned long parentPID)
 
 DataSet *SharedMemory::enlargeDataSet(DataSet *)
 {
-	size_t extraSize = _memory->get_size();
+	size_t extraSize = segment()->get_size();
 
 	Log::log() << "SharedMemory::enlargeDataSet to " << extraSize << std::endl;
 
-	delete _memory;
+	return growDataSet(extraSize);
+}
+
+DataSet *SharedMemory::reserveDataSet(DataSet *dataSet, size_t bytesNeeded)
+{
+	size_t freeBytes = segment()->get_free_memory();
+
+	if(freeBytes >= bytesNeeded)
+		return dataSet;
+
+	size_t extraSize = bytesNeeded - freeBytes;
 
-	interprocess::managed_shared_memory::grow(_memoryName.c_str(), extraSize);
-	_memory = new interprocess::managed_shared_memory(interprocess::open_only, _memoryName.c_str());
+	Log::log() << "SharedMemory::reserveDataSet grows segment of " << segment()->get_size() << " bytes by " << extraSize << " to have " << bytesNeeded << " bytes free" << std::endl;
+
+	return growDataSet(extraSize);
+}
+
+DataSet *SharedMemory::growDataSet(size_t extraSize)
+{
+	growSegment(extraSize);
 
 	DataSet *dataSet = retrieveDataSet();
-	dataSet->setSharedMemory(_memory);
+	dataSet->setSharedMemory(segment());
 
 	return dataSet;
 }
 
+DataSet *SharedMemory::compactDataSet(DataSet *dataSet)
+{
+	size_t	sizeBefore	= segment()->get_size(),
+			usedBefore	= sizeBefore - segment()->get_free_memory();
+
+	//The Engines find the segment by its name, so the DataSet waits on the heap while a new segment is made under that same name
+	std::unique_ptr<StagingMemory>	staging;
+	DataSet						*	staged	= nullptr;
+
+	for(size_t stagingSize = usedBefore + INITIAL_SIZE; !staged; stagingSize *= 2)
+	{
+		staging.reset(new StagingMemory(stagingSize));
+
+		try								{ staged = staging->construct<DataSet>(interprocess::unique_instance)(staging->get_segment_manager(), *dataSet); }
+		catch (interprocess::bad_alloc &)	{} //Copying does not fragment, so only the alignment of the columns and the chunks of the StringPool can make it larger than usedBefore
+	}
+
+	size_t	compactedBytes	= staging->get_size() - staging->get_free_memory(),
+			compactedSize	= compactedBytes + compactedBytes / 4; //Some room to spare, otherwise the next change has to grow it right away
+
+	//The old segment only gives up its name here. It stays mapped, and dataSet with it, until the new one holds the copy
+	interprocess::managed_shared_memory	*	oldMemory		= _memory;
+	interprocess::managed_mapped_file	*	oldMappedFile	= _mappedFile;
+
+	_memory		= nullptr;
+	_mappedFile	= nullptr;
+	removeSegmentName();
+
+	DataSet * compacted = nullptr;
+
+	try
+	{
+		createSegment(compactedSize > INITIAL_SIZE ? compactedSize : INITIAL_SIZE);
+
+		while(!compacted)
+		{
+			try								{ compacted = segment()->construct<DataSet>(interprocess::unique_instance)(segment(), *staged); }
+			catch (interprocess::bad_alloc &)	{ growSegment(segment()->get_size()); }
+		}
+	}
+	catch (...)
+	{
+		//Then the Desktop keeps the old one and dataSet stays valid, only the Engines can't find it by its name anymore until it is loaded again
+		if(_memory || _mappedFile)
+		{
+			unloadDataSet();
+			removeSegmentName();
+		}
+
+		_memory		= oldMemory;
+		_mappedFile	= oldMappedFile;
+
+		throw;
+	}
+
+	delete oldMemory;
+	delete oldMappedFile;
+
+	Log::log() << "SharedMemory::compactDataSet went from " << sizeBefore << " bytes (" << usedBefore << " in use) to " << segment()->get_size() << " bytes (" << (segment()->get_size() - segment()->get_free_memory()) << " in use)" << std::endl;
+
+	return compacted;
+}
+
+bool SharedMemory::compactionWorthIt(const DataSet *dataSet)
+{
+	if(_memory == nullptr && _mappedFile == nullptr)
+		return false;
+
+	size_t	size	= segment()->get_size(),
+			wasted	= segment()->get_free_memory() + (dataSet ? dataSet->unusedColumnBytes() : 0);
+
+	return size >= MIN_COMPACT_SIZE && wasted > size / 2;
+}
+
+void SharedMemory::createSegment(size_t size)
+{
+	if(_useMappedFile)	_mappedFile	= new interprocess::managed_mapped_file(	interprocess::create_only, mappedFilePath().c_str(),	size);
+	else				_memory		= new interprocess::managed_shared_memory(	interprocess::create_only, _memoryName.c_str(),		size);
+}
+
+void SharedMemory::removeSegmentName()
+{
+	//Whoever still has it mapped keeps it until they unmap it, just like an unlinked file
+	interprocess::shared_memory_object::remove(_memoryName.c_str());
+	interprocess::file_mapping::remove(mappedFilePath().c_str());
+}
+
+void SharedMemory::growSegment(size_t extraSize)
+{
+	if(_mappedFile != NULL)
+	{
+		delete _mappedFile;
+
+		interprocess::managed_mapped_file::grow(mappedFilePath().c_str(), extraSize);
+		_mappedFile = new interprocess::managed_mapped_file(interprocess::open_only, mappedFilePath().c_str());
+	}
+	else
+	{
+		delete _memory;
+
+		interprocess::managed_shared_memory::grow(_memoryName.c_str(), extraSize);
+		_memory = new interprocess::managed_shared_memory(interprocess::open_only, _memoryName.c_str());
+	}
+}
+
+SharedMemory::SegmentManager *SharedMemory::segment()
+{
+	return _mappedFile != NULL ? _mappedFile->get_segment_manager() : _memory->get_segment_manager();
+}
+
+std::string SharedMemory::mappedFilePath()
+{
+	return Dirs::tempDir() + "/" + _memoryName + ".mapped";
+}
+
+void SharedMemory::logMemoryUsage(const DataSet *dataSet, const std::string & when)
+{
+	if(_memory == nullptr && _mappedFile == nullptr)
+		return;
+
+	size_t	size		= segment()->get_size(),
+			freeBytes	= segment()->get_free_memory(),
+			unused		= dataSet ? dataSet->unusedColumnBytes() : 0;
+
+	Log::log() << "SharedMemory " << when << (_mappedFile ? " (mapped file)" : "") << ": segment is " << size << " bytes, " << (size - freeBytes) << " in use of which " << unused << " reserved by columns but unused, " << freeBytes << " free (" << (size > 0 ? (100 * (freeBytes + unused)) / size : 0) << "% wasted)" << std::endl;
+}
+
 void SharedMemory::deleteDataSet(DataSet *dataSet)
 {
-	_memory->destroy_ptr(dataSet);
+	segment()->destroy_ptr(dataSet);
+	StringPool::destroyPool(segment()); //All the labels that used it are gone now
 }
 
 void SharedMemory::unloadDataSet()
@@ -101,5 +268,9 @@ void SharedMemory::unloadDataSet()
 	if(_memory != NULL)
 		delete _memory;
 
-	_memory = NULL;
+	if(_mappedFile != NULL)
+		delete _mappedFile;
+
+	_memory		= NULL;
+	_mappedFile	= NULL;
 }
@@ -19,6 +19,7 @@
 #define SHAREDMEMORY_H
 
 #include <boost/interprocess/managed_shared_memory.hpp>
+#include <boost/interprocess/managed_mapped_file.hpp>
 #include "dataset.h"
 
 /*
@@ -32,21 +33,49 @@
  * in shared memory as well.
  * Good examples of creating and populating a DataSet can be found
  * in the importers
+ *
+ * Instead of shared memory the segment can also be a file in the
+ * temp directory that everyone maps (see setUseMappedFile()), that way
+ * the OS can page columns in and out and a data set can be larger than RAM.
+ * The layout is the same, both have the same segment_manager.
+ *
+ * The segment can only grow while columns are changed, and what gets freed leaves holes in it. compactDataSet() copies the DataSet
+ * into a fresh segment of the right size, which gives that memory back. The Engines must not have it mapped meanwhile.
+ * The old segment is only unmapped once the new one holds the copy, so if that fails the DataSet stays where it was.
  */
 
 class SharedMemory
 {
 public:
+	typedef boost::interprocess::managed_shared_memory::segment_manager SegmentManager;
+
+	static void		setUseMappedFile(bool useMappedFile) { _useMappedFile = useMappedFile; } ///< Only has an effect before the first createDataSet()
+	static bool		usesMappedFile() { return _mappedFile != nullptr; }
 
 	static DataSet	*createDataSet();
 	static DataSet	*retrieveDataSet(unsigned long parentPID = 0);
 	static DataSet	*enlargeDataSet(DataSet *dataSet);
+	static DataSet	*reserveDataSet(DataSet *dataSet, size_t bytesNeeded); ///< Grows the segment once so that at least bytesNeeded are free, see DataSetSizePlanner
+	static DataSet	*compactDataSet(DataSet *dataSet);
+	static bool		compactionWorthIt(const DataSet *dataSet); ///< Is enough of the segment free or unused to bother with compactDataSet?
+	static void		logMemoryUsage(const DataSet *dataSet, const std::string & when);
 	static void		deleteDataSet(DataSet *dataSet);
 	static void		unloadDataSet();
 private:
+	static DataSet			*growDataSet(size_t extraSize);
+	static void				createSegment(size_t size);
+	static void				removeSegmentName();	///< Without unmapping it, so a new segment can get the name
+	static void				growSegment(size_t extraSize);
+	static SegmentManager	*segment();
+	static std::string		mappedFilePath();
 
 	static std::string _memoryName;
 	static boost::interprocess::managed_shared_memory *_memory;
+	static boost::interprocess::managed_mapped_file *_mappedFile;
+	static bool _useMappedFile;
+
+	static const size_t	INITIAL_SIZE		= 6 * 1024 * 1024,
+						MIN_COMPACT_SIZE	= 64 * 1024 * 1024;	///< Smaller segments are not worth the copy
 
 };
 
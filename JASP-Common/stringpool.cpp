@@ -0,0 +1,142 @@
+#include "stringpool.h"
+#include <cstring>
+#include <algorithm>
+
+typedef boost::interprocess::offset_ptr<char> ChunkLink;
+
+StringPool::StringPool(SegmentManager * segment)
+	: _segment(segment), _slots(segment)
+{}
+
+StringPool::~StringPool()
+{
+	while(_chunk)
+	{
+		char * previous = reinterpret_cast<ChunkLink*>(_chunk.get())->get();
+		reinterpret_cast<ChunkLink*>(_chunk.get())->~ChunkLink();
+		_segment->deallocate(_chunk.get());
+		_chunk = previous;
+	}
+}
+
+StringPool * StringPool::pool(boost::interprocess::managed_shared_memory::segment_manager * mem)
+{
+	return mem->find_or_construct<StringPool>(boost::interprocess::unique_instance)(mem);
+}
+
+void StringPool::destroyPool(boost::interprocess::managed_shared_memory::segment_manager * mem)
+{
+	mem->destroy<StringPool>(boost::interprocess::unique_instance);
+}
+
+uint32_t StringPool::_hash(const char * chars, size_t length)
+{
+	uint32_t hash = 2166136261u; //FNV-1a
+
+	for(size_t i = 0; i < length; i++)
+		hash = (hash ^ static_cast<unsigned char>(chars[i])) * 16777619u;
+
+	return hash;
+}
+
+StringPool::Text StringPool::intern(const std::string & str)
+{
+	Text text;
+
+	if(str.empty())
+		return text;
+
+	if(2 * (_count + 1) > _slots.size())
+		_growSlots();
+
+	uint32_t	hash = _hash(str.data(), str.size());
+	size_t		mask = _slots.size() - 1,
+				slot = hash & mask;
+
+	for(; _slots[slot].chars; slot = (slot + 1) & mask)
+		if(_slots[slot].hash == hash && _slots[slot].length == str.size() && std::memcmp(_slots[slot].chars.get(), str.data(), str.size()) == 0)
+		{
+			text.chars	= _slots[slot].chars;
+			text.length	= _slots[slot].length;
+			return text;
+		}
+
+	const char * chars = _store(str.data(), str.size());
+
+	_slots[slot].chars	= chars;
+	_slots[slot].length	= str.size();
+	_slots[slot].hash	= hash;
+	_count++;
+
+	text.chars	= chars;
+	text.length	= str.size();
+
+	return text;
+}
+
+const char * StringPool::_store(const char * chars, size_t length)
+{
+	char * stored;
+
+	if(length > CHUNK_SIZE / 4)
+	{
+		//Long strings get a chunk of their own, linked in behind the current one so that its free space isn't lost
+		char * chunk = static_cast<char*>(_segment->allocate(sizeof(ChunkLink) + length));
+
+		if(_chunk)
+		{
+			ChunkLink & currentLink = *reinterpret_cast<ChunkLink*>(_chunk.get());
+			new (chunk) ChunkLink(currentLink.get());
+			currentLink = chunk;
+		}
+		else
+		{
+			new (chunk) ChunkLink(nullptr);
+			_chunk		= chunk;
+			_chunkSize	= _chunkUsed = sizeof(ChunkLink) + length;
+		}
+
+		stored = chunk + sizeof(ChunkLink);
+	}
+	else
+	{
+		if(!_chunk || _chunkUsed + length > _chunkSize)
+		{
+			char * chunk = static_cast<char*>(_segment->allocate(CHUNK_SIZE));
+
+			new (chunk) ChunkLink(_chunk.get());
+
+			_chunk		= chunk;
+			_chunkSize	= CHUNK_SIZE;
+			_chunkUsed	= sizeof(ChunkLink);
+		}
+
+		stored		= _chunk.get() + _chunkUsed;
+		_chunkUsed	+= length;
+	}
+
+	std::memcpy(stored, chars, length);
+	_bytes += length;
+
+	return stored;
+}
+
+void StringPool::_growSlots()
+{
+	Slots slots(std::max<size_t>(64, 2 * _slots.size()), Slot(), _segment.get());
+
+	size_t mask = slots.size() - 1;
+
+	for(const Slot & old : _slots)
+		if(old.chars)
+		{
+			size_t slot = old.hash & mask;
+
+			while(slots[slot].chars)
+				slot = (slot + 1) & mask;
+
+			slots[slot] = old;
+		}
+
+	_slots.swap(slots);
+}
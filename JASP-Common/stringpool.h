@@ -0,0 +1,71 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <string>
+#include <cstdint>
+#include <boost/interprocess/managed_shared_memory.hpp>
+#include <boost/interprocess/offset_ptr.hpp>
+#include <boost/container/vector.hpp>
+
+/*
+ * StringPool holds the texts of all Labels (and the original tokens of empty values) in the shared memory segment, each distinct string only once.
+ * Strings are appended to chunks that are never moved or freed while the pool exists, so a Label can simply keep an offset_ptr and a length to its text.
+ * Because of this a label costs as much as its text instead of a fixed size buffer, and its text can be as long as it wants.
+ * The pool only grows, texts that are no longer used by any Label stay until the pool is rebuilt.
+ * There is one per segment, get it through StringPool::pool(mem).
+ */
+class StringPool
+{
+public:
+	typedef boost::interprocess::managed_shared_memory::segment_manager SegmentManager;
+
+	///A string in the pool, it is not null-terminated so always use length
+	struct Text
+	{
+		boost::interprocess::offset_ptr<const char>	chars;
+		uint32_t									length = 0;
+
+		std::string str()	const { return length == 0 ? std::string() : std::string(chars.get(), length); }
+	};
+
+	StringPool(SegmentManager * segment);
+	~StringPool();
+
+	static StringPool	*	pool(boost::interprocess::managed_shared_memory::segment_manager * mem);
+	static void				destroyPool(boost::interprocess::managed_shared_memory::segment_manager * mem);
+
+	Text			intern(const std::string & str);	///< Returns the pooled copy of str, adding it if it isn't there yet. Throws bad_alloc like everything else in the segment.
+
+	size_t			stringCount()	const { return _count; }
+	size_t			bytesUsed()		const { return _bytes; }
+
+private:
+	StringPool(const StringPool &) = delete;
+	StringPool & operator=(const StringPool &) = delete;
+
+	struct Slot
+	{
+		boost::interprocess::offset_ptr<const char>	chars;
+		uint32_t									length	= 0,
+													hash	= 0;
+	};
+
+	typedef boost::interprocess::allocator<Slot, SegmentManager>	SlotAllocator;
+	typedef boost::container::vector<Slot, SlotAllocator>			Slots;
+
+	static uint32_t	_hash(const char * chars, size_t length);
+	const char	*	_store(const char * chars, size_t length);
+	void			_growSlots();
+
+	static const size_t CHUNK_SIZE = 64 * 1024;
+
+	boost::interprocess::offset_ptr<SegmentManager>	_segment;
+	boost::interprocess::offset_ptr<char>			_chunk;			///< Current chunk, starts with an offset_ptr to the previous chunk so they can all be freed
+	size_t											_chunkUsed	= 0,
+													_chunkSize	= 0,
+													_count		= 0,
+													_bytes		= 0;
+	Slots											_slots;			///< Open addressing hashtable over all strings, for deduplication
+};
+
+#endif // STRINGPOOL_H
@@ -24,6 +24,7 @@
 
 #include <QString>
 #include <QStringList>
+#include <QHash>
 
 class Term
 {
@@ -69,4 +70,7 @@ private:
 
 };
 
+///So Terms can be put in a QSet or QHash, which is how Terms deals with the thousands of them that wide data has
+inline uint qHash(const Term & term, uint seed = 0) { return qHashRange(term.components().begin(), term.components().end(), seed); }
+
 #endif // TERM_H
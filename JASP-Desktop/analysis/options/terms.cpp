@@ -23,6 +23,9 @@
 
 #include <QDataStream>
 #include <QIODevice>
+#include <QHash>
+#include <QSet>
+#include <algorithm>
 #include "utilities/qutils.h"
 using namespace std;
 
@@ -63,58 +66,102 @@ Terms::Terms(Terms *parent)
 
 void Terms::set(const std::vector<Term> &terms)
 {
-	_terms.clear();
-
-	for(const Term &term : terms)
-		add(term);
+	_setAll(terms);
 }
 
 void Terms::set(const std::vector<string> &terms)
 {
-	_terms.clear();
-
-	for(const Term &term : terms)
-		add(term);
+	_setAll(std::vector<Term>(terms.begin(), terms.end()));
 }
 
 void Terms::set(const std::vector<std::vector<string> > &terms)
 {
-	_terms.clear();
-
-	for(const Term &term : terms)
-		add(term);
+	_setAll(std::vector<Term>(terms.begin(), terms.end()));
 }
 
 void Terms::set(const QList<Term> &terms)
 {
-	_terms.clear();
-
-	for(const Term &term : terms)
-		add(term);
+	_setAll(std::vector<Term>(terms.begin(), terms.end()));
 }
 
 void Terms::set(const Terms &terms)
 {
-	_terms.clear();
-
-	for(const Term &term : terms)
-		add(term);
+	_setAll(std::vector<Term>(terms.begin(), terms.end()));
 }
 
 void Terms::set(const QList<QList<QString> > &terms)
 {
-	_terms.clear();
+	std::vector<Term> all;
+	all.reserve(size_t(terms.size()));
 
 	for(const QList<QString> &term : terms)
-		add(Term(term));
+		all.push_back(Term(term));
+
+	_setAll(all);
 }
 
 void Terms::set(const QList<QString> &terms)
 {
-	_terms.clear();
+	std::vector<Term> all;
+	all.reserve(size_t(terms.size()));
 
 	for(const QString &term : terms)
-		add(Term(term));
+		all.push_back(Term(term));
+
+	_setAll(all);
+}
+
+void Terms::_setAll(const std::vector<Term> &terms)
+{
+	//This ends up just like adding them one by one, but add() compares each term with all that are there already
+	//and that takes ages for the tens of thousands of columns of wide data. A hash and a sort do it in one go.
+	_terms.clear();
+	_terms.reserve(terms.size());
+
+	if (_parent == nullptr)
+	{
+		QSet<Term> seen;
+		seen.reserve(int(terms.size()));
+
+		for (const Term &term : terms)
+			if (!seen.contains(term))
+			{
+				seen.insert(term);
+				_terms.push_back(term);
+			}
+
+		return;
+	}
+
+	//Sorted like termCompare() does, by size and then by the rank of every component. Of the terms that compare equal add() keeps the first, so does a stable sort.
+	QHash<QString, int>	ranks;
+	int					rank = 0;
+
+	for (const Term &parentTerm : _parent->terms())
+	{
+		if (!ranks.contains(parentTerm.asQString()))
+			ranks.insert(parentTerm.asQString(), rank);
+		rank++;
+	}
+
+	std::vector<std::vector<int>>	keys(terms.size());
+	std::vector<size_t>				order(terms.size());
+
+	for (size_t i = 0; i < terms.size(); i++)
+	{
+		keys[i].push_back(int(terms[i].size()));
+
+		for (const QString &component : terms[i].components())
+			keys[i].push_back(ranks.value(component, rank)); //Not in the parent ranks after all that are
+
+		order[i] = i;
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+	for (size_t i = 0; i < order.size(); i++)
+		if (i == 0 || keys[order[i]] != keys[order[i - 1]])
+			_terms.push_back(terms[order[i]]);
 }
 
 void Terms::setSortParent(const Terms &parent)
@@ -475,12 +522,22 @@ bool Terms::componentLessThan(const QString &c1, const QString &c2) const
 
 void Terms::remove(const Terms &terms)
 {
+	//Every term in terms takes away the first one of it, counting them does that in one pass instead of a search and an erase per term
+	QHash<Term, int> toRemove;
+
 	for(const Term &term : terms)
+		toRemove[term]++;
+
+	_terms.erase(std::remove_if(_terms.begin(), _terms.end(), [&](const Term &term)
 	{
-		vector<Term>::iterator itr = find(_terms.begin(), _terms.end(), term);
-		if (itr != _terms.end())
-			_terms.erase(itr);
-	}
+		auto found = toRemove.find(term);
+
+		if (found == toRemove.end() || *found == 0)
+			return false;
+
+		(*found)--;
+		return true;
+	}), _terms.end());
 }
 
 void Terms::remove(size_t pos, size_t n)
@@ -584,7 +641,11 @@ bool Terms::discardWhatDoesContainTheseTerms(const Terms &terms)
 
 bool Terms::discardWhatIsntTheseTerms(const Terms &terms, Terms *discarded)
 {
-	bool changed = false;
+	bool		changed = false;
+	QSet<Term>	keep;
+
+	for (const Term &term : terms)
+		keep.insert(term);
 
 	_terms.erase(
 		std::remove_if(
@@ -592,7 +653,7 @@ bool Terms::discardWhatIsntTheseTerms(const Terms &terms, Terms *discarded)
 			_terms.end(),
 			[&](Term& term)
 			{
-				if (!term.asString().empty() && !terms.contains(term))
+				if (!term.asString().empty() && !keep.contains(term))
 				{
 					if (discarded != nullptr)
 						discarded->add(term);
@@ -105,6 +105,8 @@ public:
 
 private:
 
+	void	_setAll(const std::vector<Term> &terms);
+
 	int		rankOf(const QString &component)						const;
 	int		termCompare(const Term& t1, const Term& t2)				const;
 	bool	termLessThan(const Term &t1, const Term &t2)			const;
@@ -24,7 +24,12 @@ QVariant ColumnsModel::data(const QModelIndex &index, int role) const
 		columnType	colType = _tableModel->getColumnType(index.row());
 		QString		usedIn	= colType == columnType::scale ? tr("which can be used in numerical comparisons") : colType == columnType::ordinal ? tr("which can only be used in (in)equivalence, greater and lesser than comparisons") : tr("which can only be used in (in)equivalence comparisons");
 
-		return tr("The '") + _tableModel->columnTitle(index.row()).toString() + tr("'-column ") + usedIn;
+		ColumnDescriptives::Summary	summary	= _tableModel->getColumnSummary(index.row());
+		QString						values	= colType == columnType::scale
+				? tr("%1 values and %2 missing, with a mean of %3 and ranging from %4 to %5").arg(summary.count).arg(summary.missing).arg(summary.mean, 0, 'g', 4).arg(summary.min, 0, 'g', 4).arg(summary.max, 0, 'g', 4)
+				: tr("%1 values and %2 missing, in %3 different levels").arg(summary.count).arg(summary.missing).arg(summary.frequencies.size());
+
+		return tr("The '") + _tableModel->columnTitle(index.row()).toString() + tr("'-column ") + usedIn + "\n" + values;
 	}
 	}
 
@@ -14,6 +14,9 @@ ComputedColumnsModel::ComputedColumnsModel()
 	_singleton = this;
 
 	connect(DataSetPackage::pkg(),	&DataSetPackage::dataSetChanged,				this,					&ComputedColumnsModel::datasetLoadedChanged					);
+	connect(DataSetPackage::pkg(),	&DataSetPackage::dataSetChanged,				this,					&ComputedColumnsModel::dataSetLoaded						);
+	connect(DataSetPackage::pkg(),	&DataSetPackage::labelChanged,					this,					&ComputedColumnsModel::labelsChanged						);
+	connect(DataSetPackage::pkg(),	&DataSetPackage::labelsReordered,				this,					&ComputedColumnsModel::labelsChanged						);
 
 	connect(this,					&ComputedColumnsModel::datasetLoadedChanged,	this,					&ComputedColumnsModel::computeColumnJsonChanged				);
 	connect(this,					&ComputedColumnsModel::datasetLoadedChanged,	this,					&ComputedColumnsModel::computeColumnRCodeChanged			);
@@ -215,7 +218,13 @@ void ComputedColumnsModel::computeColumnSucceeded(QString columnNameQ, QString w
 		emit computeColumnErrorChanged();
 
 	if(dataChanged)
-			emit refreshColumn(tq(columnName));
+	{
+		//A computed column that is just a copy of one it uses might as well share its values
+		if(DataSetPackage::pkg()->isColumnComputed(columnName))
+			DataSetPackage::pkg()->shareIdenticalColumnValues(columnName, (*computedColumns())[columnName].dependsOnColumns(false));
+
+		emit refreshColumn(tq(columnName));
+	}
 
 	validate(QString::fromStdString(columnName));
 
@@ -279,6 +288,28 @@ void ComputedColumnsModel::checkForDependentColumnsToBeSent(std::string columnNa
 	checkForDependentAnalyses(columnName);
 }
 
+///A load or sync is taken care of by datasetChanged, this is for the labels edited in between. The analyses using those columns get refreshed by DataSetPackage::refreshAnalysesWithColumn already.
+void ComputedColumnsModel::labelsChanged()
+{
+	std::vector<std::string> changedColumns = DataSetPackage::pkg()->columnNamesChangedSince(_labelsSeen, DataSetChanges::Kind::labels);
+
+	for(ComputedColumn * col : *computedColumns())
+		if(	col->codeType() != ComputedColumn::computedType::analysis				&&
+			col->codeType() != ComputedColumn::computedType::analysisNotComputed	)
+			for(const std::string & changed : changedColumns)
+				if(col->dependsOn(changed))
+				{
+					invalidate(QString::fromStdString(col->name()));
+					break;
+				}
+
+	for(ComputedColumn * col : *computedColumns())
+		if(	col->codeType() != ComputedColumn::computedType::analysis				&&
+			col->codeType() != ComputedColumn::computedType::analysisNotComputed	&&
+			col->iShouldBeSentAgain() )
+			emitSendComputeCode(QString::fromStdString(col->name()), QString::fromStdString(col->rCodeCommentStripped()), DataSetPackage::pkg()->getColumnType(col->name()));
+}
+
 void ComputedColumnsModel::checkForDependentAnalyses(std::string columnName)
 {
 	Analyses::analyses()->applyToAll([&](Analysis * analysis)
@@ -87,6 +87,8 @@ public slots:
 				void				requestColumnCreation(QString columnName, Analysis * analysis, int columnType);
 				void				requestComputedColumnDestruction(QString columnName);
 				void				recomputeColumn(std::string columnName);
+				void				labelsChanged();
+				void				dataSetLoaded()																{ _labelsSeen = DataSetPackage::pkg()->latestChange(); }
 				void				setLastCreatedColumn(QString lastCreatedColumn);
 				void				analysisRemoved(Analysis * analysis);
 				void				setShowThisColumn(QString showThisColumn);
@@ -99,6 +101,8 @@ public slots:
 private:
 	static ComputedColumnsModel * _singleton;
 
+	DataSetChanges::Version	_labelsSeen				= 0;	///< Last version of DataSet::changes() that labelsChanged looked at
+
 	QString					_currentlySelectedName	= "",
 							_lastCreatedColumn		= "",
 							_showThisColumn			= "";
@@ -19,12 +19,16 @@
 #include "utilities/qutils.h"
 #include "sharedmemory.h"
 #include <QThread>
+#include <QTimer>
 #include "engine/enginesync.h"
 #include "qquick/jasptheme.h"
 #include "columnencoder.h"
 #include "timers.h"
 #include "utilities/appdirs.h"
+#include "utilities/settings.h"
 #include "utils.h"
+#include <climits>
+#include <cassert>
 
 #define ENUM_DECLARATION_CPP
 #include "datasetpackage.h"
@@ -72,7 +76,8 @@ void DataSetPackage::resumeEngines()
 	if(isThisTheSameThreadAsEngineSync())	_engineSync->resume();
 	else									emit resumeEnginesSignal();
 
-	ColumnEncoder::setCurrentColumnNames(getColumnNames()); //Same place as in engine, should be fine right?
+	if(!_dataSet || _dataSet->changes().columnsChangedSince(_columnNamesSeen))
+		ColumnEncoder::setCurrentColumnNames(getColumnNames()); //Same place as in engine, should be fine right?
 }
 
 void DataSetPackage::reset()
@@ -113,9 +118,68 @@ void DataSetPackage::setDataSet(DataSet * dataSet)
 
 void DataSetPackage::createDataSet()
 {
+	SharedMemory::setUseMappedFile(Settings::value(Settings::DATASET_IN_MAPPED_FILE).toBool());
 	setDataSet(SharedMemory::createDataSet()); //Why would we do this here but the free in the asyncloader?
 }
 
+void DataSetPackage::reserveDataSetMemory(size_t bytesNeeded)
+{
+	try							{ setDataSet(SharedMemory::reserveDataSet(_dataSet, bytesNeeded)); }
+	catch (std::exception &)	{ throw std::runtime_error("Out of memory: this data set is too large for your computer's available memory"); }
+}
+
+void DataSetPackage::logDataSetMemoryUsage(const std::string & when)
+{
+	SharedMemory::logMemoryUsage(_dataSet, when);
+}
+
+void DataSetPackage::compactDataSet(bool onlyIfWorthIt)
+{
+	if(!_dataSet || (onlyIfWorthIt && !SharedMemory::compactionWorthIt(_dataSet)))
+		return;
+
+	//Same as growing, the segment is replaced so the engines have to let go of it
+	bool pauseForCompaction = !_loadingData && !enginesInitializing();
+
+	if(pauseForCompaction)
+		pauseEngines();
+
+	logDataSetMemoryUsage("before compacting");
+
+	try							{ setDataSet(SharedMemory::compactDataSet(_dataSet)); }
+	catch (std::exception & e)
+	{
+		if(pauseForCompaction)
+			resumeEngines();
+
+		throw std::runtime_error(std::string("Compacting the data set failed: ") + e.what());
+	}
+
+	logDataSetMemoryUsage("after compacting");
+
+	if(pauseForCompaction)
+		resumeEngines();
+}
+
+void DataSetPackage::scheduleCompaction()
+{
+	if(_compactionScheduled)
+		return;
+
+	_compactionScheduled = true;
+
+	QTimer::singleShot(0, this, [&]()
+	{
+		_compactionScheduled = false;
+
+		if(_loadingData) //endLoadingData compacts anyway
+			return;
+
+		try							{ compactDataSet(true); }
+		catch (std::exception & e)	{ Log::log() << e.what() << std::endl; } //The data set is still where it was, just not compacted
+	});
+}
+
 void DataSetPackage::freeDataSet()
 {
 	if(_dataSet)
@@ -196,7 +260,7 @@ int DataSetPackage::rowCount(const QModelIndex & parent) const
 	}
 	case parIdxType::filter:
 	case parIdxType::root:		//return int(parIdxType::leaf); Its more logical to get the actual datasize
-	case parIdxType::data:		return !_dataSet ? 0 : _dataSet->rowCount();
+	case parIdxType::data:		return !_dataSet ? 0 : int(std::min<size_t>(_dataSet->rowCount(), INT_MAX)); //A QModelIndex has an int row, the rows beyond that are only reachable through the DataSet itself
 	}
 
 	return 0; // <- because gcc is stupid
@@ -234,9 +298,9 @@ QVariant DataSetPackage::data(const QModelIndex &index, int role) const
 		return QVariant();
 
 	case parIdxType::filter:
-		if(_dataSet == nullptr || index.row() < 0 || index.row() >= _dataSet->filterVector().size())
+		if(_dataSet == nullptr || index.row() < 0 || index.row() >= _dataSet->filter().size())
 			return true;
-		return _dataSet->filterVector()[index.row()];
+		return _dataSet->filter().test(index.row());
 
 	case parIdxType::data:
 		if(_dataSet == nullptr || index.column() >= _dataSet->columnCount() || index.row() >= _dataSet->rowCount())
@@ -338,13 +402,12 @@ bool DataSetPackage::setData(const QModelIndex &index, const QVariant &value, in
 		return false;
 
 	case parIdxType::filter:
-		if(index.row() < 0 || index.row() >= _dataSet->filterVector().size() || value.type() != QMetaType::Bool)
+		if(index.row() < 0 || index.row() >= _dataSet->filter().size() || value.type() != QMetaType::Bool)
 			return false;
 
-		if(_dataSet->filterVector()[index.row()] != value.toBool())
+		if(_dataSet->filter().set(index.row(), value.toBool()))
 		{
-			_dataSet->filterVector()[index.row()] = value.toBool();
-
+			_dataSet->changes().record(DataSetChanges::Kind::filter, -1, index.row(), 1);
 			emit dataChanged(DataSetPackage::index(index.row(), 0, parentModelForType(parIdxType::filter)),		DataSetPackage::index(index.row(), columnCount(index.parent()), parentModelForType(parIdxType::filter)));	//Emit dataChanged for filter
 			emit dataChanged(DataSetPackage::index(index.row(), 0, parentModelForType(parIdxType::data)),		DataSetPackage::index(index.row(), columnCount(),				parentModelForType(parIdxType::data)));		//Emit dataChanged for data
 			return true;
@@ -378,8 +441,16 @@ bool DataSetPackage::setData(const QModelIndex &index, const QVariant &value, in
 
 		default:
 		{
-			QString originalLabel = tq(labels.getLabelFromRow(index.row()));
-			if(labels.setLabelFromRow(index.row(), value.toString().toStdString()))
+			QString originalLabel	= tq(labels.getLabelFromRow(index.row()));
+			bool	changedLabel	= false;
+
+			enlargeDataSetIfNecessary([&]()
+			{
+				DataSet::ColumnWrite write(*_dataSet, _dataSet->column(columnIndex), DataSetChanges::Kind::labels);
+				changedLabel = _dataSet->column(columnIndex).labels().setLabelFromRow(index.row(), value.toString().toStdString());
+			}, "setData label");
+
+			if(changedLabel)
 			{
 				QModelIndex parent	= index.parent();
 				size_t		row		= index.row(),
@@ -390,7 +461,7 @@ bool DataSetPackage::setData(const QModelIndex &index, const QVariant &value, in
 				parent = parentModelForType(parIdxType::data);
 				emit dataChanged(DataSetPackage::index(0, col, parent), DataSetPackage::index(rowCount(), col, parent), { Qt::DisplayRole });
 
-				emit labelChanged(tq(getColumnName(col)), originalLabel, tq(labels.getLabelFromRow(index.row())));
+				emit labelChanged(tq(getColumnName(col)), originalLabel, tq(_dataSet->column(columnIndex).labels().getLabelFromRow(index.row())));
 				emit refreshAnalysesWithColumn(tq(getColumnName(columnIndex)));
 				return true;
 			}
@@ -710,14 +781,20 @@ void DataSetPackage::resetAllFilters()
 	emit headerDataChanged(Qt::Horizontal, 0, columnCount());
 }
 
-bool DataSetPackage::setColumnType(int columnIndex, columnType newColumnType)
+bool DataSetPackage::setColumnType(int columnIndex, columnType newColumnType, ColumnTypeConverter::Progress progress)
 {
 	if (_dataSet == nullptr)
 		return true;
 
-	bool changed;
+	//Working out the new values only reads the column, so that happens before the write and the engines can keep on reading meanwhile
+	ColumnTypeConverter::Conversion	conversion	= ColumnTypeConverter::convert(_dataSet->column(columnIndex), newColumnType, progress);
+	bool							changed;
 
-	enlargeDataSetIfNecessary([&](){ changed = _dataSet->column(columnIndex).changeColumnType(newColumnType); }, "setColumnType");
+	enlargeDataSetIfNecessary([&]()
+	{
+		DataSet::ColumnWrite write(*_dataSet, _dataSet->column(columnIndex), DataSetChanges::Kind::columnType);
+		changed = ColumnTypeConverter::apply(_dataSet->column(columnIndex), conversion);
+	}, "setColumnType");
 
 	if (changed)
 	{
@@ -790,7 +867,8 @@ void DataSetPackage::beginLoadingData()
 {
 	JASPTIMER_SCOPE(DataSetPackage::beginLoadingData);
 
-	_enginesLoadedAtBeginSync = !enginesInitializing();
+	_enginesLoadedAtBeginSync	= !enginesInitializing();
+	_loadingData				= true;
 
 	if(_enginesLoadedAtBeginSync)
 		pauseEngines();
@@ -804,6 +882,22 @@ void DataSetPackage::endLoadingData()
 
 	endResetModel();
 
+	if(_dataSet)
+	{
+		_dataSet->changes().record(DataSetChanges::Kind::everything);
+		_dataSet->refreshColumnStats(); //Before the engines get going again, they only read the stats
+
+		Log::log() << "Packed " << _dataSet->packColumns() << " of " << _dataSet->columnCount() << " columns" << std::endl;
+		logDataSetMemoryUsage("after packing");
+
+		//The sort indices and sketches are for whoever asks for them first, for a wide data set making them all here would take hundreds of MB
+		assert(_dataSet->derivedColumnCount() == 0);
+
+		compactDataSet(true); //Packing and resyncs free a lot in the middle of the segment
+	}
+
+	_loadingData = false;
+
 	if(_enginesLoadedAtBeginSync)
 		resumeEngines();
 
@@ -822,6 +916,20 @@ void DataSetPackage::setDataSetSize(size_t columnCount, size_t rowCount)
 	}, "setDataSetSize");
 }
 
+void DataSetPackage::removeDataSetRows(size_t row, size_t count)
+{
+	//Removing rows moves every column at once, that is only safe while the engines are paused and the model is reset around it
+	if(!_loadingData)
+		throw std::logic_error("DataSetPackage::removeDataSetRows can only be used between beginSynchingData and endSynchingData");
+
+	_dataSet->removeRows(row, count);
+}
+
+void DataSetPackage::insertDataSetColumns(size_t index, size_t count)
+{
+	enlargeDataSetIfNecessary([&](){ _dataSet->insertColumns(index, count); }, "insertDataSetColumns");
+}
+
 bool DataSetPackage::initColumnAsScale(size_t colNo, std::string newName, const std::vector<double> & values)
 {
 	bool out = false;
@@ -829,7 +937,7 @@ bool DataSetPackage::initColumnAsScale(size_t colNo, std::string newName, const
 	enlargeDataSetIfNecessary([&]()
 	{
 		Column &column = _dataSet->column(colNo);
-		column.setName(newName);
+		setColumnName(colNo, newName);
 		out = column.setColumnAsScale(values);
 	}, "initColumnAsScale");
 
@@ -838,14 +946,14 @@ bool DataSetPackage::initColumnAsScale(size_t colNo, std::string newName, const
 	return out;
 }
 
-std::map<int, std::string> DataSetPackage::initColumnAsNominalText(size_t colNo, std::string newName, const std::vector<std::string> & values, const std::map<std::string, std::string> & labels)
+std::map<size_t, std::string> DataSetPackage::initColumnAsNominalText(size_t colNo, std::string newName, const std::vector<std::string> & values, const std::map<std::string, std::string> & labels)
 {
-	std::map<int, std::string> out;
+	std::map<size_t, std::string> out;
 
 	enlargeDataSetIfNecessary([&]()
 	{
 		Column &column = _dataSet->column(colNo);
-		column.setName(newName);
+		setColumnName(colNo, newName);
 		out = column.setColumnAsNominalText(values, labels);
 	}, "initColumnAsNominalText");
 
@@ -861,7 +969,7 @@ bool DataSetPackage::initColumnAsNominalOrOrdinal(size_t colNo, std::string newN
 	enlargeDataSetIfNecessary([&]()
 	{
 		Column &column = _dataSet->column(colNo);
-		column.setName(newName);
+		setColumnName(colNo, newName);
 		out = column.setColumnAsNominalOrOrdinal(values, is_ordinal);
 	}, "initColumnAsNominalOrOrdinal");
 
@@ -877,7 +985,7 @@ bool DataSetPackage::initColumnAsNominalOrOrdinal(size_t colNo, std::string newN
 	enlargeDataSetIfNecessary([&]()
 	{
 		Column &column = _dataSet->column(colNo);
-		column.setName(newName);
+		setColumnName(colNo, newName);
 		out = column.setColumnAsNominalOrOrdinal(values, uniqueValues, is_ordinal);
 	}, "initColumnAsNominalOrOrdinal");
 
@@ -897,7 +1005,7 @@ bool DataSetPackage::initColumnAsScale(QVariant colID, std::string newName, cons
 		return initColumnAsScale(colID.toString().toStdString(), newName, values);
 }
 
-std::map<int, std::string> DataSetPackage::initColumnAsNominalText(QVariant colID, std::string newName, const std::vector<std::string> & values, const std::map<std::string, std::string> & labels)
+std::map<size_t, std::string> DataSetPackage::initColumnAsNominalText(QVariant colID, std::string newName, const std::vector<std::string> & values, const std::map<std::string, std::string> & labels)
 {
 	if(colID.type() == QMetaType::Int || colID.type() == QMetaType::UInt)
 	{
@@ -937,8 +1045,17 @@ void DataSetPackage::enlargeDataSetIfNecessary(std::function<void()> tryThis, co
 		try	{ tryThis(); return; }
 		catch (boost::interprocess::bad_alloc &)
 		{
+			//Growing remaps the segment, so unless a load already paused them the engines have to let go of it first. Versions of columns cannot help there.
+			bool pauseForGrowth = !_loadingData && !enginesInitializing();
+
+			if(pauseForGrowth)
+				pauseEngines();
+
 			try							{ setDataSet(SharedMemory::enlargeDataSet(_dataSet)); }
 			catch (std::exception &)	{ throw std::runtime_error("Out of memory: this data set is too large for your computer's available memory");	}
+
+			if(pauseForGrowth)
+				resumeEngines();
 		}
 		catch (std::exception & e)	{ Log::log() << "std::exception in enlargeDataSetIfNecessary for " << callerText << ": " << e.what() << std::endl;	}
 		catch (...)					{ Log::log() << "something went wrong while enlargeDataSetIfNecessary for " << callerText << "..." << std::endl;	}
@@ -958,24 +1075,34 @@ std::vector<std::string> DataSetPackage::getColumnNames(bool includeComputed)
 	return names;
 }
 
-bool DataSetPackage::isColumnDifferentFromStringValues(std::string columnName, std::vector<std::string> strVals)
+bool DataSetPackage::isColumnDifferentFromStringValues(std::string columnName, const std::vector<std::string> & strVals, size_t skipRow, size_t skipCount)
 {
 	try
 	{
 		Column & col = _dataSet->column(columnName);
-		return col.isColumnDifferentFromStringValues(strVals);
+		return col.isColumnDifferentFromStringValues(strVals, skipRow, skipCount);
 	}
 	catch(columnNotFound & ) { }
 
 	return true;
 }
 
+size_t DataSetPackage::firstRowDifferentFromStringValues(std::string columnName, const std::vector<std::string> & strVals)
+{
+	try
+	{
+		return _dataSet->column(columnName).firstRowDifferentFromStringValues(strVals);
+	}
+	catch(columnNotFound & ) { }
+
+	return 0;
+}
+
 void DataSetPackage::renameColumn(std::string oldColumnName, std::string newColumnName)
 {
 	try
 	{
-		Column & col = _dataSet->column(oldColumnName);
-		col.setName(newColumnName);
+		setColumnName(_dataSet->columns().findIndexByName(oldColumnName), newColumnName);
 		emit columnNamesChanged();
 	}
 	catch(...)
@@ -984,6 +1111,37 @@ void DataSetPackage::renameColumn(std::string oldColumnName, std::string newColu
 	}
 }
 
+void DataSetPackage::setColumnName(size_t colIndex, const std::string & name)
+{
+	if(_dataSet->column(colIndex).name() == name)
+		return;
+
+	_dataSet->columns().setColumnName(colIndex, name);
+	_dataSet->changes().record(DataSetChanges::Kind::columnName, _dataSet->column(colIndex).id());
+}
+
+std::vector<std::string> DataSetPackage::columnNamesChangedSince(DataSetChanges::Version & seen, DataSetChanges::Kind kind) const
+{
+	std::vector<std::string> names;
+
+	if(!_dataSet)
+		return names;
+
+	std::vector<DataSetChanges::Change>	changes;
+	bool								complete	= _dataSet->changes().since(seen, changes);
+	std::set<int>						changedIds;
+
+	for(const DataSetChanges::Change & change : changes)
+		if(change.kind == kind && change.columnId != -1)
+			changedIds.insert(change.columnId);
+
+	for(size_t col=0; col<_dataSet->columnCount(); col++)
+		if(!complete || changedIds.count(_dataSet->column(col).id()) > 0)
+			names.push_back(_dataSet->column(col).name());
+
+	return names;
+}
+
 void DataSetPackage::writeDataSetToOStream(std::ostream & out, bool includeComputed)
 {
 	std::vector<Column*> cols;
@@ -1095,7 +1253,7 @@ Json::Value DataSetPackage::columnToJsonForJASPFile(size_t columnIndex, Json::Va
 			}
 
 			Json::Value &orgStringValuesMetaData	= columnLabelData["orgStringValues"];
-			std::map<int, std::string> &orgLabels	= labels.getOrgStringValues();
+			std::map<int, std::string> orgLabels		= labels.getOrgStringValues();
 			for (const std::pair<int, std::string> &pair : orgLabels)
 			{
 				Json::Value keyValuePair(Json::arrayValue);
@@ -1132,7 +1290,7 @@ void DataSetPackage::columnLabelsFromJsonForJASPFile(Json::Value xData, Json::Va
 		Column &column = _dataSet->column(columnIndex);
 		columnType columnType = parseColumnTypeForJASPFile(columnDesc["measureType"].asString());
 
-		column.setName(name);
+		setColumnName(columnIndex, name);
 		column.setColumnType(columnType);
 
 		Labels &labels = column.labels();
@@ -1183,7 +1341,13 @@ std::vector<int> DataSetPackage::getColumnDataInts(size_t columnIndex)
 	if(_dataSet == nullptr) return {};
 
 	Column & col = _dataSet->column(columnIndex);
-	return std::vector<int>(col.AsInts.begin(), col.AsInts.end());
+
+	if(col.getColumnType() == columnType::scale) return {};
+
+	std::vector<int> ints(col.rowCount());
+	col.readInto(ints.data(), 0, ints.size());
+
+	return ints;
 }
 
 std::vector<double> DataSetPackage::getColumnDataDbls(size_t columnIndex)
@@ -1191,7 +1355,13 @@ std::vector<double> DataSetPackage::getColumnDataDbls(size_t columnIndex)
 	if(_dataSet == nullptr) return {};
 
 	Column & col = _dataSet->column(columnIndex);
-	return std::vector<double>(col.AsDoubles.begin(), col.AsDoubles.end());
+
+	if(col.getColumnType() != columnType::scale) return {};
+
+	std::vector<double> doubles(col.rowCount());
+	col.readInto(doubles.data(), 0, doubles.size());
+
+	return doubles;
 }
 
 void DataSetPackage::setColumnDataInts(size_t columnIndex, std::vector<int> ints)
@@ -1214,19 +1384,17 @@ void DataSetPackage::setColumnDataInts(size_t columnIndex, std::vector<int> ints
 			Log::log() << "Value '" << value << "' in column '" << col.name() << "' did not have a corresponding label, adding one now.\n";
 			lab.add(value, std::to_string(value), true, col.getColumnType() == columnType::nominalText);
 		}
-
-		col.setValue(r, value);
 	}
+
+	col.setValues(0, ints.data(), std::min(ints.size(), col.rowCount()));
 }
 
 
 void DataSetPackage::setColumnDataDbls(size_t columnIndex, std::vector<double> dbls)
 {
 	Column & col = _dataSet->column(columnIndex);
-	Labels & lab = col.labels();
 
-	for(size_t r = 0; r<dbls.size(); r++)
-		col.setValue(r, dbls[r]);
+	col.setValues(0, dbls.data(), std::min(dbls.size(), col.rowCount()));
 }
 
 void DataSetPackage::emptyValuesChangedHandler()
@@ -1234,19 +1402,43 @@ void DataSetPackage::emptyValuesChangedHandler()
 	if (isLoaded())
 	{
 		beginSynchingData();
-		std::map<std::string, std::map<int, std::string> > emptyValuesChanged;
 		std::vector<std::string> colChanged;
 
-		enlargeDataSetIfNecessary([&](){ emptyValuesChanged = _dataSet->resetEmptyValues(emptyValuesMap()); }, "emptyValuesChangedHandler");
+		enlargeDataSetIfNecessary([&](){ colChanged = _dataSet->resetEmptyValues(); }, "emptyValuesChangedHandler");
+
+		endSynchingDataChangedColumns(colChanged);
+	}
+}
+
+void DataSetPackage::storeInEmptyValues(std::string columnName, std::map<size_t, std::string> emptyValues)
+{
+	int colIndex = getColumnIndex(columnName);
+
+	if(colIndex >= 0)
+		enlargeDataSetIfNecessary([&](){ _dataSet->column(colIndex).setEmptyValueTokens(emptyValues); }, "storeInEmptyValues");
+}
+
+void DataSetPackage::resetEmptyValues()
+{
+	if(_dataSet)
+		for(Column & column : _dataSet->columns())
+			column.setEmptyValueTokens({});
+}
+
+DataSetPackage::emptyValsType DataSetPackage::emptyValuesMap() const
+{
+	emptyValsType emptyValues;
 
-		for (auto it : emptyValuesChanged)
+	if(_dataSet)
+		for(const Column & column : _dataSet->columns())
 		{
-			colChanged.push_back(it.first);
-			storeInEmptyValues(it.first, it.second);
+			std::map<size_t, std::string> tokens = column.emptyValueTokens();
+
+			if(tokens.size() > 0)
+				emptyValues[column.name()] = tokens;
 		}
 
-		endSynchingDataChangedColumns(colChanged);
-	}
+	return emptyValues;
 }
 
 bool DataSetPackage::setFilterData(std::string filter, std::vector<bool> filterResult)
@@ -1294,6 +1486,14 @@ QStringList DataSetPackage::getColumnLabelsAsStringList(size_t columnIndex)	cons
 	return list;
 }
 
+ColumnDescriptives::Summary DataSetPackage::getColumnSummary(size_t columnIndex) const
+{
+	if(!_dataSet || columnIndex >= _dataSet->columnCount()) return ColumnDescriptives::Summary();
+
+	//Only we write the columns and only from this thread, so the const column can be read while the engines keep going. It isn't changed, so they never see it halfway.
+	return ColumnDescriptives::summarize(_dataSet->column(columnIndex));
+}
+
 void DataSetPackage::labelMoveRows(size_t column, std::vector<size_t> rows, bool up)
 {
 	Labels & labels = _dataSet->column(column).labels();
@@ -1311,7 +1511,12 @@ void DataSetPackage::labelMoveRows(size_t column, std::vector<size_t> rows, bool
 		rowsChanged.insert(row + mod);
 	}
 
-	labels.set(new_labels);
+	enlargeDataSetIfNecessary([&]()
+	{
+		DataSet::ColumnWrite write(*_dataSet, _dataSet->column(column), DataSetChanges::Kind::labels);
+		_dataSet->column(column).labels().set(new_labels);
+	}, "labelMoveRows");
+
 	QModelIndex p = parentModelForType(parIdxType::label, column);
 
 	for(size_t row: rowsChanged)
@@ -1328,7 +1533,13 @@ void DataSetPackage::labelReverse(size_t column)
 	std::vector<Label> new_labels(labels.begin(), labels.end());
 
 	std::reverse(new_labels.begin(), new_labels.end());
-	labels.set(new_labels);
+
+	enlargeDataSetIfNecessary([&]()
+	{
+		DataSet::ColumnWrite write(*_dataSet, _dataSet->column(column), DataSetChanges::Kind::labels);
+		_dataSet->column(column).labels().set(new_labels);
+	}, "labelReverse");
+
 	QModelIndex p = parentModelForType(parIdxType::label, column);
 
 	emit dataChanged(index(0, 0, p), index(rowCount(p), columnCount(p), p));
@@ -1345,7 +1556,11 @@ void DataSetPackage::columnSetDefaultValues(std::string columnName, columnType c
 	if(colIndex >= 0)
 	{
 		QModelIndex p = parentModelForType(parIdxType::data);
-		_dataSet->column(colIndex).setDefaultValues(columnType);
+		enlargeDataSetIfNecessary([&]()
+		{
+			DataSet::ColumnWrite write(*_dataSet, _dataSet->column(colIndex));
+			_dataSet->column(colIndex).setDefaultValues(columnType);
+		}, "columnSetDefaultValues");
 		emit dataChanged(index(0, colIndex, p), index(rowCount(p), colIndex, p));
 		emit headerDataChanged(Qt::Horizontal, colIndex, colIndex);
 	}
@@ -1369,6 +1584,18 @@ bool DataSetPackage::createColumn(std::string name, columnType columnType)
 	return true;
 }
 
+bool DataSetPackage::shareIdenticalColumnValues(std::string name, const std::set<std::string> & candidates)
+{
+	int colIndex = getColumnIndex(name);
+	if(colIndex == -1) return false;
+
+	bool shared = false;
+
+	enlargeDataSetIfNecessary([&](){ shared = _dataSet->shareIdenticalValues(colIndex, candidates); }, "shareIdenticalColumnValues");
+
+	return shared;
+}
+
 void DataSetPackage::removeColumn(std::string name)
 {
 	int colIndex = getColumnIndex(name);
@@ -1378,8 +1605,11 @@ void DataSetPackage::removeColumn(std::string name)
 
 	beginResetModel();
 	_dataSet->columns().removeColumn(name);
+	_dataSet->changes().record(DataSetChanges::Kind::columns);
 	endResetModel();
 
+	scheduleCompaction(); //Analyses and syncs tend to remove several columns in a row
+
 	if(isLoaded()) setModified(true);
 
 	emit datasetChanged({}, {tq(name)}, {}, false, false);
@@ -1387,16 +1617,7 @@ void DataSetPackage::removeColumn(std::string name)
 
 std::vector<bool> DataSetPackage::filterVector()
 {
-	std::vector<bool> out;
-
-	if(_dataSet)
-	{
-		out.reserve(_dataSet->filterVector().size());
-		for(bool f : _dataSet->filterVector())
-			out.push_back(f);
-	}
-
-	return out;
+	return _dataSet ? _dataSet->filter().toVector() : std::vector<bool>();
 }
 
 
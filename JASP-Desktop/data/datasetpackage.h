@@ -23,6 +23,8 @@
 #include <QUrl>
 #include "common.h"
 #include "dataset.h"
+#include "columndescriptives.h"
+#include "columntypeconverter.h"
 #include "../JASP-Common/version.h"
 #include <map>
 #include "jsonredirect.h"
@@ -49,7 +51,7 @@ class DataSetPackage : public QAbstractItemModel //Not QAbstractTableModel becau
 	Q_PROPERTY(bool			loaded					READ isLoaded				WRITE setLoaded			NOTIFY loadedChanged				)
 	Q_PROPERTY(QString		currentFile				READ currentFile			WRITE setCurrentFile	NOTIFY currentFileChanged			)
 
-	typedef std::map<std::string, std::map<int, std::string>> emptyValsType;
+	typedef std::map<std::string, std::map<size_t, std::string>> emptyValsType;
 
 public:
 	enum class	specialRoles { filter = Qt::UserRole, lines, maxColString, maxRowHeaderString, columnIsComputed, computedColumnIsInvalidated, labelsHasFilter, computedColumnError, value, columnType };
@@ -64,9 +66,14 @@ public:
 		void				setDataSetColumnCount(size_t columnCount)			{ setDataSetSize(columnCount,			dataRowCount()); }
 		void				setDataSetRowCount(size_t rowCount)					{ setDataSetSize(dataColumnCount(),		rowCount); }
 		void				increaseDataSetColCount(size_t rowCount)			{ setDataSetSize(dataColumnCount() + 1,	rowCount); }
+		void				removeDataSetRows(size_t row, size_t count);		///< Only while synching, throws std::logic_error otherwise
+		void				insertDataSetColumns(size_t index, size_t count);
 
 		void				createDataSet();
 		void				freeDataSet();
+		void				reserveDataSetMemory(size_t bytesNeeded);
+		void				logDataSetMemoryUsage(const std::string & when);
+		void				compactDataSet(bool onlyIfWorthIt = false); ///< Copies the data set into a fresh segment to give back the memory that was freed in it, see SharedMemory::compactDataSet
 		bool				hasDataSet() { return _dataSet; }
 
 		void				pauseEngines();
@@ -97,13 +104,14 @@ public:
 				QModelIndex			index(int row, int column, const QModelIndex &parent)								const	override;
 				parIdxType			parentIndexTypeIs(const QModelIndex &index)											const;
 				QModelIndex			parentModelForType(parIdxType type, int column = 0)									const;
-				int					filteredRowCount()																	const { return _dataSet ? _dataSet->filteredRowCount() : 0; }
+				size_t				filteredRowCount()																	const { return _dataSet ? _dataSet->filteredRowCount() : 0; }
 
-				int					dataRowCount()		const { return rowCount(parentModelForType(parIdxType::data));		}
+				int					dataRowCount()		const { return rowCount(parentModelForType(parIdxType::data));		} ///< What the views see, at most INT_MAX
+				size_t				dataSetRowCount()	const { return _dataSet ? _dataSet->rowCount() : 0;					} ///< All of the rows, also beyond what fits in a QModelIndex
 				int					dataColumnCount()	const { return columnCount(parentModelForType(parIdxType::data));	}
 
-				void				storeInEmptyValues(std::string columnName, std::map<int, std::string> emptyValues)	{ _emptyValuesMap[columnName] = emptyValues;	}
-				void				resetEmptyValues()																	{ _emptyValuesMap.clear();											}
+				void				storeInEmptyValues(std::string columnName, std::map<size_t, std::string> emptyValues);	///< Kept by the column itself, see MissingValues
+				void				resetEmptyValues();
 
 				std::string			id()								const	{ return _id;							}
 				QString				name()								const;
@@ -122,7 +130,7 @@ public:
 		const	Json::Value		&	analysesData()						const	{ return _analysesData;							 }
 		const	std::string		&	warningMessage()					const	{ return _warningMessage;						  }
 		const	Version			&	archiveVersion()					const	{ return _archiveVersion;						   }
-		const	emptyValsType	&	emptyValuesMap()					const	{ return _emptyValuesMap;   						}
+				emptyValsType		emptyValuesMap()					const;
 
 				bool				dataFileReadOnly()					const	{ return _dataFileReadOnly;						     }
 				uint				dataFileTimestamp()					const	{ return _dataFileTimestamp;					      }
@@ -164,17 +172,21 @@ public:
 				bool						initColumnAsNominalOrOrdinal(	std::string colName,	std::string newName, const std::vector<int>			& values,	bool is_ordinal = false) { return initColumnAsNominalOrOrdinal(_dataSet->getColumnIndex(colName), newName, values, is_ordinal); }
 				bool						initColumnAsNominalOrOrdinal(	QVariant colID,			std::string newName, const std::vector<int>			& values,	bool is_ordinal = false);
 
-				std::map<int, std::string>	initColumnAsNominalText(		size_t colNo,			std::string newName, const std::vector<std::string>	& values,	const std::map<std::string, std::string> & labels = std::map<std::string, std::string>());
-				std::map<int, std::string>	initColumnAsNominalText(		std::string colName,	std::string newName, const std::vector<std::string>	& values,	const std::map<std::string, std::string> & labels = std::map<std::string, std::string>())	{ return initColumnAsNominalText(_dataSet->getColumnIndex(colName), newName, values, labels); }
-				std::map<int, std::string>	initColumnAsNominalText(		QVariant colID,			std::string newName, const std::vector<std::string>	& values,	const std::map<std::string, std::string> & labels = std::map<std::string, std::string>());
+				std::map<size_t, std::string>	initColumnAsNominalText(	size_t colNo,			std::string newName, const std::vector<std::string>	& values,	const std::map<std::string, std::string> & labels = std::map<std::string, std::string>());
+				std::map<size_t, std::string>	initColumnAsNominalText(	std::string colName,	std::string newName, const std::vector<std::string>	& values,	const std::map<std::string, std::string> & labels = std::map<std::string, std::string>())	{ return initColumnAsNominalText(_dataSet->getColumnIndex(colName), newName, values, labels); }
+				std::map<size_t, std::string>	initColumnAsNominalText(	QVariant colID,			std::string newName, const std::vector<std::string>	& values,	const std::map<std::string, std::string> & labels = std::map<std::string, std::string>());
 
 				void						columnSetDefaultValues(std::string columnName, columnType colType = columnType::unknown);
 				bool						createColumn(std::string name, columnType colType);
+				bool						shareIdenticalColumnValues(std::string name, const std::set<std::string> & candidates); ///< For a computed column that might be a copy of one it depends on
 				void						renameColumn(std::string oldColumnName, std::string newColumnName);
 				void						removeColumn(std::string name);
 
 				std::vector<std::string>	getColumnNames(bool includeComputed = true);
-				bool						isColumnDifferentFromStringValues(std::string columnName, std::vector<std::string> strVals);
+				std::vector<std::string>	columnNamesChangedSince(DataSetChanges::Version & seen, DataSetChanges::Kind kind) const;	///< Of the columns that had a change of kind in DataSet::changes() after seen, all of them if the log lost track
+				DataSetChanges::Version		latestChange()							const	{ return _dataSet ? _dataSet->changes().latest() : 0; }
+				bool						isColumnDifferentFromStringValues(std::string columnName, const std::vector<std::string> & strVals, size_t skipRow = 0, size_t skipCount = 0); ///< See Column::isColumnDifferentFromStringValues
+				size_t						firstRowDifferentFromStringValues(std::string columnName, const std::vector<std::string> & strVals);
 				size_t						findIndexByName(std::string name)		const;
 
 				bool						getRowFilter(int row)					const;
@@ -191,7 +203,7 @@ public:
 				bool						isColumnInvalidated(size_t colIndex)	const;
 
 				int							setColumnTypeFromQML(int columnIndex, int newColumnType);
-				bool						setColumnType(int columnIndex, columnType newColumnType);
+				bool						setColumnType(int columnIndex, columnType newColumnType, ColumnTypeConverter::Progress progress = nullptr); ///< progress may cancel it, see ColumnTypeConverter
 
 				int							columnsFilteredCount();
 
@@ -213,6 +225,7 @@ public:
 				size_t						getMaximumColumnWidthInCharacters(int columnIndex) const;
 				QStringList					getColumnLabelsAsStringList(std::string columnName)		const;
 				QStringList					getColumnLabelsAsStringList(size_t columnIndex)			const;
+				ColumnDescriptives::Summary	getColumnSummary(size_t columnIndex)						const; ///< Of all rows, read from the column as it is without bringing its stats up to date
 
 				bool						setFilterData(std::string filter, std::vector<bool> filterResult);
 				void						resetFilterAllows(size_t columnIndex);
@@ -278,13 +291,14 @@ private:
 				void				enlargeDataSetIfNecessary(std::function<void()> tryThis, const char * callerText);
 				bool				isThisTheSameThreadAsEngineSync();
 				bool				setAllowFilterOnLabel(const QModelIndex & index, bool newAllowValue);
+				void				scheduleCompaction(); ///< Compacts once the current batch of changes is done, instead of copying the data set for each of them
+				void				setColumnName(size_t colIndex, const std::string & name); ///< And records it in DataSet::changes() if it is another name
 
 
 private:
 	static DataSetPackage	*	_singleton;
 	DataSet					*	_dataSet					= nullptr;
 	EngineSync				*	_engineSync					= nullptr;
-	emptyValsType				_emptyValuesMap;
 
 	QString						_currentFile,
 								_folder;
@@ -303,6 +317,8 @@ private:
 								_hasAnalysesWithoutData		= false,
 								_analysesHTMLReady			= false,
 								_filterShouldRunInit		= false,
+								_loadingData				= false,
+								_compactionScheduled		= false,
 								_enginesLoadedAtBeginSync;
 
 	Json::Value					_analysesData;
@@ -310,6 +326,7 @@ private:
 								_dataArchiveVersion;
 
 	uint						_dataFileTimestamp;
+	DataSetChanges::Version		_columnNamesSeen			= 0;	///< Last version of DataSet::changes() the ColumnEncoder was brought up to date for
 
 	ComputedColumns				_computedColumns;
 	bool						_synchingData;
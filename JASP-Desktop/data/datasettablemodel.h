@@ -44,6 +44,7 @@ public:
 	Q_INVOKABLE int			setColumnTypeFromQML(int columnIndex, int newColumnType)	{ return DataSetPackage::pkg()->setColumnTypeFromQML(columnIndex, newColumnType);	}
 
 	columnType				getColumnType(size_t column)			const				{ return DataSetPackage::pkg()->getColumnType(column);								}
+	ColumnDescriptives::Summary	getColumnSummary(size_t column)		const				{ return DataSetPackage::pkg()->getColumnSummary(column);							}
 	std::string				getColumnName(size_t col)				const				{ return DataSetPackage::pkg()->getColumnName(col);									}
 				bool		showInactive()							const				{ return _showInactive;	}
 
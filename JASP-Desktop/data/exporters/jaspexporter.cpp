@@ -21,6 +21,7 @@
 #include <boost/filesystem.hpp>
 
 #include <sys/stat.h>
+#include <climits>
 
 #include "dataset.h"
 
@@ -101,7 +102,7 @@ void JASPExporter::saveDataArchive(archive *a, boost::function<void(int)> progre
 	metaData["filterData"]				= Json::Value(package->dataFilter());
 	metaData["filterConstructorJSON"]	= package->filterConstructorJson();
 	metaData["computedColumns"]			= ComputedColumns::singleton()->convertToJson();
-	dataSet["rowCount"]					= Json::Value(package->rowCount());
+	dataSet["rowCount"]					= package->dataSetRowCount() <= INT_MAX ? Json::Value(int(package->dataSetRowCount())) : Json::Value(double(package->dataSetRowCount())); //This jsoncpp has no 64 bit ints, a double is exact up to 2^53 rows
 	dataSet["columnCount"]				= Json::Value(package->columnCount());
 
 	dataSet["filterVector"]				= Json::arrayValue;
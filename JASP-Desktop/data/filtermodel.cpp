@@ -150,7 +150,7 @@ void FilterModel::updateStatusBar()
 		return;
 	}
 
-	int     TotalCount			= DataSetPackage::pkg()->rowCount(),
+	size_t  TotalCount			= DataSetPackage::pkg()->dataSetRowCount(),
 	        TotalThroughFilter	= DataSetPackage::pkg()->filteredRowCount();
 	double	PercentageThrough	= 100.0 * ((double)TotalThroughFilter) / ((double)TotalCount);
 
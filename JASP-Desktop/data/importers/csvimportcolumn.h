@@ -11,6 +11,7 @@ public:
 
 	size_t							size()									const	override;
 	std::vector<std::string>		allValuesAsStrings()					const	override { return  _data; }
+	size_t							estimateDistinctValues(bool & numeric)	const	override { return ImportColumn::estimateDistinctValues(_data, numeric); }
 	void							addValue(const std::string &value);
 	const std::vector<std::string>& getValues()								const;
 
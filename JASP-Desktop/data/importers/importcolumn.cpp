@@ -1,5 +1,7 @@
 #include "importcolumn.h"
 #include <cmath>
+#include <set>
+#include <algorithm>
 #include "utils.h"
 #include "log.h"
 
@@ -19,14 +21,14 @@ std::string ImportColumn::name() const
 }
 
 
-bool ImportColumn::convertVecToInt(const std::vector<std::string> &values, std::vector<int> &intValues, std::set<int> &uniqueValues, std::map<int, std::string> &emptyValuesMap)
+bool ImportColumn::convertVecToInt(const std::vector<std::string> &values, std::vector<int> &intValues, std::set<int> &uniqueValues, std::map<size_t, std::string> &emptyValuesMap)
 {
 	emptyValuesMap.clear();
 	uniqueValues.clear();
 	intValues.clear();
 	intValues.reserve(values.size());
 
-	int row = 0;
+	size_t row = 0;
 
 	for (const std::string &value : values)
 	{
@@ -48,13 +50,13 @@ bool ImportColumn::convertVecToInt(const std::vector<std::string> &values, std::
 	return true;
 }
 
-bool ImportColumn::convertVecToDouble(const std::vector<std::string> &values, std::vector<double> &doubleValues, std::map<int, std::string> &emptyValuesMap)
+bool ImportColumn::convertVecToDouble(const std::vector<std::string> &values, std::vector<double> &doubleValues, std::map<size_t, std::string> &emptyValuesMap)
 {
 	emptyValuesMap.clear();
 	doubleValues.clear();
 	doubleValues.reserve(values.size());
 
-	int row = 0;
+	size_t row = 0;
 	for (const std::string &value : values)
 	{
 		double doubleValue = static_cast<double>(NAN);
@@ -75,6 +77,34 @@ bool ImportColumn::convertVecToDouble(const std::vector<std::string> &values, st
 	return true;
 }
 
+size_t ImportColumn::estimateDistinctValues(const std::vector<std::string> &values, bool &numeric)
+{
+	//Looking at every value of a huge column would take as long as importing it, a spread out sample tells enough to size the shared memory
+	const size_t				sampleSize	= 10000,
+								step		= std::max<size_t>(1, values.size() / sampleSize);
+	std::set<std::string>		distinct;
+	size_t						sampled		= 0;
+
+	numeric = true;
+
+	for(size_t row = 0; row < values.size(); row += step, sampled++)
+	{
+		const std::string & value = values[row];
+		double				doubleValue;
+
+		if(numeric && !Utils::convertValueToDoubleForImport(value, doubleValue))
+			numeric = false;
+
+		distinct.insert(value);
+	}
+
+	//If (nearly) every sampled value was different the column probably keeps going like that
+	if(sampled > 0 && distinct.size() * 10 > sampled * 9)
+		return values.size();
+
+	return distinct.size();
+}
+
 void ImportColumn::changeName(const std::string & name)
 {
 	Log::log() << "Changing name of column from '" << _name << "' to '" << name << "'\n." << std::endl;
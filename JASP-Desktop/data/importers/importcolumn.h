@@ -16,11 +16,14 @@ public:
 
 	virtual size_t						size()									const = 0;
 	virtual std::vector<std::string>	allValuesAsStrings()					const = 0;
+	virtual size_t						estimateDistinctValues(bool & numeric)	const { return estimateDistinctValues(allValuesAsStrings(), numeric); }
 			std::string					name()									const;
 			void						changeName(const std::string & name);
 
-	static bool convertVecToInt(	const std::vector<std::string> & values, std::vector<int>		& intValues,	std::set<int> &uniqueValues,	std::map<int, std::string> &emptyValuesMap);
-	static bool convertVecToDouble(	const std::vector<std::string> & values, std::vector<double>	& doubleValues,									std::map<int, std::string> &emptyValuesMap);
+	static bool convertVecToInt(	const std::vector<std::string> & values, std::vector<int>		& intValues,	std::set<int> &uniqueValues,	std::map<size_t, std::string> &emptyValuesMap);
+	static bool convertVecToDouble(	const std::vector<std::string> & values, std::vector<double>	& doubleValues,									std::map<size_t, std::string> &emptyValuesMap);
+
+	static size_t estimateDistinctValues(const std::vector<std::string> & values, bool & numeric);
 
 	static bool isStringValueEqual(const std::string &value, Column &col, size_t row);
 
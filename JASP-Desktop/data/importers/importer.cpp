@@ -17,8 +17,9 @@ void Importer::loadDataSet(const std::string &locator, boost::function<void(int)
 
 	if (columnCount > 0)
 	{
-		int rowCount = importDataSet->rowCount();
+		size_t rowCount = importDataSet->rowCount();
 
+		DataSetPackage::pkg()->reserveDataSetMemory(planDataSetSize(importDataSet).plannedBytes());
 		DataSetPackage::pkg()->setDataSetSize(columnCount, rowCount);
 
 		int colNo = 0;
@@ -31,9 +32,30 @@ void Importer::loadDataSet(const std::string &locator, boost::function<void(int)
 	}
 
 	delete importDataSet;
+	DataSetPackage::pkg()->logDataSetMemoryUsage("after loading " + locator);
 	DataSetPackage::pkg()->endLoadingData();
 }
 
+DataSetSizePlanner Importer::planDataSetSize(ImportDataSet *importDataSet)
+{
+	bool	useCustomThreshold	= Settings::value(Settings::USE_CUSTOM_THRESHOLD_SCALE).toBool();
+	size_t	thresholdScale		= (useCustomThreshold ? Settings::value(Settings::THRESHOLD_SCALE) : Settings::defaultValue(Settings::THRESHOLD_SCALE)).toUInt();
+
+	DataSetSizePlanner planner;
+
+	//Mirrors the decisions of initColumnWithStrings: numbers with few distinct values get labels, other numbers become scale and the rest is text with a label per distinct value
+	for (ImportColumn *importColumn : *importDataSet)
+	{
+		bool	numeric;
+		size_t	distinct	= importColumn->estimateDistinctValues(numeric);
+		bool	scale		= numeric && distinct > thresholdScale;
+
+		planner.addColumn(importDataSet->rowCount(), scale, scale ? 0 : distinct);
+	}
+
+	return planner;
+}
+
 void Importer::initColumn(QVariant colId, ImportColumn *importColumn)
 {
 	initColumnWithStrings(colId, importColumn->name(),  importColumn->allValuesAsStrings());
@@ -45,7 +67,7 @@ void Importer::initColumnWithStrings(QVariant colId, std::string newName, const
 	std::set<int>				uniqueValues;
 	std::vector<int>			intValues;
 	std::vector<double>			doubleValues;
-	std::map<int, std::string>	emptyValuesMap;
+	std::map<size_t, std::string>	emptyValuesMap;
 
 	//If less unique integers than the thresholdScale then we think it must be ordinal: https://github.com/jasp-stats/INTERNAL-jasp/issues/270
 	bool	useCustomThreshold	= Settings::value(Settings::USE_CUSTOM_THRESHOLD_SCALE).toBool();
@@ -85,6 +107,12 @@ void Importer::syncDataSet(const std::string &locator, boost::function<void(int)
 		if (DataSetPackage::pkg()->isColumnComputed(colName)) // make sure "missing" columns aren't actually computed columns
 			missingColumns.erase(colName);
 
+	size_t	removedRow		= 0,
+			removedCount	= 0;
+
+	if (importDataSet->rowCount() < size_t(DataSetPackage::pkg()->dataRowCount()))
+		_findRemovedRows(importDataSet, missingColumns, removedRow, removedCount);
+
 	for (ImportColumn *syncColumn : *importDataSet)
 	{
 		std::string syncColumnName = syncColumn->name();
@@ -95,7 +123,7 @@ void Importer::syncDataSet(const std::string &locator, boost::function<void(int)
 		{
 			missingColumns.erase(syncColumnName);
 
-			if(DataSetPackage::pkg()->isColumnDifferentFromStringValues(syncColumnName, syncColumn->allValuesAsStrings()))
+			if(DataSetPackage::pkg()->isColumnDifferentFromStringValues(syncColumnName, syncColumn->allValuesAsStrings(), removedRow, removedCount))
 			{
 				Log::log() << "Something changed in column: " << syncColumnName << std::endl;
 				changedColumns.push_back(std::pair<int, std::string>(syncColNo, syncColumnName));
@@ -112,7 +140,7 @@ void Importer::syncDataSet(const std::string &locator, boost::function<void(int)
 				const std::string & newColName	= newColIt->first;
 				ImportColumn *newValues = importDataSet->getColumn(newColName);
 
-				if(!DataSetPackage::pkg()->isColumnDifferentFromStringValues(nameMissing, newValues->allValuesAsStrings()))
+				if(!DataSetPackage::pkg()->isColumnDifferentFromStringValues(nameMissing, newValues->allValuesAsStrings(), removedRow, removedCount))
 				{
 					changeNameColumns[nameMissing] = newColName;
 					newColumns.erase(newColIt);
@@ -124,18 +152,32 @@ void Importer::syncDataSet(const std::string &locator, boost::function<void(int)
 		missingColumns.erase(changeNameColumnIt.first);
 
 	if (newColumns.size() > 0 || changedColumns.size() > 0 || missingColumns.size() > 0 || changeNameColumns.size() > 0 || rowCountChanged)
-			_syncPackage(importDataSet, newColumns, changedColumns, missingColumns, changeNameColumns, rowCountChanged);
+			_syncPackage(importDataSet, newColumns, changedColumns, missingColumns, changeNameColumns, rowCountChanged, removedRow, removedCount);
 
 	delete importDataSet;
 }
 
+void Importer::_findRemovedRows(ImportDataSet * syncDataSet, const std::set<std::string> & orgColumnNames, size_t & removedRow, size_t & removedCount)
+{
+	//The rows that are gone are taken to be a single block, which starts where the first column that is still there starts to differ.
+	//If they were somewhere else the columns simply don't compare equal with them skipped, and those are then reloaded as before.
+	removedCount	= DataSetPackage::pkg()->dataRowCount() - syncDataSet->rowCount();
+	removedRow		= syncDataSet->rowCount();
+
+	for (ImportColumn * syncColumn : *syncDataSet)
+		if (orgColumnNames.count(syncColumn->name()) > 0)
+			removedRow = std::min(removedRow, DataSetPackage::pkg()->firstRowDifferentFromStringValues(syncColumn->name(), syncColumn->allValuesAsStrings()));
+}
+
 void Importer::_syncPackage(
 		ImportDataSet								*	syncDataSet,
 		std::vector<std::pair<std::string, int>>	&	newColumns,
 		std::vector<std::pair<int, std::string>>	&	changedColumns, // import col index and original (old) col name
 		std::set<std::string>						&	missingColumns,
 		std::map<std::string, std::string>			&	changeNameColumns, //origname -> newname
-		bool											rowCountChanged)
+		bool											rowCountChanged,
+		size_t											removedRow,
+		size_t											removedCount)
 
 {
 	if(!DataSetPackage::pkg()->checkDoSync())
@@ -160,6 +202,13 @@ void Importer::_syncPackage(
 	}
 
 	int colNo = DataSetPackage::pkg()->columnCount();
+
+	if (removedCount > 0) //Then the columns that only lost those rows are right without reloading them
+	{
+		Log::log() << "Rows removed, from: " << removedRow << " count: " << removedCount << std::endl;
+		DataSetPackage::pkg()->removeDataSetRows(removedRow, removedCount);
+	}
+
 	DataSetPackage::pkg()->setDataSetRowCount(syncDataSet->rowCount());
 
 	for (auto indexColChanged : changedColumns)
@@ -173,12 +222,13 @@ void Importer::_syncPackage(
 
 	if (newColumns.size() > 0)
 	{
+		DataSetPackage::pkg()->insertDataSetColumns(colNo, newColumns.size()); //All at once instead of growing the data set per column
+
 		for (auto it = newColumns.begin(); it != newColumns.end(); ++it, ++colNo)
 		{
-			DataSetPackage::pkg()->increaseDataSetColCount(syncDataSet->rowCount());
 			Log::log() << "New column " << it->first << std::endl;
 
-			initColumn(DataSetPackage::pkg()->dataColumnCount() - 1, syncDataSet->getColumn(it->first));
+			initColumn(colNo, syncDataSet->getColumn(it->first));
 		}
 	}
 
@@ -5,6 +5,7 @@
 #include "../datasetpackage.h"
 #include "importdataset.h"
 #include "timers.h"
+#include "datasetsizeplanner.h"
 
 class ImportDataSet;
 class ImportColumn;
@@ -24,6 +25,9 @@ public:
 protected:
 	virtual ImportDataSet* loadFile(const std::string &locator, boost::function<void(int)> progressCallback) = 0;
 
+	///Estimates how much shared memory the columns of importDataSet will take, so it can be reserved in one go
+	DataSetSizePlanner planDataSetSize(ImportDataSet *importDataSet);
+
 	///colID can be either an integer (the column index in the data) or a string (the (old) name of the column in the data)
 	virtual void initColumn(QVariant colId, ImportColumn *importColumn);
 
@@ -33,12 +37,12 @@ protected:
 	bool						initColumnAsNominalOrOrdinal(	QVariant colID,			std::string newName, const std::vector<int>			& values, bool is_ordinal = false)	{ return DataSetPackage::pkg()->initColumnAsNominalOrOrdinal(colID, newName, values, is_ordinal);				}
 
 	///colID can be either an integer (the column index in the data) or a string (the (old) name of the column in the data)
-	std::map<int, std::string>	initColumnAsNominalText(		QVariant colID,			std::string newName, const std::vector<std::string>	& values)							{ return DataSetPackage::pkg()->initColumnAsNominalText(colID, newName, values);									}
+	std::map<size_t, std::string>	initColumnAsNominalText(	QVariant colID,			std::string newName, const std::vector<std::string>	& values)							{ return DataSetPackage::pkg()->initColumnAsNominalText(colID, newName, values);									}
 
 	///colID can be either an integer (the column index in the data) or a string (the (old) name of the column in the data)
 	bool						initColumnAsScale(				QVariant colID,			std::string newName, const std::vector<double>		& values)							{ return DataSetPackage::pkg()->initColumnAsScale(colID, newName, values);										}
 
-	void						storeInEmptyValues(std::string columnName, std::map<int, std::string> emptyValues)																{ DataSetPackage::pkg()->storeInEmptyValues(columnName, emptyValues);											}
+	void						storeInEmptyValues(std::string columnName, std::map<size_t, std::string> emptyValues)																{ DataSetPackage::pkg()->storeInEmptyValues(columnName, emptyValues);											}
 	void						resetEmptyValues()																																{ DataSetPackage::pkg()->resetEmptyValues();																		}
 
 private:
@@ -48,7 +52,12 @@ private:
 			std::vector<std::pair<int, std::string>>	&	changedColumns,
 			std::set<std::string>						&	missingColumns,
 			std::map<std::string, std::string>			&	changeNameColumns,
-			bool											rowCountChanged);
+			bool											rowCountChanged,
+			size_t											removedRow,
+			size_t											removedCount);
+
+	///Where the rows are that syncDataSet doesn't have anymore, so only those need to be removed instead of reloading all the columns they shifted
+	void _findRemovedRows(ImportDataSet * syncDataSet, const std::set<std::string> & orgColumnNames, size_t & removedRow, size_t & removedCount);
 };
 
 #endif // IMPORTER_H
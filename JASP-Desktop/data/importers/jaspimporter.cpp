@@ -37,6 +37,7 @@
 
 #include "resultstesting/compareresults.h"
 #include "log.h"
+#include "datasetsizeplanner.h"
 
 void JASPImporter::loadDataSet(const std::string &path, boost::function<void(int)> progressCallback)
 {	
@@ -45,7 +46,7 @@ void JASPImporter::loadDataSet(const std::string &path, boost::function<void(int
 	DataSetPackage * packageData = DataSetPackage::pkg();
 
 	packageData->setIsArchive(true);
-	packageData->setDataSet(SharedMemory::createDataSet()); // this is required incase the loading of the data fails so that the SharedMemory::createDataSet() can be later freed.
+	packageData->createDataSet(); // this is required incase the loading of the data fails so that the SharedMemory::createDataSet() can be later freed.
 
 	readManifest(path);
 
@@ -59,6 +60,7 @@ void JASPImporter::loadDataSet(const std::string &path, boost::function<void(int
 	packageData->beginLoadingData();
 	loadDataArchive(path, progressCallback);
 	loadJASPArchive(path, progressCallback);
+	packageData->logDataSetMemoryUsage("after loading " + path);
 	packageData->endLoadingData();
 }
 
@@ -81,8 +83,8 @@ void JASPImporter::loadDataArchive_1_00(const std::string &path, boost::function
 	Json::Value metaData,
 				xData;
 
-	int	columnCount = 0,
-		rowCount = 0;
+	int		columnCount = 0;
+	size_t	rowCount	= 0;
 
 	parseJsonEntry(metaData, path, "metadata.json", true);
 
@@ -118,7 +120,7 @@ void JASPImporter::loadDataArchive_1_00(const std::string &path, boost::function
 	}
 
 	Json::Value &emptyValuesMapJson = dataSetDesc["emptyValuesMap"];
-	packageData->resetEmptyValues();
+	std::map<std::string, std::map<size_t, std::string> > emptyValuesMap; //Stored in the columns once those exist
 
 	if (!emptyValuesMapJson.isNull())
 	{
@@ -126,31 +128,47 @@ void JASPImporter::loadDataArchive_1_00(const std::string &path, boost::function
 		{
 			std::string colName	= iter.key().asString();
 			Json::Value mapJson	= *iter;
-			std::map<int, std::string> map;
+			std::map<size_t, std::string> map;
 
 			for (Json::Value::iterator iter2 = mapJson.begin(); iter2 != mapJson.end(); ++iter2)
 			{
-				int row					= stoi(iter2.key().asString());
+				size_t row				= std::stoull(iter2.key().asString());
 				Json::Value valueJson	= *iter2;
 				std::string value		= valueJson.asString();
 				map[row]				= value;
 			}
-			packageData->storeInEmptyValues(colName, map);
+			emptyValuesMap[colName] = map;
 		}
 	}
 
 	columnCount = dataSetDesc["columnCount"].asInt();
-	rowCount	= dataSetDesc["rowCount"].asInt();
-	if (rowCount < 0 || columnCount < 0)
+	double rows	= dataSetDesc["rowCount"].asDouble(); //Written as a double when it doesn't fit an int
+	if (rows < 0 || columnCount < 0)
 		throw std::runtime_error("Data size has been corrupted.");
 
+	rowCount = size_t(rows);
 
+	Json::Value &columnsDesc = dataSetDesc["fields"];
+
+	//The metadata already tells us the type and labels of every column, so all the memory they need can be reserved in one go
+	DataSetSizePlanner planner;
+	for (const Json::Value & columnDesc : columnsDesc)
+	{
+		Json::Value	labelsDesc	= columnDesc["labels"];
+		bool		scale		= packageData->parseColumnTypeForJASPFile(columnDesc["measureType"].asString()) == columnType::scale;
+
+		if (labelsDesc.isNull() && !xData.isNull())
+			labelsDesc = xData.get(columnDesc["name"].asString(), Json::nullValue)["labels"];
+
+		planner.addColumn(rowCount, scale, labelsDesc.size());
+	}
+
+	packageData->reserveDataSetMemory(planner.plannedBytes());
 	packageData->setDataSetSize(columnCount, rowCount);
 
 	unsigned long long	progress,
 						lastProgress = -1;
 
-	Json::Value &columnsDesc = dataSetDesc["fields"];
 	int i = 0;
 	std::map<std::string, std::map<int, int> > mapNominalTextValues;
 
@@ -219,6 +237,9 @@ void JASPImporter::loadDataArchive_1_00(const std::string &path, boost::function
 
 	dataEntry.close();
 
+	for (const auto & colEmptyValues : emptyValuesMap)
+		packageData->storeInEmptyValues(colEmptyValues.first, colEmptyValues.second);
+
 	if(resultXmlCompare::compareResults::theOne()->testMode())
 	{
 		//Read the results from when the JASP file was saved and store them in compareResults field
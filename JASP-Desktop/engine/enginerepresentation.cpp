@@ -4,6 +4,7 @@
 #include "utilities/qutils.h"
 #include "utils.h"
 #include "log.h"
+#include "ipcmessage.h"
 
 EngineRepresentation::EngineRepresentation(IPCChannel * channel, QProcess * slaveProcess, QObject * parent)
 	: QObject(parent), _channel(channel)
@@ -55,12 +56,12 @@ void EngineRepresentation::cleanUpAfterClose()
 	_lastCompColName	= "???";
 }
 
-void EngineRepresentation::sendString(std::string str)
+void EngineRepresentation::sendJson(const Json::Value & json)
 {
 #ifdef PRINT_ENGINE_MESSAGES
-	Log::log() << "sending to jaspEngine: " << str << "\n" << std::endl;
+	Log::log() << "sending to jaspEngine: " << json.toStyledString() << "\n" << std::endl;
 #endif
-	_channel->send(str);
+	_channel->send(IPCMessage::encode(json));
 }
 
 void EngineRepresentation::processFinished(int exitCode, QProcess::ExitStatus exitStatus)
@@ -156,33 +157,46 @@ void EngineRepresentation::setAnalysisInProgress(Analysis* analysis)
 
 void EngineRepresentation::process()
 {
-	if (_engineState == engineState::idle)
-	{
-		if		(_stopRequested)	sendStopEngine();
-		else if	(_pauseRequested)	sendPauseEngine();
-		return;
-	}
-
 	std::string data;
 
-	if (_channel->receive(data))
+	//The engine queues its messages, so everything that came in is handled now instead of one per call
+	while (_channel->receive(data))
 	{
+		if (_engineState == engineState::idle)
+		{
+			//Nothing is asked of the engine, so this is left over from a request that was answered already, like the last words of an aborted analysis.
+			//It is dropped now, otherwise it would be taken for the reply to the next request.
+			Log::log() << "Engine #" << channelNumber() << " sent a message of " << data.size() << " bytes while idle, it is ignored." << std::endl;
+			continue;
+		}
+
+		Json::Value			json;
+		IPCMessage::Decoded	message;
+		bool				framed = false;
+
+		try
+		{
+			message = IPCMessage::decode(data, json);
+			framed	= true;
+		}
+		catch(std::runtime_error & e)
+		{
+			Log::log() << "Engine #" << channelNumber() << " sent something that is not an IPCMessage: " << e.what() << std::endl; //It is thrown as a malformed reply below
+		}
+
 #ifdef PRINT_ENGINE_MESSAGES
 		{
-			const int _maxDataChars = 300;//I do not want to keep scrolling forever all the time...
-			if(data != "")	Log::log() << "message received from engine #" << channelNumber() << ": " << (data.size() < _maxDataChars ? data : data.substr(0, _maxDataChars)) + "..." << std::endl;
-			else			Log::log() << "Engine #" << channelNumber() << " cleared its send-buffer." << std::endl;
+			const size_t _maxDataChars = 300;//I do not want to keep scrolling forever all the time...
+			std::string body = data.substr(std::min(data.size(), sizeof(IPCMessage::Header)), _maxDataChars);
+			if(!framed || message.body != IPCMessage::Body::empty)	Log::log() << "message received from engine #" << channelNumber() << ": " << body << "..." << std::endl;
+			else													Log::log() << "Engine #" << channelNumber() << " sent an empty message." << std::endl;
 		}
 #endif
 
-		if(data == "")
-			return;
-
-		Json::Value json;
-		bool		jsonIsOK = false;
+		if(framed && message.body == IPCMessage::Body::empty)
+			continue;
 
-		try { jsonIsOK = Json::Reader().parse(data, json) && (json.get("typeRequest", Json::nullValue).isString() || _engineState == engineState::analysis); }
-		catch(...) {}
+		bool jsonIsOK = framed && message.parsed && (message.hasType() || json.get("typeRequest", Json::nullValue).isString() || _engineState == engineState::analysis);
 
 		if(!jsonIsOK)
 		{
@@ -190,7 +204,7 @@ void EngineRepresentation::process()
 			throw std::runtime_error("Malformed reply from engine!");
 		}
 
-		engineState typeRequest = engineStateFromString(json.get("typeRequest", "analysis").asString());
+		engineState typeRequest = message.hasType() ? message.state() : engineStateFromString(json.get("typeRequest", "analysis").asString());
 
 		switch(typeRequest)
 		{
@@ -208,6 +222,13 @@ void EngineRepresentation::process()
 		}
 	}
 
+	if (_engineState == engineState::idle)
+	{
+		if		(_stopRequested)	sendStopEngine();
+		else if	(_pauseRequested)	sendPauseEngine();
+		return;
+	}
+
 	if(_analysisAborted && _analysisInProgress && _abortTime + KILLTIME < Utils::currentSeconds()) //We wait a second or two before we kill the engine if it does not want to abort.
 	{
 		killEngine(true);
@@ -232,7 +253,7 @@ void EngineRepresentation::runScriptOnProcess(RFilterStore * filterStore)
 
 	Log::log() << "sending filter with requestID " << filterStore->requestId << " to engine" << std::endl;
 
-	sendString(json.toStyledString());
+	sendJson(json);
 }
 
 void EngineRepresentation::processFilterReply(Json::Value & json)
@@ -286,7 +307,7 @@ void EngineRepresentation::runScriptOnProcess(RScriptStore * scriptStore)
 
 	_lastRequestId			= scriptStore->requestId;
 
-	sendString(json.toStyledString());
+	sendJson(json);
 }
 
 
@@ -319,7 +340,7 @@ void EngineRepresentation::runScriptOnProcess(RComputeColumnStore * computeColum
 
 	_lastCompColName		= json["columnName"].asString();
 
-	sendString(json.toStyledString());
+	sendJson(json);
 }
 
 
@@ -353,7 +374,7 @@ void EngineRepresentation::runAnalysisOnProcess(Analysis *analysis)
 	Log::log() << "sending: " << json.toStyledString() << std::endl;
 #endif
 
-	_channel->send(json.toStyledString());
+	_channel->send(IPCMessage::encode(json));
 
 }
 
@@ -554,7 +575,7 @@ void EngineRepresentation::sendStopEngine()
 
 	Log::log() << "informing engine #" << channelNumber() << " that it ought to stop" << std::endl;
 
-	sendString(json.toStyledString());
+	sendJson(json);
 }
 
 void EngineRepresentation::restartEngine(QProcess * jaspEngineProcess)
@@ -570,7 +591,7 @@ void EngineRepresentation::restartEngine(QProcess * jaspEngineProcess)
 			Log::log() << "EngineRepresentation::restartEngine says: Engine already had jaspEngine process that is now replaced!" << std::endl;
 	}
 
-	sendString("");
+	_channel->discardReceived(); //What the previous jaspEngine sent but we didn't read yet, maybe even half a message
 	setSlaveProcess(jaspEngineProcess);
 	cleanUpAfterClose();
 
@@ -594,7 +615,7 @@ void EngineRepresentation::sendPauseEngine()
 
 	Log::log() << "informing engine #" << channelNumber() << " that it ought to pause for a bit" << std::endl;
 
-	sendString(json.toStyledString());
+	sendJson(json);
 }
 
 void EngineRepresentation::resumeEngine()
@@ -614,7 +635,7 @@ void EngineRepresentation::resumeEngine()
 
 	Log::log() << "informing engine #" << channelNumber() << " that it may resume." << std::endl;
 
-	sendString(json.toStyledString());
+	sendJson(json);
 }
 
 void EngineRepresentation::processEnginePausedReply()
@@ -647,7 +668,7 @@ void EngineRepresentation::runModuleRequestOnProcess(Json::Value request)
 	_engineState			= engineState::moduleRequest;
 	request["typeRequest"]	= engineStateToString(_engineState);
 
-	sendString(request.toStyledString());
+	sendJson(request);
 }
 
 void EngineRepresentation::processModuleRequestReply(Json::Value & json)
@@ -693,7 +714,7 @@ void EngineRepresentation::sendLogCfg()
 	Json::Value msg		= Log::createLogCfgMsg();
 	msg["typeRequest"]	= engineStateToString(_engineState);
 
-	sendString(msg.toStyledString());
+	sendJson(msg);
 }
 
 void EngineRepresentation::processLogCfgReply()
@@ -794,7 +815,7 @@ void EngineRepresentation::sendSettings()
 	Json::Value msg			= Json::objectValue;
 	msg["typeRequest"]		= engineStateToString(_engineState);
 	addSettingsToJson(msg);
-	sendString(msg.toStyledString());
+	sendJson(msg);
 
 	_settingsChanged = false;
 }
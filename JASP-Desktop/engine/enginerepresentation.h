@@ -83,7 +83,7 @@ public:
 
 	size_t	channelNumber()		const { return _channel->channelNumber(); }
 
-	void sendString(std::string str);
+	void sendJson(const Json::Value & json);
 
 	std::string currentState() const;
 
@@ -37,6 +37,7 @@
 #include "timers.h"
 #include "gui/preferencesmodel.h"
 #include "utilities/appdirs.h"
+#include "utilities/settings.h"
 #include "log.h"
 #include "utilities/qutils.h"
 
@@ -99,7 +100,9 @@ EngineRepresentation * EngineSync::createNewEngine()
 	{
 		size_t i = _engines.size();
 
-		_engines.push_back(new EngineRepresentation(new IPCChannel(_memoryName, i), startSlaveProcess(i), this));
+		size_t ringBytes = size_t(std::max(64, Settings::value(Settings::IPC_CHANNEL_KB).toInt())) * 1024;
+
+		_engines.push_back(new EngineRepresentation(new IPCChannel(_memoryName, i, false, ringBytes), startSlaveProcess(i), this));
 
 		connect(_engines[i],			&EngineRepresentation::rCodeReturned,					Analyses::analyses(),	&Analyses::rCodeReturned												);
 		connect(_engines[i],			&EngineRepresentation::engineTerminated,				this,					&EngineSync::engineTerminated											);
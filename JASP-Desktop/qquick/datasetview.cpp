@@ -4,6 +4,7 @@
 #include <QSGGeometry>
 #include <QSGNode>
 #include <queue>
+#include <algorithm>
 #include "timers.h"
 #include "log.h"
 #include "gui/preferencesmodel.h"
@@ -84,7 +85,12 @@ void DataSetView::setRolenames()
 
 QSizeF DataSetView::getColumnSize(int col)
 {
-	QString text = _model->headerData(col, Qt::Orientation::Horizontal, _roleNameToRole["maxColString"]).toString();
+	return getColumnSize(col, _roleNameToRole["maxColString"]);
+}
+
+QSizeF DataSetView::getColumnSize(int col, int maxColStringRole)
+{
+	QString text = _model->headerData(col, Qt::Orientation::Horizontal, maxColStringRole).toString();
 
 	return getTextSize(text);
 }
@@ -170,8 +176,10 @@ void DataSetView::calculateCellSizesAndClear(bool clearStorage)
 	_colXPositions.resize(_model->columnCount());
 	_cellTextItems.clear();
 
+	int maxColStringRole = _roleNameToRole["maxColString"];
+
 	for(int col=0; col<_model->columnCount(); col++)
-		_cellSizes[col] = getColumnSize(col);
+		_cellSizes[col] = getColumnSize(col, maxColStringRole);
 
 	_dataColsMaxWidth.resize(_model->columnCount());
 
@@ -248,22 +256,30 @@ void DataSetView::determineCurrentViewPortIndices()
 	QVector2D viewSize(_viewportW, _viewportH);
 	QVector2D rightBottom(leftTop + viewSize);
 
-	_currentViewportColMax = -1;
+	_currentViewportColMax = _model->columnCount();
 	_currentViewportColMin = -1;
 
-	float cumulative = 0;
-	for(int col=0; col<_model->columnCount() && _currentViewportColMax == -1; col++)
+	//The columns start at _colXPositions, which is sorted, so with tens of thousands of columns a binary search finds them instead of walking past all of them on every scroll
+	if(!_colXPositions.empty())
 	{
-		if(_currentViewportColMax == -1 && cumulative > rightBottom.x())						_currentViewportColMax = col;
+		double	base	= _colXPositions[0],
+				left	= base + leftTop.x(),
+				right	= base + rightBottom.x();
 
-		float prevCum = cumulative;
-		cumulative += _dataColsMaxWidth[col];
+		auto	afterRight	= std::upper_bound(_colXPositions.begin(), _colXPositions.end(), right),
+				beforeLeft	= std::lower_bound(_colXPositions.begin(), _colXPositions.end(), left);
 
-		if(_currentViewportColMin == -1 && cumulative > leftTop.x() && prevCum < leftTop.x())	_currentViewportColMin = col;
-	}
+		if(afterRight != _colXPositions.end())
+			_currentViewportColMax = int(afterRight - _colXPositions.begin());
 
-	if(_currentViewportColMax == -1)
-		_currentViewportColMax = _model->columnCount();
+		if(beforeLeft != _colXPositions.begin())
+		{
+			int col = int(beforeLeft - _colXPositions.begin()) - 1;
+
+			if(_colXPositions[col] + _dataColsMaxWidth[col] > left)
+				_currentViewportColMin = col;
+		}
+	}
 
 	_currentViewportColMin = std::max(0, std::min(_model->columnCount(),	_currentViewportColMin							- _viewportMargin));
 	_currentViewportColMax = std::max(0, std::min(_model->columnCount(),	_currentViewportColMax							+ _viewportMargin));
@@ -173,6 +173,7 @@ protected:
 
 	QSizeF getTextSize(const QString& text)	const;
 	QSizeF getColumnSize(int col);
+	QSizeF getColumnSize(int col, int maxColStringRole);
 	QSizeF getRowHeaderSize();
 
 protected:
@@ -46,7 +46,9 @@ const Settings::Setting Settings::Values[] = {
 	{"interfaceFont",				"SansSerif"},
 	{"codeFont",					"Fira Code"},
 	{"resultFont",					"\"Lucida Grande\",Helvetica,Arial,sans-serif,\"Helvetica Neue\",freesans,Segoe UI"},
-	{"win_LC_CTYPE_C",				"check" } //"check" should be an actual value in the underlying enum that is defined in preferencesmode.h
+	{"win_LC_CTYPE_C",				"check" }, //"check" should be an actual value in the underlying enum that is defined in preferencesmode.h
+	{"dataSetInMappedFile",			false}, //Keep the data in a file in the temp directory instead of in shared memory, for data sets larger than RAM
+	{"ipcChannelKB",				1024} //How much each direction of the channel to an engine can hold before the sender waits, see IPCChannel
 };
 
 QVariant Settings::value(Settings::Type key)
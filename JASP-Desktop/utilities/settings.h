@@ -51,7 +51,9 @@ public:
 		INTERFACE_FONT,
 		CODE_FONT,
 		RESULT_FONT,
-		LC_CTYPE_C_WIN
+		LC_CTYPE_C_WIN,
+		DATASET_IN_MAPPED_FILE,
+		IPC_CHANNEL_KB
 	};
 
 	static QVariant value(Settings::Type key);
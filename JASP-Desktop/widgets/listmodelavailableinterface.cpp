@@ -20,6 +20,7 @@
 #include "listmodelassignedinterface.h"
 #include "qmllistviewtermsavailable.h"
 #include "log.h"
+#include <QSet>
 
 void ListModelAvailableInterface::initTerms(const Terms &terms, const RowControlsOptions&)
 {
@@ -112,16 +113,25 @@ void ListModelAvailableInterface::sourceTermsChanged(const Terms* termsAdded, co
 
 void ListModelAvailableInterface::setChangedTerms(const Terms &newTerms)
 {
-	_tempRemovedTerms.clear();
-	_tempAddedTerms.clear();
+	//With wide data both have tens of thousands of terms, so they are looked up in a set instead of searched
+	QSet<Term>			newSet,
+						allSet;
+	std::vector<Term>	removed,
+						added;
+
+	for (const Term& term : newTerms)	newSet.insert(term);
+	for (const Term& term : _allTerms)	allSet.insert(term);
 
 	for (const Term& term : _allTerms)
-		if (!newTerms.contains(term))
-			_tempRemovedTerms.add(term);
+		if (!newSet.contains(term))
+			removed.push_back(term);
 
 	for (const Term& term : newTerms)
-		if (!_allTerms.contains(term))
-			_tempAddedTerms.add(term);
+		if (!allSet.contains(term))
+			added.push_back(term);
+
+	_tempRemovedTerms.set(removed);
+	_tempAddedTerms.set(added);
 }
 
 void ListModelAvailableInterface::removeTermsInAssignedList()
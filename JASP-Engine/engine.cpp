@@ -31,6 +31,7 @@
 #include "timers.h"
 #include "log.h"
 #include "columnencoder.h"
+#include "ipcmessage.h"
 
 void SendFunctionForJaspresults(const char * msg) { Engine::theEngine()->sendString(msg); }
 bool PollMessagesFunctionForJaspResults()
@@ -74,6 +75,7 @@ Engine::Engine(int slaveNo, unsigned long parentPID)
 	JASPTIMER_STOP(TempFiles Attach);
 
 	rbridge_setDataSetSource(			boost::bind(&Engine::provideDataSet,				this));
+	rbridge_setDataSetEpochSource(		boost::bind(&Engine::pinnedDataSetEpoch,			this));
 	rbridge_setFileNameSource(			boost::bind(&Engine::provideTempFileName,			this, _1, _2, _3));
 	rbridge_setSpecificFileNameSource(	boost::bind(&Engine::provideSpecificFileName,		this, _1, _2, _3));
 
@@ -109,6 +111,9 @@ void Engine::initialize()
 	//Is there maybe already some data? Like, if we just killed and restarted the engine
 	ColumnEncoder::columnEncoder()->setCurrentColumnNames(provideDataSet() == nullptr ? std::vector<std::string>({}) : provideDataSet()->getColumnNames());
 
+	if(provideDataSet())
+		provideDataSet()->versions().unpin(_slaveNo); //A previous incarnation of this engine might have crashed during an analysis and left its pin behind
+
 	_engineState = engineState::idle;
 	sendEngineResumed(); //Then the desktop knows we've finished init.
 	
@@ -132,7 +137,8 @@ void Engine::run()
 
 	JASPTIMER_STOP(Engine::run startup);
 
-	sendString(""); //Clear the buffer, because it might have been filled by a previous incarnation of the engine
+	//What a previous incarnation of the engine sent but the Desktop didn't read is dropped by EngineRepresentation::restartEngine
+	//and whatever the Desktop queued here already is meant for us, so the channel is used as it is.
 
 	while(_engineState != engineState::stopped && ProcessInfo::isParentRunning())
 	{
@@ -173,21 +179,24 @@ bool Engine::receiveMessages(int timeout)
 
 	if (_channel->receive(data, timeout))
 	{
-		if(data =="")
-			return false;
-
-		Json::Value jsonRequest;
-		Json::Reader().parse(data, jsonRequest, false);
+		Json::Value				jsonRequest;
+		IPCMessage::Decoded		message;
 
-		//Clear send buffer
-		sendString("");
+		try
+		{
+			message = IPCMessage::decode(data, jsonRequest);
+		}
+		catch(std::runtime_error & e)
+		{
+			Log::log() << "Engine::receiveMessages got something that is not an IPCMessage and ignores it: " << e.what() << std::endl;
+			return false;
+		}
 
-		//Check if we got anyting useful
-		std::string typeSend	= jsonRequest.get("typeRequest", Json::nullValue).asString();
-		if(typeSend == "")
+		//Check if we got anyting useful, the Desktop puts the typeRequest in the header as well
+		if(!message.parsed || !message.hasType())
 			return false;
 
-		engineState typeRequest = engineStateFromString(typeSend);
+		engineState typeRequest = message.state();
 
 #ifdef PRINT_ENGINE_MESSAGES
 		Log::log() << "Engine received " << engineStateToString(typeRequest) <<" message" << std::endl;
@@ -254,7 +263,7 @@ void Engine::sendFilterResult(int filterRequestId, const std::vector<bool> & fil
 	for(bool f : filterResult)	filterResponse["filterResult"].append(f);
 	if(warning != "")			filterResponse["filterError"] = warning;
 
-	sendString(filterResponse.toStyledString());
+	sendJson(filterResponse);
 }
 
 void Engine::sendFilterError(int filterRequestId, const std::string & errorMessage)
@@ -265,7 +274,7 @@ void Engine::sendFilterError(int filterRequestId, const std::string & errorMessa
 	filterResponse["filterError"]	= errorMessage;
 	filterResponse["requestId"]		= filterRequestId;
 
-	sendString(filterResponse.toStyledString());
+	sendJson(filterResponse);
 }
 
 void Engine::receiveRCodeMessage(const Json::Value & jsonRequest)
@@ -339,7 +348,7 @@ void Engine::sendRCodeResult(const std::string & rCodeResult, int rCodeRequestId
 	rCodeResponse["requestId"]		= rCodeRequestId;
 
 
-	sendString(rCodeResponse.toStyledString());
+	sendJson(rCodeResponse);
 }
 
 void Engine::sendRCodeError(int rCodeRequestId)
@@ -352,7 +361,7 @@ void Engine::sendRCodeError(int rCodeRequestId)
 	rCodeResponse["rCodeError"]		= RError.size() == 0 ? "R Code failed for unknown reason. Check that R function returns a string." : RError;
 	rCodeResponse["requestId"]		= rCodeRequestId;
 
-	sendString(rCodeResponse.toStyledString());
+	sendJson(rCodeResponse);
 }
 
 void Engine::receiveComputeColumnMessage(const Json::Value & jsonRequest)
@@ -383,16 +392,18 @@ void Engine::runComputeColumn(const std::string & computeColumnName, const std::
 		{columnType::nominal,		".setColumnDataAsNominal"		},
 		{columnType::nominalText,	".setColumnDataAsNominalText"	}};
 
+	_columnWriteError = "";
+
 	std::string computeColumnCodeComplete	= "local({;calcedVals <- {"+computeColumnCode +"};\n"  "return(toString(" + setColumnFunction.at(computeColumnType) + "('" + computeColumnName +"', calcedVals)));})";
 	std::string computeColumnResultStr		= rbridge_evalRCodeWhiteListed(computeColumnCodeComplete);
 
 	Json::Value computeColumnResponse		= Json::objectValue;
 	computeColumnResponse["typeRequest"]	= engineStateToString(engineState::computeColumn);
 	computeColumnResponse["result"]			= computeColumnResultStr;
-	computeColumnResponse["error"]			= jaspRCPP_getLastErrorMsg();
+	computeColumnResponse["error"]			= _columnWriteError != "" ? _columnWriteError : jaspRCPP_getLastErrorMsg();
 	computeColumnResponse["columnName"]		= computeColumnName;
 
-	sendString(computeColumnResponse.toStyledString());
+	sendJson(computeColumnResponse);
 
 	_engineState = engineState::idle;
 }
@@ -416,7 +427,7 @@ void Engine::receiveModuleRequestMessage(const Json::Value & jsonRequest)
 	jsonAnswer["error"]				= jaspRCPP_getLastErrorMsg();
 	jsonAnswer["typeRequest"]		= engineStateToString(engineState::moduleRequest);
 
-	sendString(jsonAnswer.toStyledString());
+	sendJson(jsonAnswer);
 
 	_engineState = engineState::idle;
 }
@@ -532,17 +543,29 @@ void Engine::sendString(std::string message)
 {
 	Utils::convertEscapedUnicodeToUTF8(message);
 
+#ifdef JASP_COLUMN_ENCODE_ALL
 	Json::Value msgJson;
 
 	if(Json::Reader().parse(message, msgJson)) //If everything is converted to jaspResults maybe we can do this there?
 	{
-#ifdef JASP_COLUMN_ENCODE_ALL
 		ColumnEncoder::columnEncoder()->decodeJson(msgJson); // decode all columnnames as far as you can
-#endif
-		_channel->send(msgJson.toStyledString());
+		_channel->send(IPCMessage::encode(msgJson));
+		return;
 	}
-	else
-		_channel->send(message);
+#endif
+
+	_channel->send(IPCMessage::encode(message)); //The json from R goes as it is, the Desktop parses it anyway
+}
+
+void Engine::sendJson(const Json::Value & json)
+{
+#ifdef JASP_COLUMN_ENCODE_ALL
+	Json::Value msgJson(json);
+	ColumnEncoder::columnEncoder()->decodeJson(msgJson); // decode all columnnames as far as you can
+	_channel->send(IPCMessage::encode(msgJson));
+#else
+	_channel->send(IPCMessage::encode(json));
+#endif
 }
 
 
@@ -573,10 +596,14 @@ void Engine::runAnalysis()
 
 	Log::log() << "Analysis will be run now." << std::endl;
 
+	pinDataSet(); //The Desktop may change columns while we run, we keep reading the version of the data we started with
+
 	_analysisResultsString = _dynamicModuleCall != "" ?
 			rbridge_runModuleCall(_analysisName, _analysisTitle, _dynamicModuleCall, _analysisDataKey, _analysisOptions, _analysisStateKey, perform, _ppi, _analysisId, _analysisRevision, _imageBackground, _developerMode)
 		:	rbridge_run(_analysisName, _analysisTitle, _analysisRFile, _analysisRequiresInit, _analysisDataKey, _analysisOptions, _analysisResultsMeta, _analysisStateKey, _analysisId, _analysisRevision, perform, _ppi, _imageBackground, callback, _analysisJaspResults, _developerMode);
 
+	unpinDataSet();
+
 	if (!_analysisJaspResults && (_analysisStatus == Status::initing || _analysisStatus == Status::running))  // if status hasn't changed
 		receiveMessages();
 
@@ -695,7 +722,7 @@ void Engine::sendAnalysisResults()
 	response["results"] = _analysisResults.get("results", _analysisResults);
 	response["status"]  = analysisResultStatusToString(resultStatus);
 
-	sendString(response.toStyledString());
+	sendJson(response);
 }
 
 void Engine::removeNonKeepFiles(const Json::Value & filesToKeepValue)
@@ -734,6 +761,21 @@ DataSet * Engine::provideDataSet()
 	return dataset;
 }
 
+void Engine::pinDataSet()
+{
+	_pinnedDataSet	= provideDataSet();
+	_pinnedEpoch	= _pinnedDataSet ? _pinnedDataSet->versions().pin(_slaveNo) : DataSetVersions::UNPINNED;
+}
+
+void Engine::unpinDataSet()
+{
+	if(_pinnedDataSet)
+		_pinnedDataSet->versions().unpin(_slaveNo);
+
+	_pinnedDataSet	= nullptr;
+	_pinnedEpoch	= DataSetVersions::UNPINNED;
+}
+
 void Engine::provideStateFileName(std::string & root, std::string & relativePath)
 {
 	return TempFiles::createSpecific("state", _analysisId, root, relativePath);
@@ -837,14 +879,38 @@ bool Engine::setColumnDataAsNominalOrOrdinal(bool isOrdinal, const std::string &
 			if(dat != INT_MIN)
 				dat = uniqueInts[dat];
 
-		if(isOrdinal)	return	provideDataSet()->columns()[columnName].overwriteDataWithOrdinal(data);
-		else			return	provideDataSet()->columns()[columnName].overwriteDataWithNominal(data);
+		return writeColumn(columnName, [&](Column & column) { return isOrdinal ? column.overwriteDataWithOrdinal(data) : column.overwriteDataWithNominal(data); });
 	}
 	else
+		return writeColumn(columnName, [&](Column & column) { return isOrdinal ? column.overwriteDataWithOrdinal(data, levels) : column.overwriteDataWithNominal(data, levels); });
+}
+
+bool Engine::writeColumn(const std::string & columnName, std::function<bool(Column & column)> write)
+{
+	if(!isColumnNameOk(columnName))
+		return false;
+
+	DataSet	*	dataSet = provideDataSet();
+	bool		changed;
+
+	try
 	{
-		if(isOrdinal)	return	provideDataSet()->columns()[columnName].overwriteDataWithOrdinal(data, levels);
-		else			return	provideDataSet()->columns()[columnName].overwriteDataWithNominal(data, levels);
+		DataSet::ColumnWrite columnWrite(*dataSet, dataSet->column(columnName));
+		changed = write(dataSet->column(columnName));
 	}
+	catch(boost::interprocess::bad_alloc &)
+	{
+		//Only the Desktop can grow the segment, the engine can just say so instead of letting it crash on its way back through R
+		_columnWriteError = "There was not enough room in the shared memory to write column '" + columnName + "', please try again.";
+		Log::log() << _columnWriteError << std::endl;
+		return false;
+	}
+
+	//The analysis that wrote the column should also read what it wrote, so its pin moves along to this commit
+	if(_pinnedDataSet == dataSet)
+		_pinnedEpoch = dataSet->versions().pin(_slaveNo);
+
+	return changed;
 }
 
 void Engine::stopEngine()
@@ -862,6 +928,7 @@ void Engine::stopEngine()
 	_engineState = engineState::stopped;
 
 	freeRBridgeColumns();
+	unpinDataSet();
 	SharedMemory::unloadDataSet();
 	sendEngineStopped();
 }
@@ -870,7 +937,7 @@ void Engine::sendEngineStopped()
 {
 	Json::Value rCodeResponse		= Json::objectValue;
 	rCodeResponse["typeRequest"]	= engineStateToString(_engineState);
-	sendString(rCodeResponse.toStyledString());
+	sendJson(rCodeResponse);
 }
 
 void Engine::pauseEngine()
@@ -888,6 +955,7 @@ void Engine::pauseEngine()
 	_engineState = engineState::paused;
 
 	freeRBridgeColumns();
+	unpinDataSet();
 	SharedMemory::unloadDataSet();
 	sendEnginePaused();
 }
@@ -897,14 +965,18 @@ void Engine::sendEnginePaused()
 	Json::Value rCodeResponse		= Json::objectValue;
 	rCodeResponse["typeRequest"]	= engineStateToString(engineState::paused);
 
-	sendString(rCodeResponse.toStyledString());
+	sendJson(rCodeResponse);
 }
 
 void Engine::resumeEngine(const Json::Value & jsonRequest)
 {
 	Log::log() << "Engine resuming, absorbing settings and rescanning columnNames for en/decoding" << std::endl;
 	//Any changes to the data that engine needs to know about are accompanied by pause + resume I think.
-	ColumnEncoder::columnEncoder()->setCurrentColumnNames(provideDataSet() == nullptr ? std::vector<std::string>({}) : provideDataSet()->getColumnNames());
+	//The column names only need to be rescanned if the log of changes in the DataSet says columns were added, removed or renamed.
+	DataSet * dataSet = provideDataSet();
+
+	if(dataSet == nullptr || dataSet->changes().columnsChangedSince(_columnNamesSeen))
+		ColumnEncoder::columnEncoder()->setCurrentColumnNames(dataSet == nullptr ? std::vector<std::string>({}) : dataSet->getColumnNames());
 
 	absorbSettings(jsonRequest);
 
@@ -918,7 +990,7 @@ void Engine::sendEngineResumed()
 	Json::Value rCodeResponse		= Json::objectValue;
 	rCodeResponse["typeRequest"]	= engineStateToString(engineState::resuming);
 
-	sendString(rCodeResponse.toStyledString());	
+	sendJson(rCodeResponse);	
 }
 
 void Engine::receiveLogCfg(const Json::Value & jsonRequest)
@@ -930,7 +1002,7 @@ void Engine::receiveLogCfg(const Json::Value & jsonRequest)
 	Json::Value logCfgResponse		= Json::objectValue;
 	logCfgResponse["typeRequest"]	= engineStateToString(engineState::logCfg);
 
-	sendString(logCfgResponse.toStyledString());
+	sendJson(logCfgResponse);
 
 	_engineState = engineState::idle;
 }
@@ -955,7 +1027,7 @@ void Engine::receiveSettings(const Json::Value & jsonRequest)
 	Json::Value response	= Json::objectValue;
 	response["typeRequest"]	= engineStateToString(engineState::settings);
 
-	sendString(response.toStyledString());
+	sendJson(response);
 
 	_engineState = engineState::idle;
 }
@@ -23,6 +23,7 @@
 #include "ipcchannel.h"
 #include "processinfo.h"
 #include "jsonredirect.h"
+#include <functional>
 
 /* The Engine represents the background processes.
  * It can be in a variety of states _currentEngineState and can run analyses, filters, compute columns and Rcode.
@@ -39,7 +40,8 @@ public:
 	bool receiveMessages(int timeout = 0);
 	void setSlaveNo(int no);
 	int	 slaveNo() const { return _slaveNo; }
-	void sendString(std::string message);
+	void sendString(std::string message);	///< For json that is a string already, like what comes from R
+	void sendJson(const Json::Value & json);
 
 
 	typedef engineAnalysisStatus Status;
@@ -49,16 +51,19 @@ public:
 	int  getColumnType(const std::string & columnName) { return int(!isColumnNameOk(columnName) ? columnType::unknown : provideDataSet()->column(columnName).getColumnType()); }
 
 	//return true if changed:
-	bool setColumnDataAsScale(		const std::string & columnName, const	std::vector<double>			& scalarData)												{	if(!isColumnNameOk(columnName)) return false; return provideDataSet()->columns()[columnName].overwriteDataWithScale(scalarData);				}
+	bool setColumnDataAsScale(		const std::string & columnName, const	std::vector<double>			& scalarData)												{	return writeColumn(columnName, [&](Column & column) { return column.overwriteDataWithScale(scalarData); });			}
 	bool setColumnDataAsOrdinal(	const std::string & columnName,			std::vector<int>			& ordinalData, const std::map<int, std::string> & levels)	{	if(!isColumnNameOk(columnName)) return false; return setColumnDataAsNominalOrOrdinal(true,  columnName, ordinalData, levels);					}
 	bool setColumnDataAsNominal(	const std::string & columnName,			std::vector<int>			& nominalData, const std::map<int, std::string> & levels)	{	if(!isColumnNameOk(columnName)) return false; return setColumnDataAsNominalOrOrdinal(false, columnName, nominalData, levels);					}
-	bool setColumnDataAsNominalText(const std::string & columnName, const	std::vector<std::string>	& nominalData)												{	if(!isColumnNameOk(columnName)) return false; return provideDataSet()->columns()[columnName].overwriteDataWithNominal(nominalData);			}
+	bool setColumnDataAsNominalText(const std::string & columnName, const	std::vector<std::string>	& nominalData)												{	return writeColumn(columnName, [&](Column & column) { return column.overwriteDataWithNominal(nominalData); });		}
 
 	bool isColumnNameOk(std::string columnName);
 
 	bool setColumnDataAsNominalOrOrdinal(bool isOrdinal, const std::string & columnName, std::vector<int> & data, const std::map<int, std::string> & levels);
+	bool writeColumn(const std::string & columnName, std::function<bool(Column & column)> write); ///< Through a DataSet::ColumnWrite, returns false when the column doesn't exist or there was no room to write it
 
-	int dataSetRowCount()	{ return static_cast<int>(provideDataSet()->rowCount()); }
+	size_t dataSetRowCount()	{ return provideDataSet()->rowCount(); }
+
+	DataSetVersions::Epoch pinnedDataSetEpoch() const { return _pinnedEpoch; } ///< The version of the data the running analysis reads, see DataSetVersions
 
 	bool paused() { return _engineState == engineState::paused; }
 
@@ -103,6 +108,8 @@ private: // Methods:
 	std::string callback(const std::string &results, int progress);
 
 	DataSet *provideDataSet();
+	void pinDataSet();
+	void unpinDataSet();
 
 	void provideTempFileName(		const std::string & extension,		std::string & root,	std::string & relativePath);
 	void provideStateFileName(											std::string & root,	std::string & relativePath);
@@ -118,6 +125,11 @@ private: // Data:
 	const unsigned long	_parentPID = 0;
 	engineState			_engineState = engineState::initializing;
 
+	DataSet			*	_pinnedDataSet	= nullptr;
+	DataSetVersions::Epoch	_pinnedEpoch	= DataSetVersions::UNPINNED;
+	std::string				_columnWriteError;	///< Why the last column could not be written, see writeColumn
+	DataSetChanges::Version	_columnNamesSeen	= 0;
+
 	Status				_analysisStatus = Status::empty;
 
 	int					_analysisId,
@@ -19,6 +19,7 @@
 #include "columnencoder.h"
 #include "jsonredirect.h"
 #include "sharedmemory.h"
+#include "columndescriptives.h"
 #include "appinfo.h"
 #include "tempfiles.h"
 #include "log.h"
@@ -34,6 +35,7 @@ ColumnEncoder					extraEncodings("JaspExtraOptions_.");
 
 //You cannot replace these NULL's by nullptr because then the compiler will complain about expressions that cannot be used as functions
 boost::function<DataSet *()>				rbridge_dataSetSource		= NULL;
+boost::function<DataSetVersions::Epoch()>	rbridge_dataSetEpochSource	= NULL;
 boost::function<size_t()>					rbridge_getDataSetRowCount	= NULL;
 boost::function<int(const std::string &)>	rbridge_getColumnTypeEngine = NULL;
 
@@ -88,7 +90,8 @@ void rbridge_init(sendFuncDef sendToDesktopFunction, pollMessagesFuncDef pollMes
 		rbridge_encodeColumnName,
 		rbridge_decodeColumnName,
 		rbridge_encodeAllColumnNames,
-		rbridge_decodeAllColumnNames
+		rbridge_decodeAllColumnNames,
+		rbridge_readColumnDescriptives
 	};
 
 	JASPTIMER_START(jaspRCPP_init);
@@ -106,6 +109,7 @@ void rbridge_init(sendFuncDef sendToDesktopFunction, pollMessagesFuncDef pollMes
 }
 
 void rbridge_setDataSetSource(			boost::function<DataSet* ()> source)												{	rbridge_dataSetSource			= source; }
+void rbridge_setDataSetEpochSource(		boost::function<DataSetVersions::Epoch()> source)									{	rbridge_dataSetEpochSource		= source; }
 void rbridge_setFileNameSource(			boost::function<void (const std::string &, std::string &, std::string &)> source)	{	rbridge_fileNameSource			= source; }
 void rbridge_setSpecificFileNameSource(	boost::function<void (const std::string &, std::string &, std::string &)> source)	{	rbridge_specificFileNameSource	= source; }
 void rbridge_setStateFileSource(		boost::function<void (std::string &, std::string &)> source)						{	rbridge_stateFileSource			= source; }
@@ -124,7 +128,7 @@ void rbridge_setColumnFunctionSources(			boost::function<int (const std::string
 	rbridge_setColumnDataAsNominalTextEngine	= nominalTextSource;
 }
 
-void rbridge_setGetDataSetRowCountSource(boost::function<int()> source)	{	rbridge_getDataSetRowCount = source;	}
+void rbridge_setGetDataSetRowCountSource(boost::function<size_t()> source)	{	rbridge_getDataSetRowCount = source;	}
 
 extern "C" const char * STDCALL rbridge_encodeColumnName(const char * in)
 {
@@ -289,14 +293,19 @@ extern "C" RBridgeColumn* STDCALL rbridge_readFullDataSetHelper(size_t * colMax,
 	(*colMax) = columns.columnCount();
 	RBridgeColumnType* colHeaders = (RBridgeColumnType*)calloc((*colMax), sizeof(RBridgeColumnType));
 
-	for(int i=0; i<(*colMax); i++)
 	{
+		DataSetVersions::ReadLock	readLock(rbridge_dataSet->versions().mutex());
+		DataSetVersions::Epoch		epoch = rbridge_dataSetEpochSource();
+
+		for(int i=0; i<(*colMax); i++)
+		{
 #ifdef JASP_COLUMN_ENCODE_ALL
-		colHeaders[i].name = strdup(ColumnEncoder::columnEncoder()->encode(columns[i].name()).c_str());
+			colHeaders[i].name = strdup(ColumnEncoder::columnEncoder()->encode(columns[i].name()).c_str());
 #else
-		colHeaders[i].name = strdup(columns[i].name().c_str());
+			colHeaders[i].name = strdup(columns[i].name().c_str());
 #endif
-		colHeaders[i].type = (int)columns[i].getColumnType();
+			colHeaders[i].type = (int)columns[i].version(rbridge_dataSet->versions().readEpoch(epoch)).getColumnType();
+		}
 	}
 
 	RBridgeColumn * returnThis = rbridge_readDataSet(colHeaders, (*colMax), obeyFilter);
@@ -322,18 +331,23 @@ extern "C" RBridgeColumn* STDCALL rbridge_readDataSetForFiltering(size_t * colMa
 
 	RBridgeColumnType* colHeaders = (RBridgeColumnType*)calloc((*colMax), sizeof(RBridgeColumnType));
 
-	for(size_t iIn=0, iOut=0; iIn < columns.columnCount() && iOut < filterColumnsUsed.size(); iIn++)
-		if(filterColumnsUsed.count(columns[iIn].name()) > 0)
-		{
+	{
+		DataSetVersions::ReadLock	readLock(rbridge_dataSet->versions().mutex());
+		DataSetVersions::Epoch		epoch = rbridge_dataSetEpochSource();
+
+		for(size_t iIn=0, iOut=0; iIn < columns.columnCount() && iOut < filterColumnsUsed.size(); iIn++)
+			if(filterColumnsUsed.count(columns[iIn].name()) > 0)
+			{
 #ifdef JASP_COLUMN_ENCODE_ALL
-			colHeaders[iOut].name = strdup(ColumnEncoder::columnEncoder()->encode(columns[iIn].name()).c_str());
+				colHeaders[iOut].name = strdup(ColumnEncoder::columnEncoder()->encode(columns[iIn].name()).c_str());
 #else
-			colHeaders[iOut].name = strdup(columns[iIn].name().c_str());
+				colHeaders[iOut].name = strdup(columns[iIn].name().c_str());
 #endif
-			colHeaders[iOut].type = (int)columns[iIn].getColumnType();
+				colHeaders[iOut].type = (int)columns[iIn].version(rbridge_dataSet->versions().readEpoch(epoch)).getColumnType();
 
-			iOut++;
-		}
+				iOut++;
+			}
+	}
 
 	RBridgeColumn * returnThis = rbridge_readDataSet(colHeaders, (*colMax), false);
 
@@ -347,17 +361,12 @@ extern "C" RBridgeColumn* STDCALL rbridge_readDataSetForFiltering(size_t * colMa
 static RBridgeColumn*	datasetStatic = nullptr;
 static int				datasetColMax = 0;
 
-extern "C" RBridgeColumn* STDCALL rbridge_readDataSet(RBridgeColumnType* colHeaders, size_t colMax, bool obeyFilter)
+///Fills datasetStatic with the requested columns of rbridge_dataSet, anything that goes wrong is thrown
+static RBridgeColumn* rbridge_copyDataSet(RBridgeColumnType* colHeaders, size_t colMax, bool obeyFilter)
 {
-	if (colHeaders == nullptr)
-		return nullptr;
-
-	rbridge_dataSet = rbridge_dataSetSource();
-
-	if(rbridge_dataSet == nullptr)
-		return nullptr;
-
-	Columns &columns = rbridge_dataSet->columns();
+	//The Desktop might be writing a column meanwhile, the lock keeps the versions we read from alive until we copied them.
+	DataSetVersions::ReadLock	readLock(rbridge_dataSet->versions().mutex());
+	DataSetVersions::Epoch		epoch = rbridge_dataSetEpochSource();
 
 	if (datasetStatic != nullptr)
 		freeRBridgeColumns();
@@ -365,17 +374,37 @@ extern "C" RBridgeColumn* STDCALL rbridge_readDataSet(RBridgeColumnType* colHead
 	datasetColMax = colMax;
 	datasetStatic = static_cast<RBridgeColumn*>(calloc(datasetColMax + 1, sizeof(RBridgeColumn)));
 
-	size_t filteredRowCount = obeyFilter ? rbridge_dataSet->filteredRowCount() : rbridge_dataSet->rowCount();
+	//Every column gathers the same rows, so work them out once. If everything passes anyway the rows are simply read in order.
+	const FilterBitmap	&	filter		= rbridge_dataSet->filter();
+	bool					gather		= obeyFilter && !filter.allPass();
+	std::vector<size_t>		passingRows;
+
+	if(gather)
+		filter.passingRows(passingRows);
+
+	size_t filteredRowCount = gather ? passingRows.size() : rbridge_dataSet->rowCount();
+
+	if(filteredRowCount > INT_MAX)
+	{
+		//An R data.frame can't have more rows than that, so only the row count is passed on and jaspRCPP tells R why there is no data
+		datasetStatic[colMax].nbRows = filteredRowCount;
+		return datasetStatic;
+	}
+
+	//Reads row i of the filtered data out of values, which has all the rows
+	auto filteredRow = [&](size_t i) { return gather ? passingRows[i] : i; };
+
+	//Copies the filtered rows of a column into out in one go
+	auto readFilteredInts		= [&](const Column & column, int	* out) { if(gather) column.gatherInto(out, passingRows); else column.readInto(out, 0, filteredRowCount); };
+	auto readFilteredDoubles	= [&](const Column & column, double	* out) { if(gather) column.gatherInto(out, passingRows); else column.readInto(out, 0, filteredRowCount); };
 
 	// lets make some rownumbers/names for R that takes into account being filtered or not!
 	datasetStatic[colMax].ints		= filteredRowCount == 0 ? nullptr : static_cast<int*>(calloc(filteredRowCount, sizeof(int)));
 	datasetStatic[colMax].nbRows	= filteredRowCount;
-	int filteredRow					= 0;
 
 	//If you change anything here, make sure that "label outliers" in Descriptives still works properly (including with filters)
-	for(size_t i=0; i<rbridge_dataSet->rowCount() && filteredRow < datasetStatic[colMax].nbRows; i++)
-		if(!obeyFilter || (rbridge_dataSet->filterVector().size() > i && rbridge_dataSet->filterVector()[i]))
-			datasetStatic[colMax].ints[filteredRow++] = int(i + 1); //R needs 1-based index
+	for(size_t i=0; i<filteredRowCount; i++)
+		datasetStatic[colMax].ints[i] = int(filteredRow(i) + 1); //R needs 1-based index
 
 	//std::cout << "reading " << colMax << " columns!\nRowCount: " << filteredRowCount << "" << std::endl;
 
@@ -390,16 +419,17 @@ extern "C" RBridgeColumn* STDCALL rbridge_readDataSet(RBridgeColumnType* colHead
 		std::string				columnName		= columnInfo.name;
 								resultCol.name	= strdup(ColumnEncoder::columnEncoder()->encode(columnName).c_str());
 #endif
-		Column				&	column			= columns.get(columnName);
+		const Column		&	column			= rbridge_dataSet->columnVersion(columnName, epoch);
 		columnType				colType			= column.getColumnType(),
 								requestedType	= columnType(columnInfo.type);
 
 		if (requestedType == columnType::unknown)
 			requestedType = colType;
 
-		//int rowCount = column.rowCount();
+		if(column.rowCount() < rbridge_dataSet->rowCount())
+			throw std::runtime_error("Column '" + columnName + "' has fewer rows than the data set");
+
 		resultCol.nbRows = filteredRowCount;
-		int rowNo = 0, dataSetRowNo = 0;
 
 		if (requestedType == columnType::scale)
 		{
@@ -409,9 +439,7 @@ extern "C" RBridgeColumn* STDCALL rbridge_readDataSet(RBridgeColumnType* colHead
 				resultCol.hasLabels	= false;
 				resultCol.doubles	= (double*)calloc(filteredRowCount, sizeof(double));
 
-				for(double value : column.AsDoubles)
-					if(rowNo < filteredRowCount && (!obeyFilter || rbridge_dataSet->filterVector()[dataSetRowNo++]))
-						resultCol.doubles[rowNo++] = value;
+				readFilteredDoubles(column, resultCol.doubles);
 			}
 			else if (colType == columnType::ordinal || colType == columnType::nominal)
 			{
@@ -419,9 +447,7 @@ extern "C" RBridgeColumn* STDCALL rbridge_readDataSet(RBridgeColumnType* colHead
 				resultCol.hasLabels	= false;
 				resultCol.ints		= filteredRowCount == 0 ? nullptr : static_cast<int*>(calloc(filteredRowCount, sizeof(int)));
 
-				for(int value : column.AsInts)
-					if(rowNo < filteredRowCount && (!obeyFilter || rbridge_dataSet->filterVector()[dataSetRowNo++]))
-						resultCol.ints[rowNo++] = value;
+				readFilteredInts(column, resultCol.ints);
 			}
 			else // columnType == ColumnType::nominalText
 			{
@@ -430,12 +456,7 @@ extern "C" RBridgeColumn* STDCALL rbridge_readDataSet(RBridgeColumnType* colHead
 				resultCol.isOrdinal = false;
 				resultCol.ints		= filteredRowCount == 0 ? nullptr : static_cast<int*>(calloc(filteredRowCount, sizeof(int)));
 
-				for(int value : column.AsInts)
-					if(rowNo < filteredRowCount && (!obeyFilter || rbridge_dataSet->filterVector()[dataSetRowNo++]))
-					{
-						if (value == INT_MIN)	resultCol.ints[rowNo++] = INT_MIN;
-						else					resultCol.ints[rowNo++] = value;
-					}
+				readFilteredInts(column, resultCol.ints);
 
 				resultCol.labels = rbridge_getLabels(column.labels(), resultCol.nbLabels);
 			}
@@ -449,20 +470,19 @@ extern "C" RBridgeColumn* STDCALL rbridge_readDataSet(RBridgeColumnType* colHead
 
 			if (colType != columnType::scale)
 			{
-				std::map<int, int> indices;
-				int i = 1; // R starts indices from 1
-
 				const Labels &labels = column.labels();
 
-				for(const Label &label : labels)
-					indices[label.value()] = i++;
+				readFilteredInts(column, resultCol.ints);
 
-				for(int value : column.AsInts)
-					if(rowNo < filteredRowCount && (!obeyFilter || rbridge_dataSet->filterVector()[dataSetRowNo++]))
-					{
-						if (value == INT_MIN)	resultCol.ints[rowNo++] = INT_MIN;
-						else					resultCol.ints[rowNo++] = indices.at(value);
-					}
+				for(size_t i = 0; i < filteredRowCount; i++)
+				{
+					int value		= resultCol.ints[i],
+						labelRow	= value == INT_MIN ? -1 : labels.getRowFromKey(value);
+
+					if (value == INT_MIN)	resultCol.ints[i] = INT_MIN;
+					else if (labelRow < 0)	throw labelNotFound("Value " + std::to_string(value) + " in column '" + column.name() + "' has no label");
+					else					resultCol.ints[i] = labelRow + 1; // R starts indices from 1
+				}
 
 				resultCol.labels = rbridge_getLabels(labels, resultCol.nbLabels);
 			}
@@ -476,8 +496,19 @@ extern "C" RBridgeColumn* STDCALL rbridge_readDataSet(RBridgeColumnType* colHead
 
 				std::set<int> uniqueValues;
 
-				for(double value : column.AsDoubles)
+				std::vector<double>	copiedValues;
+				const double	*	allValues = column.doubleValues(); //Not AsDoubles, that would give a column that shares its values a copy of them
+
+				if(allValues == nullptr) //Not stored as doubles, so read them out instead
+				{
+					copiedValues.resize(column.rowCount());
+					column.readInto(copiedValues.data(), 0, copiedValues.size());
+					allValues = copiedValues.data();
+				}
+
+				for(size_t row = 0; row < column.rowCount(); row++)
 				{
+					double value = allValues[row];
 
 					if (std::isnan(value))
 						continue;
@@ -509,17 +540,18 @@ extern "C" RBridgeColumn* STDCALL rbridge_readDataSet(RBridgeColumnType* colHead
 					}
 				}
 
-				for(double value : column.AsDoubles)
-					if(rowNo < filteredRowCount && (!obeyFilter || rbridge_dataSet->filterVector()[dataSetRowNo++]))
-					{
+				std::vector<double> values(filteredRowCount);
+				readFilteredDoubles(column, values.data());
 
-						if (std::isnan(value))			resultCol.ints[rowNo] = INT_MIN;
-						else if (std::isfinite(value))	resultCol.ints[rowNo] = valueToIndex[(int)(value * 1000)] + 1;
-						else if (value > 0)				resultCol.ints[rowNo] = valueToIndex[INT_MAX] + 1;
-						else							resultCol.ints[rowNo] = valueToIndex[INT_MIN] + 1;
+				for(size_t i = 0; i < filteredRowCount; i++)
+				{
+					double value = values[i];
 
-						rowNo++;
-					}
+					if (std::isnan(value))			resultCol.ints[i] = INT_MIN;
+					else if (std::isfinite(value))	resultCol.ints[i] = valueToIndex[(int)(value * 1000)] + 1;
+					else if (value > 0)				resultCol.ints[i] = valueToIndex[INT_MAX] + 1;
+					else							resultCol.ints[i] = valueToIndex[INT_MIN] + 1;
+				}
 
 				resultCol.labels = rbridge_getLabels(labels, resultCol.nbLabels);
 			}
@@ -529,6 +561,28 @@ extern "C" RBridgeColumn* STDCALL rbridge_readDataSet(RBridgeColumnType* colHead
 	return datasetStatic;
 }
 
+extern "C" RBridgeColumn* STDCALL rbridge_readDataSet(RBridgeColumnType* colHeaders, size_t colMax, bool obeyFilter)
+{
+	if (colHeaders == nullptr)
+		return nullptr;
+
+	rbridge_dataSet = rbridge_dataSetSource();
+
+	if(rbridge_dataSet == nullptr)
+		return nullptr;
+
+	try
+	{
+		return rbridge_copyDataSet(colHeaders, colMax, obeyFilter);
+	}
+	catch(std::exception & e) //Nothing may get thrown through R, it gets no data instead
+	{
+		Log::log() << "rbridge_readDataSet failed: " << e.what() << std::endl;
+		freeRBridgeColumns();
+		return nullptr;
+	}
+}
+
 extern "C" char** STDCALL rbridge_readDataColumnNames(size_t * colMax)
 {
 					rbridge_dataSet = rbridge_dataSetSource();
@@ -579,7 +633,9 @@ extern "C" RBridgeColumnDescription* STDCALL rbridge_readDataSetDescription(RBri
 	lastColMax			= colMax;
 	resultCols			= static_cast<RBridgeColumnDescription*>(calloc(colMax, sizeof(RBridgeColumnDescription)));
 	rbridge_dataSet		= rbridge_dataSetSource();
-	Columns &columns	= rbridge_dataSet->columns();
+
+	DataSetVersions::ReadLock	readLock(rbridge_dataSet->versions().mutex());
+	DataSetVersions::Epoch		epoch = rbridge_dataSetEpochSource();
 
 	for (int colNo = 0; colNo < colMax; colNo++)
 	{
@@ -592,7 +648,7 @@ extern "C" RBridgeColumnDescription* STDCALL rbridge_readDataSetDescription(RBri
 		std::string						columnName		= columnInfo.name;
 										resultCol.name	= strdup(ColumnEncoder::columnEncoder()->encode(columnInfo.name).c_str());
 #endif
-		Column						&	column			= columns.get(columnName);
+		const Column				&	column			= rbridge_dataSet->columnVersion(columnName, epoch);
 		columnType						colType			= column.getColumnType(),
 										requestedType	= columnType(columnInfo.type);
 
@@ -621,8 +677,12 @@ extern "C" RBridgeColumnDescription* STDCALL rbridge_readDataSetDescription(RBri
 				// scale to nominal or ordinal (doesn't really make sense, but we have to do something)
 				std::set<int> uniqueValues;
 
-				for (double value: column.AsDoubles)
+				const double * values = column.doubleValues();
+
+				for (size_t row = 0; row < column.rowCount(); row++)
 				{
+					double value = values[row];
+
 					if (std::isnan(value))
 						continue;
 
@@ -710,7 +770,124 @@ extern "C" bool STDCALL rbridge_setColumnAsNominalText(const char* columnName, c
 	return rbridge_setColumnDataAsNominalTextEngine(colName, nominals);
 }
 
-extern "C" int	STDCALL rbridge_dataSetRowCount()
+static RBridgeDescriptives*	descriptivesStatic		= nullptr;
+static size_t				descriptivesGroupCount	= 0;
+
+///The text R shows for value of column, the label if it has one
+static std::string rbridge_valueText(const Column & column, int value)
+{
+	int row = column.getColumnType() == columnType::scale ? -1 : column.labels().getRowFromKey(value);
+
+	return row >= 0 ? (column.labels().begin() + row)->text() : std::to_string(value);
+}
+
+///Fills descriptivesStatic, anything that goes wrong is thrown
+static void rbridge_summarizeColumn(const std::string & colName, const std::string & groupByColName, bool obeyFilter, const std::vector<double> & probs)
+{
+	bool grouped = groupByColName != "";
+
+	//Everything is computed on the versions we pinned, straight from shared memory, so nothing but the summaries is copied for R
+	DataSetVersions::ReadLock	readLock(rbridge_dataSet->versions().mutex());
+	DataSetVersions::Epoch		epoch = rbridge_dataSetEpochSource();
+
+	const Column		&	column		= rbridge_dataSet->columnVersion(colName, epoch);
+	const Column		*	groupBy		= grouped ? &rbridge_dataSet->columnVersion(groupByColName, epoch) : nullptr;
+	const FilterBitmap	*	filter		= obeyFilter ? &rbridge_dataSet->filter() : nullptr;
+
+	ColumnDescriptives::GroupedSummaries summaries;
+
+	if(grouped)	summaries			= ColumnDescriptives::summarizeGrouped(column, *groupBy, filter, probs);
+	else		summaries[INT_MIN]	= ColumnDescriptives::summarize(column, filter, probs);
+
+	descriptivesGroupCount	= summaries.size();
+	descriptivesStatic		= static_cast<RBridgeDescriptives*>(calloc(descriptivesGroupCount + 1, sizeof(RBridgeDescriptives)));
+
+	size_t groupNo = 0;
+	for(const auto & groupSummary : summaries)
+	{
+		const ColumnDescriptives::Summary	&	summary = groupSummary.second;
+		RBridgeDescriptives					&	result	= descriptivesStatic[groupNo++];
+
+		result.group			= grouped && groupSummary.first != INT_MIN ? strdup(rbridge_valueText(*groupBy, groupSummary.first).c_str()) : nullptr;
+		result.count			= summary.count;
+		result.missing			= summary.missing;
+		result.mean				= summary.mean;
+		result.variance			= summary.variance;
+		result.min				= summary.min;
+		result.max				= summary.max;
+		result.quantiles		= static_cast<double*>(calloc(probs.size() + 1, sizeof(double)));
+		result.nbFrequencies	= summary.frequencies.size();
+		result.frequencyLabels	= static_cast<char**>(calloc(result.nbFrequencies + 1, sizeof(char*)));
+		result.frequencies		= static_cast<int*>(calloc(result.nbFrequencies + 1, sizeof(int)));
+
+		std::copy(summary.quantiles.begin(), summary.quantiles.end(), result.quantiles);
+
+		size_t freqNo = 0;
+		for(const auto & frequency : summary.frequencies)
+		{
+			result.frequencyLabels[freqNo]	= strdup(rbridge_valueText(column, frequency.first).c_str());
+			result.frequencies[freqNo++]	= int(frequency.second);
+		}
+	}
+}
+
+extern "C" RBridgeDescriptives* STDCALL rbridge_readColumnDescriptives(const char * columnName, const char * groupByName, bool obeyFilter, const double * probabilities, size_t nbProbabilities, size_t * nbGroups)
+{
+	JASP_COLUMN_DECODE_HERE;
+
+	bool		grouped = groupByName != nullptr && groupByName[0] != '\0';
+#ifdef JASP_COLUMN_ENCODE_ALL
+	std::string	groupByColName(grouped ? ColumnEncoder::columnEncoder()->decode(groupByName) : "");
+#else
+	std::string	groupByColName(grouped ? groupByName : "");
+#endif
+
+	freeRBridgeDescriptives();
+	*nbGroups = 0;
+
+	rbridge_dataSet = rbridge_dataSetSource();
+
+	if(rbridge_dataSet == nullptr)
+		return nullptr;
+
+	try
+	{
+		rbridge_summarizeColumn(colName, groupByColName, obeyFilter, std::vector<double>(probabilities, probabilities + nbProbabilities));
+	}
+	catch(std::exception & e) //Nothing may get thrown through R, it gets nullptr instead and says so itself
+	{
+		Log::log() << "rbridge_readColumnDescriptives of column '" << colName << "' failed: " << e.what() << std::endl;
+		freeRBridgeDescriptives();
+		return nullptr;
+	}
+
+	*nbGroups = descriptivesGroupCount;
+
+	return descriptivesStatic;
+}
+
+void freeRBridgeDescriptives()
+{
+	if(descriptivesStatic == nullptr)
+		return;
+
+	for(size_t i = 0; i < descriptivesGroupCount; i++)
+	{
+		RBridgeDescriptives & descriptives = descriptivesStatic[i];
+
+		free(descriptives.group);
+		free(descriptives.quantiles);
+		free(descriptives.frequencies);
+		freeLabels(descriptives.frequencyLabels, descriptives.nbFrequencies);
+	}
+
+	free(descriptivesStatic);
+
+	descriptivesStatic		= nullptr;
+	descriptivesGroupCount	= 0;
+}
+
+extern "C" size_t	STDCALL rbridge_dataSetRowCount()
 {
 	return rbridge_getDataSetRowCount();
 }
@@ -811,7 +988,7 @@ std::string	rbridge_encodeColumnNamesInScript(const std::string & filterCode)
 	return ColumnEncoder::columnEncoder()->encodeRScript(filterCode, &filterColumnsUsed);
 }
 
-void rbridge_setupRCodeEnv(int rowCount, const std::string & dataname)
+void rbridge_setupRCodeEnv(size_t rowCount, const std::string & dataname)
 {
 	static std::string setupFilterEnv;
 
@@ -846,7 +1023,7 @@ std::vector<bool> rbridge_applyFilter(const std::string & filterCode, const std:
 	if(rbridge_dataSet == nullptr)
 		throw filterException("No more data!");
 
-	int rowCount = rbridge_dataSet->rowCount();
+	size_t rowCount = rbridge_dataSet->rowCount();
 
 	if(filterCode == "*" || filterCode == "") //if * then there is no filter so everything is fine :)
 		return std::vector<bool>(rowCount, true);
@@ -877,7 +1054,7 @@ std::vector<bool> rbridge_applyFilter(const std::string & filterCode, const std:
 	std::vector<bool> returnThis;
 
 	bool atLeastOneRow = false;
-	if(arrayLength == rowCount) //Only build boolvector if it matches the desired length.
+	if(size_t(arrayLength) == rowCount) //Only build boolvector if it matches the desired length.
 		for(int i=0; i<arrayLength; i++)
 		{
 			returnThis.push_back(arrayPointer[i]);
@@ -890,7 +1067,7 @@ std::vector<bool> rbridge_applyFilter(const std::string & filterCode, const std:
 	if(!atLeastOneRow)
 		throw filterException("Filtered out all data..");
 
-	if(arrayLength != rowCount)
+	if(size_t(arrayLength) != rowCount)
 	{
 		std::stringstream msg;
 		msg << "Filter did not return a logical vector of length " << rowCount << " as expected, instead it returned a logical vector of length " << arrayLength << std::endl;
@@ -904,7 +1081,7 @@ std::vector<bool> rbridge_applyFilter(const std::string & filterCode, const std:
 std::string rbridge_evalRCodeWhiteListed(const std::string & rCode)
 {
 	rbridge_dataSet = rbridge_dataSetSource();
-	int rowCount	= rbridge_dataSet == nullptr ? 0 : rbridge_dataSet->rowCount();
+	size_t rowCount	= rbridge_dataSet == nullptr ? 0 : rbridge_dataSet->rowCount();
 
 	jaspRCPP_resetErrorMsg();
 
@@ -61,11 +61,12 @@ extern "C" {
 	bool						STDCALL rbridge_setColumnAsOrdinal		(const char* columnName, int *			ordinalData,	size_t length,	const char ** levels, size_t numLevels);
 	bool						STDCALL rbridge_setColumnAsNominal		(const char* columnName, int *			nominalData,	size_t length,	const char ** levels, size_t numLevels);
 	bool						STDCALL rbridge_setColumnAsNominalText	(const char* columnName, const char **	nominalData,	size_t length);
-	int							STDCALL rbridge_dataSetRowCount();
+	size_t						STDCALL rbridge_dataSetRowCount();
 	const char *				STDCALL rbridge_encodeColumnName(		const char * in);
 	const char *				STDCALL rbridge_decodeColumnName(		const char * in);
 	const char *				STDCALL rbridge_encodeAllColumnNames(	const char * in);
 	const char *				STDCALL rbridge_decodeAllColumnNames(	const char * in);
+	RBridgeDescriptives*		STDCALL rbridge_readColumnDescriptives(	const char * columnName, const char * groupByName, bool obeyFilter, const double * probabilities, size_t nbProbabilities, size_t * nbGroups);
 }
 
 	typedef boost::function<std::string (const std::string &, int progress)> RCallback;
@@ -78,6 +79,7 @@ extern "C" {
 	void rbridge_setStateFileSource(		boost::function<void(std::string &, std::string &)> source);
 	void rbridge_setJaspResultsFileSource(	boost::function<void(std::string &, std::string &)> source);
 	void rbridge_setDataSetSource(			boost::function<DataSet *()> source);
+	void rbridge_setDataSetEpochSource(		boost::function<DataSetVersions::Epoch()> source);
 
 	std::string rbridge_runModuleCall(const std::string &name, const std::string &title, const std::string &moduleCall, const std::string &dataKey, const std::string &options, const std::string &stateKey, const std::string &perform, int ppi, int analysisID, int analysisRevision, const std::string &imageBackground, bool developerMode);
 
@@ -86,18 +88,19 @@ extern "C" {
 													boost::function<bool(const std::string &,		std::vector<int>&,			const std::map<int, std::string>&)	> ordinalSource,
 													boost::function<bool(const std::string &,		std::vector<int>&,			const std::map<int, std::string>&)	> nominalSource,
 													boost::function<bool(const std::string &, const std::vector<std::string>&)										> nominalTextSource);
-	void rbridge_setGetDataSetRowCountSource(		boost::function<int()> source);
+	void rbridge_setGetDataSetRowCountSource(		boost::function<size_t()> source);
 
 	std::string rbridge_run(const std::string &name, const std::string &title, const std::string &rfile, bool &requiresInit, const std::string &dataKey, const std::string &options, const std::string &resultsMeta, const std::string &stateKey, int analysisID, int analysisRevision, const std::string &perform, int ppi, const std::string &imageBackground, RCallback callback, bool useJaspResults, bool developerMode);
 	std::string rbridge_check();
 
 	void	rbridge_setupRCodeEnvReadData(const std::string & dataname, const std::string & readFunction);
-	void	rbridge_setupRCodeEnv(int rowCount, const std::string & dataname = "data");
+	void	rbridge_setupRCodeEnv(size_t rowCount, const std::string & dataname = "data");
 	void	rbridge_detachRCodeEnv(				const std::string & dataname = "data");
 
 	void freeRBridgeColumns();
 	void freeRBridgeColumnDescription(RBridgeColumnDescription* columns, size_t colMax);
 	void freeLabels(char** labels, size_t nbLabels);
+	void freeRBridgeDescriptives();
 
 	std::vector<bool>	rbridge_applyFilter(					const std::string & filterCode, const std::string & generatedFilterCode);
 	std::string			rbridge_encodeColumnNamesInScript(		const std::string & filterCode);
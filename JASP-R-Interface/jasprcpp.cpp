@@ -18,6 +18,8 @@
 #include "jasprcpp.h"
 #include "jaspResults/src/jaspResults.h"
 #include <fstream>
+#include <sstream>
+#include <climits>
 #include "columnencoder.h"
 #include "boost/nowide/system.hpp"
 
@@ -53,6 +55,7 @@ SetColumnAsNominal				dataSetColumnAsNominal;
 SetColumnAsNominalText			dataSetColumnAsNominalText;
 
 DataSetRowCount					dataSetRowCount;
+ReadColumnDescriptivesCB		readColumnDescriptivesCB;
 
 EnDecodeDef						encodeColumnName,
 								decodeColumnName,
@@ -100,6 +103,7 @@ void STDCALL jaspRCPP_init(const char* buildYear, const char* version, RBridgeCa
 	encodeColumnName							= callbacks->encoder;
 	decodeColumnName							= callbacks->decoder;
 	dataSetRowCount								= callbacks->dataSetRowCount;
+	readColumnDescriptivesCB					= callbacks->readColumnDescriptivesCB;
 	runCallbackCB								= callbacks->runCallbackCB;
 	readDataSetCB								= callbacks->readDataSetCB;
 
@@ -136,6 +140,7 @@ void STDCALL jaspRCPP_init(const char* buildYear, const char* version, RBridgeCa
 	rInside[".requestStateFileNameNative"]		= Rcpp::InternalFunction(&jaspRCPP_requestStateFileNameSEXP);
 	rInside[".readFullFilteredDatasetToEnd"]	= Rcpp::InternalFunction(&jaspRCPP_readFullFilteredDataSet);
 	rInside[".requestSpecificFileNameNative"]	= Rcpp::InternalFunction(&jaspRCPP_requestSpecificFileNameSEXP);
+	rInside[".readColumnDescriptivesNative"]	= Rcpp::InternalFunction(&jaspRCPP_readColumnDescriptivesSEXP);
 
 	rInside.parseEvalQNT(".outputSink <- .createCaptureConnection(); sink(.outputSink); print('.outputSink initialized!'); sink();");
 
@@ -651,9 +656,9 @@ void jaspRCPP_setLog(SEXP Message)
 	lastErrorMessage = Rcpp::as<std::string>(Message);
 }
 
-int jaspRCPP_dataSetRowCount()
+double jaspRCPP_dataSetRowCount()
 {
-	return dataSetRowCount();
+	return double(dataSetRowCount());
 }
 
 columnType jaspRCPP_getColumnType(std::string columnName)
@@ -959,6 +964,9 @@ Rcpp::DataFrame jaspRCPP_readDataSetSEXP(SEXP columns, SEXP columnsAsNumeric, SE
 
 Rcpp::DataFrame jaspRCPP_convertRBridgeColumns_to_DataFrame(const RBridgeColumn* colResults, size_t colMax)
 {
+	if (colResults && colResults[colMax].nbRows > INT_MAX)
+		Rf_error(("The data has " + std::to_string(colResults[colMax].nbRows) + " rows but an R data.frame can hold at most " + std::to_string(INT_MAX) + ", filter the data to analyse it.").c_str());
+
 	Rcpp::DataFrame dataFrame = Rcpp::DataFrame();
 
 	if (colResults)
@@ -1020,6 +1028,65 @@ Rcpp::DataFrame jaspRCPP_readDataSetHeaderSEXP(SEXP columns, SEXP columnsAsNumer
 
 }
 
+Rcpp::List jaspRCPP_readColumnDescriptivesSEXP(SEXP column, SEXP groupBy, SEXP obeyFilter, SEXP probabilities)
+{
+	std::string			columnName	= Rcpp::as<std::string>(column),
+						groupByName	= Rf_isNull(groupBy) ? "" : Rcpp::as<std::string>(groupBy);
+	std::vector<double>	probs		= Rf_isNull(probabilities) ? std::vector<double>() : Rcpp::as<std::vector<double>>(probabilities);
+	size_t				nbGroups	= 0;
+
+	RBridgeDescriptives * groups = readColumnDescriptivesCB(columnName.c_str(), groupByName.c_str(), Rcpp::as<bool>(obeyFilter), probs.data(), probs.size(), &nbGroups);
+
+	if(groups == nullptr)
+		Rcpp::stop("Descriptives of column '" + columnName + "' could not be read, see the log of the engine for why."); //Not Rf_error, that would jump over the destructors here
+
+	Rcpp::CharacterVector	quantileNames(probs.size());
+	for (size_t i = 0; i < probs.size(); i++)
+	{
+		std::stringstream name;
+		name << probs[i] * 100 << "%"; //Like the names quantile() gives them
+		quantileNames[i] = name.str();
+	}
+
+	Rcpp::List				summaries(nbGroups);
+	Rcpp::CharacterVector	groupNames(nbGroups);
+
+	for (size_t g = 0; g < nbGroups; g++)
+	{
+		RBridgeDescriptives & group = groups[g];
+
+		Rcpp::NumericVector quantiles(group.quantiles, group.quantiles + probs.size());
+		quantiles.attr("names") = quantileNames;
+
+		Rcpp::IntegerVector		frequencies(group.frequencies, group.frequencies + group.nbFrequencies);
+		Rcpp::CharacterVector	frequencyNames(group.nbFrequencies);
+
+		for (size_t i = 0; i < group.nbFrequencies; i++)
+			frequencyNames[i] = CSTRING_TO_R_CHARSXP(group.frequencyLabels[i]);
+
+		frequencies.attr("names") = frequencyNames;
+
+		summaries[g] = Rcpp::List::create(
+			Rcpp::_["count"]		= double(group.count),
+			Rcpp::_["missing"]		= double(group.missing),
+			Rcpp::_["mean"]			= group.mean,
+			Rcpp::_["variance"]		= group.variance,
+			Rcpp::_["min"]			= group.min,
+			Rcpp::_["max"]			= group.max,
+			Rcpp::_["quantiles"]	= quantiles,
+			Rcpp::_["frequencies"]	= frequencies);
+
+		if (group.group)	groupNames[g] = CSTRING_TO_R_CHARSXP(group.group);
+		else				groupNames[g] = NA_STRING;
+	}
+
+	if (groupByName == "")
+		return nbGroups == 0 ? Rcpp::List() : Rcpp::as<Rcpp::List>(summaries[0]);
+
+	summaries.attr("names") = groupNames;
+	return summaries;
+}
+
 Rcpp::IntegerVector jaspRCPP_makeFactor(Rcpp::IntegerVector v, char** levels, int nbLevels, bool ordinal)
 {
 /*#ifdef JASP_DEBUG
@@ -29,6 +29,7 @@ Rcpp::DataFrame jaspRCPP_readFullFilteredDataSet();
 Rcpp::DataFrame jaspRCPP_readFilterDataSet();
 Rcpp::DataFrame jaspRCPP_readDataSetSEXP(		SEXP columns, SEXP columnsAsNumeric, SEXP columnsAsOrdinal, SEXP columnsAsNominal, SEXP allColumns);
 Rcpp::DataFrame jaspRCPP_readDataSetHeaderSEXP(	SEXP columns, SEXP columnsAsNumeric, SEXP columnsAsOrdinal, SEXP columnsAsNominal, SEXP allColumns);
+Rcpp::List jaspRCPP_readColumnDescriptivesSEXP(SEXP column, SEXP groupBy, SEXP obeyFilter, SEXP probabilities);
 Rcpp::DataFrame jaspRCPP_convertRBridgeColumns_to_DataFrame(const RBridgeColumn* colResults, size_t colMax);
 
 SEXP jaspRCPP_callbackSEXP(SEXP results, SEXP progress);
@@ -59,7 +60,7 @@ std::string jaspRCPP_encodeAllColumnNames(	std::string in);
 std::string jaspRCPP_decodeAllColumnNames(	std::string in);
 
 
-int jaspRCPP_dataSetRowCount();
+double jaspRCPP_dataSetRowCount(); ///< A double because R integers stop at INT_MAX
 
 bool jaspRCPP_columnIsScale(				std::string columnName	);
 bool jaspRCPP_columnIsOrdinal(				std::string columnName		  );
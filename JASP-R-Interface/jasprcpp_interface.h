@@ -66,6 +66,20 @@ struct RBridgeColumnType {
 	int		type;
 };
 
+struct RBridgeDescriptives {
+	char*	group;			// Label of the group, nullptr when not grouped or for the rows where the group is missing
+	size_t	count;
+	size_t	missing;
+	double	mean;
+	double	variance;
+	double	min;
+	double	max;
+	double*	quantiles;		// One per probability asked for
+	char**	frequencyLabels;
+	int*	frequencies;
+	size_t	nbFrequencies;
+};
+
 // Callbacks from jaspRCPP to rbridge
 typedef RBridgeColumn*				(STDCALL *ReadDataSetCB)                (RBridgeColumnType* columns, size_t colMax, bool obeyFilter);
 typedef RBridgeColumn*				(STDCALL *ReadADataSetCB)               (size_t * colMax);
@@ -80,7 +94,8 @@ typedef bool						(STDCALL *SetColumnAsScale)             (const char* columnNam
 typedef bool						(STDCALL *SetColumnAsOrdinal)           (const char* columnName, int *          ordinalData,	size_t length, const char ** levels, size_t numLevels);
 typedef bool						(STDCALL *SetColumnAsNominal)           (const char* columnName, int *          nominalData,	size_t length, const char ** levels, size_t numLevels);
 typedef bool						(STDCALL *SetColumnAsNominalText)       (const char* columnName, const char **	nominalData,	size_t length);
-typedef int							(STDCALL *DataSetRowCount)              ();
+typedef size_t						(STDCALL *DataSetRowCount)              ();
+typedef RBridgeDescriptives*		(STDCALL *ReadColumnDescriptivesCB)		(const char* columnName, const char* groupByName, bool obeyFilter, const double * probabilities, size_t nbProbabilities, size_t * nbGroups);
 typedef const char *				(STDCALL *EnDecodeDef)					(const char *);
 
 struct RBridgeCallBacks {
@@ -106,6 +121,7 @@ struct RBridgeCallBacks {
 									decoder,
 									encoderAll,
 									decoderAll;
+	ReadColumnDescriptivesCB		readColumnDescriptivesCB;
 };
 
 typedef void			(*sendFuncDef)			(const char *);
@@ -11,6 +11,8 @@ SUBDIRS += \
 
 unix: SUBDIRS += JASP-R-Interface
 
+jasp_benchmarks: SUBDIRS += JASP-Common/benchmarks/ipcmessagebench.pro
+
 JASP-Desktop.depends = JASP-Common
 JASP-Engine.depends = JASP-Common
 